@@ -28,18 +28,260 @@
 #include "cncnet4.h"
 #include "cncnet4_net.h"
 #include "cncnet4_globals.h"
+#include "cncnet4_probe.h"
 #include "rawfile.h"
 #include "ini.h"
 #include "debughandler.h"
 #include "asserthandler.h"
 
 #include <windows.h>
+#include <timeapi.h>
 #include <cstdio>
 #include <cstdio>
-#include <ctime>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
 #include <wsipx.h>
 
 
+/**
+ *  The host name lookup is performed on a worker thread as gethostbyname can
+ *  block for several seconds. Each attempt has its own context so an attempt
+ *  that times out can be abandoned while the lookup is still in progress, the
+ *  context is freed by whichever of the two threads releases it last.
+ *
+ *  The threads of abandoned attempts are kept so shutdown can wait for them
+ *  before Winsock is cleaned up.
+ */
+struct ResolveContextStruct
+{
+    char Host[256];
+    uint32_t Address;
+    volatile LONG IsResolved;
+    volatile LONG RefCount;
+};
+
+static CnCNet4::CnCNet4StateType State = CnCNet4::STATE_IDLE;
+static DWORD StateTime = 0;
+
+static ResolveContextStruct *ResolveContext = nullptr;
+static HANDLE ResolveThread = nullptr;
+static HANDLE AbandonedThreads[MAXIMUM_WAIT_OBJECTS-1];
+static int AbandonedThreadCount = 0;
+static unsigned ResolveAttempt = 0;
+static unsigned RetryWait = 0;
+
+static NetProbeClass Probe;
+static bool IsP2PActive = false;
+
+
+/**
+ *  How long shutdown waits for host name lookups still in progress (in milliseconds).
+ */
+#define CNCNET4_SHUTDOWN_WAIT   2000
+
+
+/**
+ *  Change the connection state.
+ */
+static void Set_State(CnCNet4::CnCNet4StateType state)
+{
+    State = state;
+    StateTime = timeGetTime();
+
+    DEBUG_INFO("%s\n", CnCNet4::Get_State_String());
+}
+
+
+/**
+ *  Release a reference to the lookup context.
+ */
+static void Release_Resolve_Context(ResolveContextStruct *context)
+{
+    if (InterlockedDecrement(&context->RefCount) == 0) {
+        delete context;
+    }
+}
+
+
+/**
+ *  The host name lookup worker thread entry point.
+ */
+static DWORD WINAPI Resolve_Thread(LPVOID param)
+{
+    ResolveContextStruct *context = (ResolveContextStruct *)param;
+
+    struct hostent *hent = ::gethostbyname(context->Host);
+    if (hent && hent->h_addrtype == AF_INET && hent->h_addr_list[0]) {
+        std::memcpy(&context->Address, hent->h_addr_list[0], sizeof(context->Address));
+        InterlockedExchange(&context->IsResolved, TRUE);
+    }
+
+    Release_Resolve_Context(context);
+
+    return 0;
+}
+
+
+/**
+ *  Start a host name lookup attempt.
+ */
+static void Start_Resolve()
+{
+    ResolveContext = new ResolveContextStruct;
+    std::strncpy(ResolveContext->Host, CnCNet4::Host, sizeof(ResolveContext->Host));
+    ResolveContext->Host[sizeof(ResolveContext->Host)-1] = '\0';
+    ResolveContext->Address = 0;
+    ResolveContext->IsResolved = FALSE;
+    ResolveContext->RefCount = 2;
+
+    ++ResolveAttempt;
+
+    ResolveThread = CreateThread(nullptr, 0, Resolve_Thread, ResolveContext, 0, nullptr);
+    if (!ResolveThread) {
+        DEV_DEBUG_WARNING("CnCNet4: Failed to create lookup thread, resolving on the main thread!\n");
+        Resolve_Thread(ResolveContext);
+    }
+
+    Set_State(CnCNet4::STATE_RESOLVING);
+}
+
+
+/**
+ *  Release the current lookup attempt, abandoning it if it is still running.
+ */
+static void Finish_Resolve()
+{
+    if (ResolveThread) {
+        if (WaitForSingleObject(ResolveThread, 0) != WAIT_OBJECT_0 && AbandonedThreadCount < (int)std::size(AbandonedThreads)) {
+            AbandonedThreads[AbandonedThreadCount++] = ResolveThread;
+        } else {
+            CloseHandle(ResolveThread);
+        }
+        ResolveThread = nullptr;
+    }
+    if (ResolveContext) {
+        Release_Resolve_Context(ResolveContext);
+        ResolveContext = nullptr;
+    }
+}
+
+
+/**
+ *  Handle a failed lookup attempt, backing off before the next attempt.
+ */
+static void Resolve_Failed()
+{
+    if (ResolveAttempt < CnCNet4::ResolveRetries) {
+        RetryWait = CnCNet4::RetryDelay << (ResolveAttempt-1);
+        Set_State(CnCNet4::STATE_RETRY_WAIT);
+        return;
+    }
+
+    /**
+     *  CnCNet4::IsEnabled is left set. The socket functions are hooked at
+     *  startup, turning CnCNet4 off now would pass the IPX addresses the game
+     *  uses straight to Winsock. Sends fail with a socket error instead.
+     */
+    Set_State(CnCNet4::STATE_FAILED);
+
+    DEBUG_WARNING("CnCNet4: Failed to find the server, network games will not be available!\n");
+}
+
+
+/**
+ *  Send the peer-to-peer test packet to the server.
+ */
+static void Send_Probe()
+{
+    uint8_t obuf[16];
+    NetWriterClass writer(obuf, sizeof(obuf));
+
+    writer.Write_Int8(CMD_TESTP2P);
+    writer.Write_Int32(Probe.Get_Token());
+    net_send(writer, &CnCNet4::Server);
+}
+
+
+/**
+ *  Reply to a keepalive packet from the server.
+ */
+static void Send_Ping_Reply(int32_t token, struct sockaddr_in *to)
+{
+    uint8_t obuf[16];
+    NetWriterClass writer(obuf, sizeof(obuf));
+
+    writer.Write_Int8(CMD_PING);
+    writer.Write_Int32(token);
+    net_send(writer, to);
+}
+
+
+/**
+ *  Handle a peer-to-peer test reply from the server.
+ */
+static void Probe_Reply(int32_t token)
+{
+    if (State != CnCNet4::STATE_PROBING || !Probe.Reply(token)) {
+        return;
+    }
+
+    DEBUG_INFO("CnCNet4: Peer-to-peer test passed.\n");
+    DEBUG_INFO("CnCNet4: Peer-to-peer is enabled.\n");
+    net_bind("0.0.0.0", 8054);
+
+    IsP2PActive = true;
+    Set_State(CnCNet4::STATE_READY);
+}
+
+
+/**
+ *  Read any packets waiting on the socket while the peer-to-peer test is in
+ *  progress. The game is not expected to be using the socket at this point,
+ *  so anything other than the test reply or a keepalive is discarded.
+ */
+static void Poll_Probe()
+{
+    fd_set rfds;
+    struct timeval tv;
+    struct sockaddr_in from;
+    uint8_t ibuf[NET_BUF_SIZE];
+
+    while (State == CnCNet4::STATE_PROBING) {
+
+        FD_ZERO(&rfds);
+        FD_SET(net_socket, &rfds);
+        tv.tv_sec = 0;
+        tv.tv_usec = 0;
+
+        if (select(net_socket + 1, &rfds, nullptr, nullptr, &tv) <= 0 || !FD_ISSET(net_socket, &rfds)) {
+            break;
+        }
+
+        int len = net_recv(ibuf, sizeof(ibuf), &from);
+        if (len <= 0) {
+            break;
+        }
+
+        if (from.sin_addr.s_addr != CnCNet4::Server.sin_addr.s_addr || from.sin_port != CnCNet4::Server.sin_port) {
+            continue;
+        }
+
+        NetServerPacketStruct packet;
+        if (!Net_Decode_Server_Packet(ibuf, len, packet)) {
+            continue;
+        }
+
+        if (packet.Command == CMD_TESTP2P) {
+            Probe_Reply(packet.Token);
+
+        } else if (packet.Command == CMD_PING) {
+            Send_Ping_Reply(packet.Token, &from);
+        }
+    }
+}
+
+
 /**
  *  Initialises the CnCNet4 system.
  */
@@ -58,6 +300,11 @@ bool __stdcall CnCNet4::Init()
         CnCNet4::Peer2Peer = ini.Get_Bool("CnCNet4", "P2P", CnCNet4::Peer2Peer);
         CnCNet4::UseUDP = ini.Get_Bool("CnCNet4", "UDP", CnCNet4::UseUDP);
         CnCNet4::Port = ini.Get_Int("CnCNet4", "Port", CnCNet4::Port);
+        CnCNet4::ResolveTimeout = ini.Get_Int("CnCNet4", "ResolveTimeout", CnCNet4::ResolveTimeout);
+        CnCNet4::ResolveRetries = ini.Get_Int("CnCNet4", "ResolveRetries", CnCNet4::ResolveRetries);
+        CnCNet4::RetryDelay = ini.Get_Int("CnCNet4", "RetryDelay", CnCNet4::RetryDelay);
+        CnCNet4::ProbeTimeout = ini.Get_Int("CnCNet4", "ProbeTimeout", CnCNet4::ProbeTimeout);
+        CnCNet4::ProbeInterval = ini.Get_Int("CnCNet4", "ProbeInterval", CnCNet4::ProbeInterval);
     }
 
     if (!CnCNet4::IsEnabled) {
@@ -80,7 +327,7 @@ bool __stdcall CnCNet4::Init()
         return false;
     }
 
-    int s = net_init();
+    net_init();
     net_opt_reuse();
 
     DEBUG_INFO("CnCNet4: Initialising...\n");
@@ -89,77 +336,183 @@ bool __stdcall CnCNet4::Init()
         CnCNet4::Port = 9001;
     }
 
+    CnCNet4::ResolveRetries = std::max<unsigned>(CnCNet4::ResolveRetries, 1);
+    CnCNet4::ProbeInterval = std::max<unsigned>(CnCNet4::ProbeInterval, 50);
+
     DEBUG_INFO("CnCNet4: Broadcasting to \"%s:%d\".\n", CnCNet4::Host, CnCNet4::Port);
 
     CnCNet4::IsDedicated = true;
 
-    if (!net_address(&CnCNet4::Server, CnCNet4::Host, CnCNet4::Port)) {
-        return false;
+    /**
+     *  Start looking up the server, the connection is completed by Process
+     *  so the game is not held up at launch by a slow or dead network.
+     */
+    ResolveAttempt = 0;
+    Start_Resolve();
+
+    return true;
+}
+
+
+
+/**
+ *  Shutdown the CnCNet4 system.
+ */
+void __stdcall CnCNet4::Shutdown()
+{
+    /**
+     *  Wait a short while for any lookups still in progress, gethostbyname
+     *  must not be running when Winsock is cleaned up. If they do not finish
+     *  in time the socket is left open rather than hanging the shutdown.
+     */
+    Finish_Resolve();
+
+    bool threads_finished = true;
+
+    if (AbandonedThreadCount > 0) {
+        DWORD result = WaitForMultipleObjects(AbandonedThreadCount, AbandonedThreads, TRUE, CNCNET4_SHUTDOWN_WAIT);
+        threads_finished = (result != WAIT_TIMEOUT && result != WAIT_FAILED);
+
+        for (int i = 0; i < AbandonedThreadCount; ++i) {
+            CloseHandle(AbandonedThreads[i]);
+        }
+        AbandonedThreadCount = 0;
     }
 
-    if (CnCNet4::Peer2Peer) {
+    Probe.Stop();
 
-        /**
-         *  Test P2P.
-         */
-        bool pass = false;
+    State = STATE_IDLE;
+    IsP2PActive = false;
+
+    if (!threads_finished) {
+        DEBUG_WARNING("CnCNet4: Host name lookup still running at shutdown, skipping Winsock cleanup!\n");
+        return;
+    }
 
-        fd_set rfds;
-        struct timeval tv;
-        struct sockaddr_in to;
-        struct sockaddr_in from;
-        int start = time(nullptr);
+    net_free();
+}
 
-        net_write_int8(CMD_TESTP2P);
-        net_write_int32(start);
 
-        while (time(nullptr) < start + 5) {
+/**
+ *  Advances the connection state machine, this must be called regularly
+ *  from the main thread until the connection is ready.
+ */
+void CnCNet4::Process()
+{
+    DWORD now = timeGetTime();
 
-            net_send_noflush(&to);
+    switch (State) {
 
-            FD_ZERO(&rfds);
-            FD_SET(s, &rfds);
-            tv.tv_sec = 1;
-            tv.tv_usec = 0;
+        case STATE_RESOLVING:
+        {
+            if (!ResolveThread || WaitForSingleObject(ResolveThread, 0) == WAIT_OBJECT_0) {
 
-            if (select(s + 1, &rfds, NULL, NULL, &tv) > -1) {
-                if (FD_ISSET(s, &rfds)) {
-                    net_recv(&from);
+                bool resolved = ResolveContext->IsResolved != FALSE;
+                uint32_t address = ResolveContext->Address;
 
-                    if (net_read_int8() == CMD_TESTP2P && net_read_int32() == start) {
-                        pass = true;
-                        break;
-                    }
+                Finish_Resolve();
+
+                if (!resolved) {
+                    DEBUG_ERROR("CnCNet4: gethostbyname failed!\n");
+                    Resolve_Failed();
+                    break;
+                }
+
+                net_address_ex(&Server, address, Port);
+
+                DEBUG_INFO("CnCNet4: Resolved \"%s\" to %s.\n", Host, inet_ntoa(Server.sin_addr));
+
+                if (Peer2Peer) {
+                    Probe.Start(now, (int32_t)now, ProbeInterval, ProbeTimeout);
+                    Set_State(STATE_PROBING);
+                } else {
+                    Set_State(STATE_READY);
                 }
+
+            } else if (now - StateTime >= ResolveTimeout) {
+                DEBUG_WARNING("CnCNet4: Timed out resolving \"%s\"!\n", Host);
+                Finish_Resolve();
+                Resolve_Failed();
             }
+            break;
         }
 
-        /**
-         *  Enable P2P if passed.
-         */
-        if (pass) {
-            DEBUG_INFO("CnCNet4: Peer-to-peer test passed.\n");
-            DEBUG_INFO("CnCNet4: Peer-to-peer is enabled.\n");
-            net_bind("0.0.0.0", 8054);
-
-        } else {
-            DEBUG_WARNING("CnCNet4: Peer-to-peer test failed!\n");
-            //return false;
+        case STATE_RETRY_WAIT:
+        {
+            if (now - StateTime >= RetryWait) {
+                Start_Resolve();
+            }
+            break;
         }
 
-    }
+        case STATE_PROBING:
+        {
+            Poll_Probe();
 
-    return true;
+            if (State != STATE_PROBING) {
+                break;
+            }
+
+            if (Probe.Result(now) == NetProbeClass::PROBE_TIMED_OUT) {
+                DEBUG_WARNING("CnCNet4: Peer-to-peer test failed!\n");
+                Set_State(STATE_READY);
+                break;
+            }
+
+            /**
+             *  Resend the test packet, backing off each time in case the
+             *  previous packets were lost.
+             */
+            if (Probe.Is_Send_Due(now)) {
+                Send_Probe();
+            }
+            break;
+        }
+
+        default:
+            break;
+    };
 }
 
 
+/**
+ *  Returns the current connection state.
+ */
+CnCNet4::CnCNet4StateType CnCNet4::Get_State()
+{
+    return State;
+}
+
 
 /**
- *  Shutdown the CnCNet4 system.
+ *  Returns a description of the current connection state.
  */
-void __stdcall CnCNet4::Shutdown()
+const char *CnCNet4::Get_State_String()
 {
-    net_free();
+    static char _buffer[128];
+
+    switch (State) {
+        case STATE_RESOLVING:
+            std::snprintf(_buffer, sizeof(_buffer), "CnCNet4: Looking up %s (attempt %u of %u)...", Host, ResolveAttempt, ResolveRetries);
+            break;
+        case STATE_RETRY_WAIT:
+            std::snprintf(_buffer, sizeof(_buffer), "CnCNet4: Lookup failed, retrying in %u ms...", RetryWait);
+            break;
+        case STATE_PROBING:
+            std::snprintf(_buffer, sizeof(_buffer), "CnCNet4: Testing peer-to-peer...");
+            break;
+        case STATE_READY:
+            std::snprintf(_buffer, sizeof(_buffer), "CnCNet4: Connected to %s (%s)", Host, IsP2PActive ? "P2P" : "Tunnel");
+            break;
+        case STATE_FAILED:
+            std::snprintf(_buffer, sizeof(_buffer), "CnCNet4: Unable to find %s", Host);
+            break;
+        default:
+            std::snprintf(_buffer, sizeof(_buffer), "CnCNet4: Disabled");
+            break;
+    };
+
+    return _buffer;
 }
 
 
@@ -200,23 +553,36 @@ int __stdcall CnCNet4::recvfrom(SOCKET s, char *buf, int len, int flags, struct
     if (s == net_socket) {
         int ret;
         struct sockaddr_in from_in;
+        uint8_t ibuf[NET_BUF_SIZE];
+
+        CnCNet4::Process();
 
-        ret = net_recv(&from_in);
+        ret = net_recv(ibuf, sizeof(ibuf), &from_in);
 
         if (ret > 0) {
 
+            const uint8_t *payload = ibuf;
+            uint32_t payload_length = ret;
+
             if (CnCNet4::IsDedicated) {
 
                 if (from_in.sin_addr.s_addr == CnCNet4::Server.sin_addr.s_addr && from_in.sin_port == CnCNet4::Server.sin_port) {
-                    uint8_t cmd = net_read_int8();
+                    NetServerPacketStruct packet;
+
+                    /**
+                     *  Discard packets that are too short for their command.
+                     *  #FIXME: returning 0 means disconnected
+                     */
+                    if (!Net_Decode_Server_Packet(ibuf, ret, packet)) {
+                        DEV_DEBUG_WARNING("CnCNet4: Discarded malformed packet from server!\n");
+                        return 0;
+                    }
 
                     /**
                      *  Handle keepalive packets from server, very special case.
                      */
-                    if (cmd == CMD_PING) {
-                        net_write_int8(CMD_PING);
-                        net_write_int32(net_read_int32());
-                        net_send(&from_in);
+                    if (packet.Command == CMD_PING) {
+                        Send_Ping_Reply(packet.Token, &from_in);
 
                         /**
                          *  #FIXME: returning 0 means disconnected
@@ -224,13 +590,25 @@ int __stdcall CnCNet4::recvfrom(SOCKET s, char *buf, int len, int flags, struct
                         return 0;
                     }
 
+                    /**
+                     *  Reply to the peer-to-peer test, in case it arrives
+                     *  while the game is reading from the socket.
+                     */
+                    if (packet.Command == CMD_TESTP2P) {
+                        Probe_Reply(packet.Token);
+                        return 0;
+                    }
+
                     /**
                      *  P2p flag.
                      */
-                    from_in.sin_zero[0] = cmd;
+                    from_in.sin_zero[0] = packet.Command;
 
-                    from_in.sin_addr.s_addr = net_read_int32();
-                    from_in.sin_port = net_read_int16();
+                    from_in.sin_addr.s_addr = packet.Address;
+                    from_in.sin_port = packet.Port;
+
+                    payload = packet.Payload;
+                    payload_length = packet.PayloadLength;
 
                 } else if (CnCNet4::Peer2Peer) {
                     /**
@@ -259,7 +637,8 @@ int __stdcall CnCNet4::recvfrom(SOCKET s, char *buf, int len, int flags, struct
                 in2ipx(&from_in, (struct sockaddr_ipx *)from);
             }
 
-            ret = net_read_data((void *)buf, len);
+            NetReaderClass reader(payload, payload_length);
+            ret = reader.Read_Data(buf, len > 0 ? len : 0);
         }
 
         return ret;
@@ -277,15 +656,39 @@ int __stdcall CnCNet4::sendto(SOCKET s, const char *buf, int len, int flags, con
 
     if (to->sa_family == AF_IPX) {
         struct sockaddr_in to_in;
+        uint8_t obuf[NET_BUF_SIZE];
+        NetWriterClass writer(obuf, sizeof(obuf));
+
+        if (len < 0) {
+            WSASetLastError(WSAEINVAL);
+            return SOCKET_ERROR;
+        }
+
+        /**
+         *  The server address is not known until the connection is ready, and
+         *  the socket is still in use by the peer-to-peer test. Until then the
+         *  packet is dropped, as if it was lost, so the game will resend it.
+         *  If the server could not be found, there is no network to send to.
+         */
+        if (CnCNet4::Get_State() != CnCNet4::STATE_READY) {
+            CnCNet4::Process();
+            if (CnCNet4::Get_State() == CnCNet4::STATE_FAILED) {
+                WSASetLastError(WSAENETDOWN);
+                return SOCKET_ERROR;
+            }
+            if (CnCNet4::Get_State() != CnCNet4::STATE_READY) {
+                return len;
+            }
+        }
 
         if (CnCNet4::IsDedicated) {
 
             if (is_ipx_broadcast((struct sockaddr_ipx *)to)) {
-                net_write_int8(CnCNet4::Peer2Peer ? 1 : 0);
-                net_write_int32(0xFFFFFFFF);
-                net_write_int16(0xFFFF);
-                net_write_data((void *)buf, len);
-                net_send(&CnCNet4::Server);
+                writer.Write_Int8(CnCNet4::Peer2Peer ? 1 : 0);
+                writer.Write_Int32(int32_t(0xFFFFFFFF));
+                writer.Write_Int16(int16_t(0xFFFF));
+                writer.Write_Data(buf, len);
+                net_send(writer, &CnCNet4::Server);
 
             } else {
 
@@ -295,33 +698,40 @@ int __stdcall CnCNet4::sendto(SOCKET s, const char *buf, int len, int flags, con
                  *  Use p2p only if both clients are in p2p mode.
                  */
                 if (to_in.sin_zero[0] && CnCNet4::Peer2Peer) {
-                    net_write_data((void *)buf, len);
-                    net_send(&to_in);
+                    writer.Write_Data(buf, len);
+                    net_send(writer, &to_in);
 
                 } else {
-                    net_write_int8(CnCNet4::Peer2Peer ? 1 : 0);
-                    net_write_int32(to_in.sin_addr.s_addr);
-                    net_write_int16(to_in.sin_port);
-                    net_write_data((void *)buf, len);
-                    net_send(&CnCNet4::Server);
+                    writer.Write_Int8(CnCNet4::Peer2Peer ? 1 : 0);
+                    writer.Write_Int32(to_in.sin_addr.s_addr);
+                    writer.Write_Int16(to_in.sin_port);
+                    writer.Write_Data(buf, len);
+                    net_send(writer, &CnCNet4::Server);
                 }
             }
 
+            /**
+             *  Packets too large for the buffer are not sent.
+             */
+            if (writer.Is_Error()) {
+                return SOCKET_ERROR;
+            }
+
             return len;
         }
 
         ipx2in((struct sockaddr_ipx *)to, &to_in);
-        net_write_data((void *)buf, len);
+        writer.Write_Data(buf, len);
 
         /**
          *  Check if it's a broadcast.
          */
         if (is_ipx_broadcast((struct sockaddr_ipx *)to)) {
-            net_send(&CnCNet4::Server);
-            return len;
+            net_send(writer, &CnCNet4::Server);
+            return writer.Is_Error() ? SOCKET_ERROR : len;
 
         } else {
-            return net_send(&to_in);
+            return net_send(writer, &to_in);
         }
     }
 
@@ -376,8 +786,10 @@ int __stdcall CnCNet4::closesocket(SOCKET s)
 
     if (s == net_socket) {
         if (CnCNet4::IsDedicated) {
-            net_write_int8(CMD_DISCONNECT);
-            net_send(&CnCNet4::Server);
+            uint8_t obuf[16];
+            NetWriterClass writer(obuf, sizeof(obuf));
+            writer.Write_Int8(CMD_DISCONNECT);
+            net_send(writer, &CnCNet4::Server);
         }
         return 0;
     }
@@ -33,9 +33,26 @@
 
 namespace CnCNet4 {
 
+/**
+ *  The state of the connection to the CnCNet4 server.
+ */
+typedef enum CnCNet4StateType
+{
+    STATE_IDLE,         // Not enabled, or not yet started.
+    STATE_RESOLVING,    // Waiting for the host name lookup.
+    STATE_RETRY_WAIT,   // Waiting before the next host name lookup attempt.
+    STATE_PROBING,      // Waiting for the peer-to-peer test reply.
+    STATE_READY,        // Connected, packets are routed through the server.
+    STATE_FAILED,       // The host name could not be resolved.
+} CnCNet4StateType;
+
 bool __stdcall Init();
 void __stdcall Shutdown();
 
+void Process();
+CnCNet4StateType Get_State();
+const char *Get_State_String();
+
 int __stdcall bind(SOCKET s, const struct sockaddr *name, int namelen);
 SOCKET __stdcall socket(int af, int type, int protocol);
 int __stdcall recvfrom(SOCKET s, char *buf, int len, int flags, struct sockaddr *from, int *fromlen);
@@ -53,3 +53,23 @@ bool CnCNet4::IsDedicated = false;
 bool CnCNet4::UseUDP = true;
 
 struct sockaddr_in CnCNet4::Server;
+
+/**
+ *  How long to wait for a host name lookup before giving up on the attempt,
+ *  and how many times to attempt the lookup (in milliseconds).
+ */
+unsigned CnCNet4::ResolveTimeout = 5000;
+unsigned CnCNet4::ResolveRetries = 3;
+
+/**
+ *  The delay before the first lookup retry, this doubles for each
+ *  further retry (in milliseconds).
+ */
+unsigned CnCNet4::RetryDelay = 1000;
+
+/**
+ *  How long to wait for the peer-to-peer test reply, and the delay before the
+ *  test packet is first resent, this doubles for each resend (in milliseconds).
+ */
+unsigned CnCNet4::ProbeTimeout = 5000;
+unsigned CnCNet4::ProbeInterval = 250;
@@ -43,6 +43,12 @@ extern bool UseUDP;
 
 extern struct sockaddr_in Server;
 
+extern unsigned ResolveTimeout;
+extern unsigned ResolveRetries;
+extern unsigned RetryDelay;
+extern unsigned ProbeTimeout;
+extern unsigned ProbeInterval;
+
 }; // namespace CnCNet4
 
 
@@ -36,11 +36,6 @@
 
 
 static struct sockaddr_in net_local;
-static uint8_t net_ibuf[NET_BUF_SIZE];
-static uint8_t net_obuf[NET_BUF_SIZE];
-static uint32_t net_ipos;
-static uint32_t net_ilen;
-static uint32_t net_opos;
 int net_socket = 0;
 
 
@@ -125,8 +120,6 @@ int net_init()
     WSAStartup(0x0101, &wsaData);
 
     net_socket = ::socket(AF_INET, SOCK_DGRAM, 0);
-    net_ipos = 0;
-    net_opos = 0;
     return net_socket;
 }
 
@@ -151,160 +144,23 @@ int net_bind(const char *ip, int port)
 }
 
 
-uint32_t net_read_size()
-{
-    return net_ilen - net_ipos;
-}
-
-
-int8_t net_read_int8()
-{
-    int8_t tmp;
-    if (net_ipos + 1 > net_ilen) {
-        return 0;
-    }
-    std::memcpy(&tmp, net_ibuf + net_ipos, 1);
-    net_ipos += 1;
-    return tmp;
-}
-
-
-int16_t net_read_int16()
-{
-    int16_t tmp;
-    if (net_ipos + 2 > net_ilen) {
-        return 0;
-    }
-    std::memcpy(&tmp, net_ibuf + net_ipos, 2);
-    net_ipos += 2;
-    return tmp;
-}
-
-
-int32_t net_read_int32()
-{
-    int32_t tmp;
-    if (net_ipos + 4 > net_ilen) {
-        return 0;
-    }
-    std::memcpy(&tmp, net_ibuf + net_ipos, 4);
-    net_ipos += 4;
-    return tmp;
-}
-
-
-int net_read_data(void *ptr, size_t len)
-{
-    if (net_ipos + len > net_ilen) {
-        len = net_ilen - net_ipos;
-    }
-
-    std::memcpy(ptr, net_ibuf + net_ipos, len);
-    net_ipos += len;
-    return len;
-}
-
-
-int net_read_string(char *str, size_t len)
-{
-    int i;
-    for (i = net_ipos; i < NET_BUF_SIZE; i++) {
-        if (net_ibuf[i] == '\0') {
-            break;
-        }
-    }
-
-    if (len > i - net_ipos) {
-        len = i - net_ipos;
-    }
-
-    std::memcpy(str, net_ibuf + net_ipos, len);
-    str[len] = '\0';
-    net_ipos += len + 1;
-    return 0;
-}
-
-
-int net_write_int8(int8_t d)
-{
-    ASSERT(net_opos + 1 <= NET_BUF_SIZE);
-    std::memcpy(net_obuf + net_opos, &d, 1);
-    net_opos += 1;
-    return 1;
-}
-
-
-int net_write_int16(int16_t d)
-{
-    ASSERT(net_opos + 2 <= NET_BUF_SIZE);
-    int16_t tmp = d;
-    std::memcpy(net_obuf + net_opos, &tmp, 2);
-    net_opos += 2;
-    return 1;
-}
-
-
-int net_write_int32(int32_t d)
-{
-    ASSERT(net_opos + 4 <= NET_BUF_SIZE);
-    int32_t tmp = d;
-    std::memcpy(net_obuf + net_opos, &tmp, 4);
-    net_opos += 4;
-    return 1;
-}
-
-
-int net_write_data(void *ptr, size_t len)
-{
-    ASSERT(net_opos + len <= NET_BUF_SIZE);
-    std::memcpy(net_obuf + net_opos, ptr, len);
-    net_opos += len;
-    return 1;
-}
-
-
-int net_write_string(char *str)
-{
-    ASSERT(net_opos + strlen(str) + 1 <= NET_BUF_SIZE);
-    std::memcpy(net_obuf + net_opos, str, strlen(str) + 1);
-    net_opos += strlen(str) + 1;
-    return 1;
-}
-
-
-int net_write_string_int32(int32_t d)
-{
-    char str[32];
-    std::snprintf(str, sizeof(str), "%d", d);
-    return net_write_string(str);
-}
-
-
-int net_recv(struct sockaddr_in *src)
+int net_recv(void *buffer, int size, struct sockaddr_in *src)
 {
     socklen_t l = sizeof(struct sockaddr_in);
-    net_ipos = 0;
-    net_ilen = ::recvfrom(net_socket, (char *)net_ibuf, NET_BUF_SIZE, 0, (struct sockaddr *)src, &l);
-    return net_ilen;
-}
-
-
-int net_send(struct sockaddr_in *dst)
-{
-    int ret = net_send_noflush(dst);
-    net_send_discard();
-    return ret;
+    return ::recvfrom(net_socket, (char *)buffer, size, 0, (struct sockaddr *)src, &l);
 }
 
 
-int net_send_noflush(struct sockaddr_in *dst)
+/**
+ *  Sends the packet, packets that failed to be written in full are dropped.
+ */
+int net_send(const NetWriterClass &writer, struct sockaddr_in *dst)
 {
-    int ret = ::sendto(net_socket, (char *)net_obuf, net_opos, 0, (struct sockaddr *)dst, sizeof(struct sockaddr_in));
-    return ret;
-}
-
+    if (writer.Is_Error()) {
+        DEV_DEBUG_WARNING("CnCNet4: Dropped packet that exceeds the buffer size!\n");
+        WSASetLastError(WSAEMSGSIZE);
+        return SOCKET_ERROR;
+    }
 
-void net_send_discard()
-{
-    net_opos = 0;
+    return ::sendto(net_socket, (const char *)writer.Get_Buffer(), writer.Get_Length(), 0, (struct sockaddr *)dst, sizeof(struct sockaddr_in));
 }
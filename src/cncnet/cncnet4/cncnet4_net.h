@@ -31,21 +31,11 @@
 #include <windows.h>
 #include <wsipx.h>
 #include <stdint.h>
+#include "cncnet4_packet.h"
 
 
-#define NET_BUF_SIZE 2048
-
 typedef int socklen_t;
 
-enum {
-    CMD_TUNNEL,
-    CMD_P2P,
-    CMD_DISCONNECT,
-    CMD_PING,
-    CMD_QUERY,
-    CMD_TESTP2P
-};
-
 
 extern int net_socket;
 
@@ -64,21 +54,5 @@ void net_free();
 
 int net_bind(const char *ip, int port);
 
-uint32_t net_read_size();
-int8_t net_read_int8();
-int16_t net_read_int16();
-int32_t net_read_int32();
-int net_read_data(void *, size_t);
-int net_read_string(char *str, size_t len);
-
-int net_write_int8(int8_t);
-int net_write_int16(int16_t);
-int net_write_int32(int32_t);
-int net_write_data(void *, size_t);
-int net_write_string(char *str);
-int net_write_string_int32(int32_t);
-
-int net_recv(struct sockaddr_in *);
-int net_send(struct sockaddr_in *);
-int net_send_noflush(struct sockaddr_in *dst);
-void net_send_discard();
+int net_recv(void *buffer, int size, struct sockaddr_in *src);
+int net_send(const NetWriterClass &writer, struct sockaddr_in *dst);
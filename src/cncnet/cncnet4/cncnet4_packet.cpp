@@ -0,0 +1,222 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          CNCNET4_PACKET.CPP
+ *
+ *  @brief         Bounds checked packet reader and writer for the CnCNet4 protocol.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "cncnet4_packet.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+NetReaderClass::NetReaderClass(const void *buffer, uint32_t length) :
+    Buffer((const uint8_t *)buffer),
+    Length(buffer != nullptr ? length : 0),
+    Position(0),
+    IsError(false)
+{
+}
+
+
+bool NetReaderClass::Read(void *ptr, uint32_t len)
+{
+    if (IsError || len > Remaining()) {
+        IsError = true;
+        return false;
+    }
+
+    std::memcpy(ptr, Buffer + Position, len);
+    Position += len;
+    return true;
+}
+
+
+bool NetReaderClass::Read_Int8(int8_t &value)
+{
+    value = 0;
+    return Read(&value, sizeof(value));
+}
+
+
+bool NetReaderClass::Read_Int16(int16_t &value)
+{
+    value = 0;
+    return Read(&value, sizeof(value));
+}
+
+
+bool NetReaderClass::Read_Int32(int32_t &value)
+{
+    value = 0;
+    return Read(&value, sizeof(value));
+}
+
+
+/**
+ *  Reads up to len bytes, returning the number of bytes read.
+ */
+uint32_t NetReaderClass::Read_Data(void *ptr, uint32_t len)
+{
+    if (IsError) {
+        return 0;
+    }
+
+    if (len > Remaining()) {
+        len = Remaining();
+    }
+
+    std::memcpy(ptr, Buffer + Position, len);
+    Position += len;
+    return len;
+}
+
+
+/**
+ *  Reads a null terminated string. The terminator must be within the packet,
+ *  strings longer than the output buffer are truncated.
+ */
+bool NetReaderClass::Read_String(char *str, uint32_t size)
+{
+    if (IsError || size == 0) {
+        IsError = true;
+        return false;
+    }
+
+    const uint8_t *start = Buffer + Position;
+    const uint8_t *end = (const uint8_t *)std::memchr(start, '\0', Remaining());
+    if (!end) {
+        str[0] = '\0';
+        IsError = true;
+        return false;
+    }
+
+    uint32_t len = uint32_t(end - start);
+    uint32_t copy = (len < size) ? len : (size-1);
+
+    std::memcpy(str, start, copy);
+    str[copy] = '\0';
+    Position += len + 1;
+    return true;
+}
+
+
+NetWriterClass::NetWriterClass(void *buffer, uint32_t size) :
+    Buffer((uint8_t *)buffer),
+    Size(buffer != nullptr ? size : 0),
+    Length(0),
+    IsError(false)
+{
+}
+
+
+bool NetWriterClass::Write(const void *ptr, uint32_t len)
+{
+    if (IsError || len > Size - Length) {
+        IsError = true;
+        return false;
+    }
+
+    std::memcpy(Buffer + Length, ptr, len);
+    Length += len;
+    return true;
+}
+
+
+bool NetWriterClass::Write_Int8(int8_t value)
+{
+    return Write(&value, sizeof(value));
+}
+
+
+bool NetWriterClass::Write_Int16(int16_t value)
+{
+    return Write(&value, sizeof(value));
+}
+
+
+bool NetWriterClass::Write_Int32(int32_t value)
+{
+    return Write(&value, sizeof(value));
+}
+
+
+bool NetWriterClass::Write_Data(const void *ptr, uint32_t len)
+{
+    return Write(ptr, len);
+}
+
+
+bool NetWriterClass::Write_String(const char *str)
+{
+    return Write(str, uint32_t(std::strlen(str) + 1));
+}
+
+
+bool NetWriterClass::Write_String_Int32(int32_t value)
+{
+    char str[32];
+    std::snprintf(str, sizeof(str), "%d", value);
+    return Write_String(str);
+}
+
+
+/**
+ *  Decodes a packet received from the server.
+ * 
+ *  Keepalive and peer-to-peer test packets are the command followed by a
+ *  token. All other packets are tunnelled from another client, and carry the
+ *  address of the sender followed by the game data.
+ */
+bool Net_Decode_Server_Packet(const void *buffer, int length, NetServerPacketStruct &packet)
+{
+    std::memset(&packet, 0, sizeof(packet));
+
+    if (length <= 0) {
+        return false;
+    }
+
+    NetReaderClass reader(buffer, uint32_t(length));
+
+    int8_t cmd;
+    if (!reader.Read_Int8(cmd)) {
+        return false;
+    }
+    packet.Command = uint8_t(cmd);
+
+    if (packet.Command == CMD_PING || packet.Command == CMD_TESTP2P) {
+        return reader.Read_Int32(packet.Token);
+    }
+
+    int32_t address;
+    int16_t port;
+    if (!reader.Read_Int32(address) || !reader.Read_Int16(port)) {
+        return false;
+    }
+
+    packet.Address = uint32_t(address);
+    packet.Port = uint16_t(port);
+    packet.Payload = (const uint8_t *)buffer + reader.Get_Position();
+    packet.PayloadLength = reader.Remaining();
+
+    return true;
+}
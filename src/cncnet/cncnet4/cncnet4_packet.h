@@ -0,0 +1,141 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          CNCNET4_PACKET.H
+ *
+ *  @brief         Bounds checked packet reader and writer for the CnCNet4 protocol.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ *  This file has no dependency on Windows so it can also be built into
+ *  the host tools (see tools/netfuzz).
+ */
+
+#define NET_BUF_SIZE 2048
+
+enum {
+    CMD_TUNNEL,
+    CMD_P2P,
+    CMD_DISCONNECT,
+    CMD_PING,
+    CMD_QUERY,
+    CMD_TESTP2P
+};
+
+
+/**
+ *  Reads values from a received packet. Reads never go past the length of
+ *  the packet; a read that would is failed, and the reader stays in the
+ *  error state for all following reads.
+ */
+class NetReaderClass
+{
+    public:
+        NetReaderClass(const void *buffer, uint32_t length);
+
+        bool Read_Int8(int8_t &value);
+        bool Read_Int16(int16_t &value);
+        bool Read_Int32(int32_t &value);
+        uint32_t Read_Data(void *ptr, uint32_t len);
+        bool Read_String(char *str, uint32_t size);
+
+        uint32_t Remaining() const { return Length - Position; }
+        uint32_t Get_Position() const { return Position; }
+        bool Is_Error() const { return IsError; }
+
+    private:
+        bool Read(void *ptr, uint32_t len);
+
+    private:
+        const uint8_t *Buffer;
+        uint32_t Length;
+        uint32_t Position;
+        bool IsError;
+};
+
+
+/**
+ *  Writes values to a packet buffer. A write that does not fit is failed,
+ *  and the writer stays in the error state so the packet is never sent.
+ */
+class NetWriterClass
+{
+    public:
+        NetWriterClass(void *buffer, uint32_t size);
+
+        bool Write_Int8(int8_t value);
+        bool Write_Int16(int16_t value);
+        bool Write_Int32(int32_t value);
+        bool Write_Data(const void *ptr, uint32_t len);
+        bool Write_String(const char *str);
+        bool Write_String_Int32(int32_t value);
+
+        const uint8_t *Get_Buffer() const { return Buffer; }
+        uint32_t Get_Length() const { return Length; }
+        bool Is_Error() const { return IsError; }
+
+    private:
+        bool Write(const void *ptr, uint32_t len);
+
+    private:
+        uint8_t *Buffer;
+        uint32_t Size;
+        uint32_t Length;
+        bool IsError;
+};
+
+
+/**
+ *  A packet received from the server, decoded by Net_Decode_Server_Packet.
+ */
+struct NetServerPacketStruct
+{
+    /**
+     *  The command byte. For tunnelled packets this is the peer-to-peer
+     *  flag of the sender.
+     */
+    uint8_t Command;
+
+    /**
+     *  The token of a CMD_PING or CMD_TESTP2P packet.
+     */
+    int32_t Token;
+
+    /**
+     *  The address and port of the sender of a tunnelled packet, in
+     *  network byte order.
+     */
+    uint32_t Address;
+    uint16_t Port;
+
+    /**
+     *  The game data of a tunnelled packet.
+     */
+    const uint8_t *Payload;
+    uint32_t PayloadLength;
+};
+
+bool Net_Decode_Server_Packet(const void *buffer, int length, NetServerPacketStruct &packet);
@@ -0,0 +1,110 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          CNCNET4_PROBE.CPP
+ *
+ *  @brief         Scheduling of the CnCNet4 peer-to-peer test packets.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "cncnet4_probe.h"
+
+
+NetProbeClass::NetProbeClass() :
+    State(PROBE_IDLE),
+    Token(0),
+    StartTime(0),
+    NextSend(0),
+    Delay(0),
+    Timeout(0),
+    SendCount(0)
+{
+}
+
+
+/**
+ *  Start a new test, the first packet is due immediately.
+ */
+void NetProbeClass::Start(uint32_t now, int32_t token, unsigned interval, unsigned timeout)
+{
+    State = PROBE_WAITING;
+    Token = token;
+    StartTime = now;
+    NextSend = now;
+    Delay = interval > 0 ? interval : 1;
+    Timeout = timeout;
+    SendCount = 0;
+}
+
+
+void NetProbeClass::Stop()
+{
+    State = PROBE_IDLE;
+}
+
+
+/**
+ *  Returns true if the test packet should be sent now, and schedules the next
+ *  resend in case this packet or its reply is lost.
+ */
+bool NetProbeClass::Is_Send_Due(uint32_t now)
+{
+    if (Result(now) != PROBE_WAITING) {
+        return false;
+    }
+
+    if (int32_t(now - NextSend) < 0) {
+        return false;
+    }
+
+    NextSend = now + Delay;
+    Delay = (Delay * 2 < Timeout) ? Delay * 2 : Timeout;
+    ++SendCount;
+
+    return true;
+}
+
+
+/**
+ *  Handle a test reply. Replies to an earlier test, or arriving after the
+ *  test has finished, are ignored. Returns true if the reply passed the test.
+ */
+bool NetProbeClass::Reply(int32_t token)
+{
+    if (State != PROBE_WAITING || token != Token) {
+        return false;
+    }
+
+    State = PROBE_PASSED;
+    return true;
+}
+
+
+/**
+ *  Returns the result of the test, the test times out once the timeout has
+ *  passed without a reply.
+ */
+NetProbeClass::ProbeResultType NetProbeClass::Result(uint32_t now)
+{
+    if (State == PROBE_WAITING && now - StartTime >= Timeout) {
+        State = PROBE_TIMED_OUT;
+    }
+
+    return State;
+}
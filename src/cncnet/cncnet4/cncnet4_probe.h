@@ -0,0 +1,76 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          CNCNET4_PROBE.H
+ *
+ *  @brief         Scheduling of the CnCNet4 peer-to-peer test packets.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <stdint.h>
+
+
+/**
+ *  This file has no dependency on Windows so it can also be built into
+ *  the host tools (see tools/netprobetest).
+ */
+
+
+/**
+ *  Tracks the peer-to-peer test. The test packet is resent with a delay that
+ *  starts at the interval and doubles for each resend, up to the timeout. The
+ *  test passes when a reply with the current token arrives before the timeout.
+ *
+ *  Times are in milliseconds from any clock that wraps at 32 bits.
+ */
+class NetProbeClass
+{
+    public:
+        typedef enum ProbeResultType
+        {
+            PROBE_IDLE,
+            PROBE_WAITING,
+            PROBE_PASSED,
+            PROBE_TIMED_OUT,
+        } ProbeResultType;
+
+    public:
+        NetProbeClass();
+
+        void Start(uint32_t now, int32_t token, unsigned interval, unsigned timeout);
+        void Stop();
+
+        bool Is_Send_Due(uint32_t now);
+        bool Reply(int32_t token);
+        ProbeResultType Result(uint32_t now);
+
+        int32_t Get_Token() const { return Token; }
+        unsigned Get_Send_Count() const { return SendCount; }
+
+    private:
+        ProbeResultType State;
+        int32_t Token;
+        uint32_t StartTime;
+        uint32_t NextSend;
+        unsigned Delay;
+        unsigned Timeout;
+        unsigned SendCount;
+};
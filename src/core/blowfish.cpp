@@ -127,21 +127,7 @@ int BlowfishEngine::Encrypt(void const * plaintext, int length, void * cyphertex
     if (cyphertext == 0) cyphertext = (void *)plaintext;
 
     if (IsKeyed) {
-
-        int blocks = length / BYTES_PER_BLOCK;
-
-        for (int index = 0; index < blocks; index++) {
-            Process_Block(plaintext, cyphertext, P_Encrypt);
-            plaintext = ((char *)plaintext) + BYTES_PER_BLOCK;
-            cyphertext = ((char *)cyphertext) + BYTES_PER_BLOCK;
-        }
-        int encrypted = blocks * BYTES_PER_BLOCK;
-
-        if (encrypted < length) {
-            std::memmove(cyphertext, plaintext, length - encrypted);
-        }
-
-        return(encrypted);
+        return Process(plaintext, length, cyphertext, P_Encrypt);
     }
 
     if (plaintext != cyphertext) {
@@ -163,28 +149,48 @@ int BlowfishEngine::Decrypt(void const * cyphertext, int length, void * plaintex
     }
 
     if (IsKeyed) {
+        return Process(cyphertext, length, plaintext, P_Decrypt);
+    }
+
+    if (plaintext != cyphertext) {
+        std::memmove(plaintext, cyphertext, length);
+    }
 
-        int blocks = length / BYTES_PER_BLOCK;
+    return length;
+}
 
-        for (int index = 0; index < blocks; index++) {
-            Process_Block(cyphertext, plaintext, P_Decrypt);
-            cyphertext = ((char *)cyphertext) + BYTES_PER_BLOCK;
-            plaintext = ((char *)plaintext) + BYTES_PER_BLOCK;
-        }
-        int encrypted = blocks * BYTES_PER_BLOCK;
 
-        if (encrypted < length) {
-            std::memmove(plaintext, cyphertext, length - encrypted);
-        }
+/**
+ *  Runs all the whole blocks of the input through the cipher using the specified
+ *  P table, any trailing partial block is copied through unchanged.
+ * 
+ *  Blocks are independent of each other (ECB), so they are processed in batches
+ *  of BLOCKS_PER_BATCH where possible, with the remainder done one at a time.
+ */
+int BlowfishEngine::Process(void const * input, int length, void * output, unsigned long const * ptable)
+{
+    int blocks = length / BYTES_PER_BLOCK;
 
-        return encrypted;
+    int index = 0;
+    for (; index + BLOCKS_PER_BATCH <= blocks; index += BLOCKS_PER_BATCH) {
+        Process_Blocks(input, output, ptable);
+        input = ((char *)input) + (BYTES_PER_BLOCK * BLOCKS_PER_BATCH);
+        output = ((char *)output) + (BYTES_PER_BLOCK * BLOCKS_PER_BATCH);
     }
 
-    if (plaintext != cyphertext) {
-        std::memmove(plaintext, cyphertext, length);
+    for (; index < blocks; index++) {
+        Process_Block(input, output, ptable);
+        input = ((char *)input) + BYTES_PER_BLOCK;
+        output = ((char *)output) + BYTES_PER_BLOCK;
     }
 
-    return length;
+    int processed = blocks * BYTES_PER_BLOCK;
+
+    if (processed < length) {
+        std::memmove(output, input, length - processed);
+    }
+
+    return processed;
 }
 
 
@@ -226,6 +232,73 @@ void BlowfishEngine::Process_Block(void const * plaintext, void * cyphertext, un
 }
 
 
+/**
+ *  Processes BLOCKS_PER_BATCH consecutive blocks with their rounds interleaved.
+ *  The output is identical to calling Process_Block on each block in turn.
+ */
+void BlowfishEngine::Process_Blocks(void const * plaintext, void * cyphertext, unsigned long const * ptable)
+{
+    unsigned char const * source = (unsigned char const *)plaintext;
+
+    Int left[BLOCKS_PER_BATCH];
+    Int right[BLOCKS_PER_BATCH];
+
+    for (int block = 0; block < BLOCKS_PER_BATCH; block++) {
+        left[block].Char.C0 = *source++;
+        left[block].Char.C1 = *source++;
+        left[block].Char.C2 = *source++;
+        left[block].Char.C3 = *source++;
+
+        right[block].Char.C0 = *source++;
+        right[block].Char.C1 = *source++;
+        right[block].Char.C2 = *source++;
+        right[block].Char.C3 = *source++;
+    }
+
+    for (int index = 0; index < ROUNDS; index += 2) {
+        unsigned long p0 = ptable[index];
+        unsigned long p1 = ptable[index+1];
+
+        left[0].Long ^= p0;
+        left[1].Long ^= p0;
+        left[2].Long ^= p0;
+        left[3].Long ^= p0;
+
+        right[0].Long ^= ((( bf_S[0][left[0].Char.C0] + bf_S[1][left[0].Char.C1]) ^ bf_S[2][left[0].Char.C2]) + bf_S[3][left[0].Char.C3]);
+        right[1].Long ^= ((( bf_S[0][left[1].Char.C0] + bf_S[1][left[1].Char.C1]) ^ bf_S[2][left[1].Char.C2]) + bf_S[3][left[1].Char.C3]);
+        right[2].Long ^= ((( bf_S[0][left[2].Char.C0] + bf_S[1][left[2].Char.C1]) ^ bf_S[2][left[2].Char.C2]) + bf_S[3][left[2].Char.C3]);
+        right[3].Long ^= ((( bf_S[0][left[3].Char.C0] + bf_S[1][left[3].Char.C1]) ^ bf_S[2][left[3].Char.C2]) + bf_S[3][left[3].Char.C3]);
+
+        right[0].Long ^= p1;
+        right[1].Long ^= p1;
+        right[2].Long ^= p1;
+        right[3].Long ^= p1;
+
+        left[0].Long ^= ((( bf_S[0][right[0].Char.C0] + bf_S[1][right[0].Char.C1]) ^ bf_S[2][right[0].Char.C2]) + bf_S[3][right[0].Char.C3]);
+        left[1].Long ^= ((( bf_S[0][right[1].Char.C0] + bf_S[1][right[1].Char.C1]) ^ bf_S[2][right[1].Char.C2]) + bf_S[3][right[1].Char.C3]);
+        left[2].Long ^= ((( bf_S[0][right[2].Char.C0] + bf_S[1][right[2].Char.C1]) ^ bf_S[2][right[2].Char.C2]) + bf_S[3][right[2].Char.C3]);
+        left[3].Long ^= ((( bf_S[0][right[3].Char.C0] + bf_S[1][right[3].Char.C1]) ^ bf_S[2][right[3].Char.C2]) + bf_S[3][right[3].Char.C3]);
+    }
+
+    unsigned char * out = (unsigned char *)cyphertext;
+
+    for (int block = 0; block < BLOCKS_PER_BATCH; block++) {
+        left[block].Long ^= ptable[ROUNDS];
+        right[block].Long ^= ptable[ROUNDS+1];
+
+        *out++ = right[block].Char.C0;
+        *out++ = right[block].Char.C1;
+        *out++ = right[block].Char.C2;
+        *out++ = right[block].Char.C3;
+
+        *out++ = left[block].Char.C0;
+        *out++ = left[block].Char.C1;
+        *out++ = left[block].Char.C2;
+        *out++ = left[block].Char.C3;
+    }
+}
+
+
 void BlowfishEngine::Sub_Key_Encrypt(unsigned long & left, unsigned long & right)
 {
     Int l;
@@ -57,11 +57,20 @@ class BlowfishEngine
     private:
         enum {
             ROUNDS = 16,
-            BYTES_PER_BLOCK = 8
+            BYTES_PER_BLOCK = 8,
+
+            /**
+             *  The number of independent blocks processed together by Process_Blocks.
+             *  Interleaving the rounds of several blocks lets the S-box lookups of
+             *  one block overlap with those of the others.
+             */
+            BLOCKS_PER_BATCH = 4
         };
 
         void Sub_Key_Encrypt(unsigned long & left, unsigned long & right);
         void Process_Block(void const * plaintext, void * cyphertext, unsigned long const * ptable);
+        void Process_Blocks(void const * plaintext, void * cyphertext, unsigned long const * ptable);
+        int Process(void const * input, int length, void * output, unsigned long const * ptable);
 
     private:
         static unsigned long const P_Init[(int)ROUNDS+2];
@@ -78,15 +78,21 @@ int BlowPipe::Put(const void * source, int slen)
         }
     }
 
+    /**
+     *  Process the whole blocks in batches through a local buffer so the engine
+     *  can work on several blocks at once.
+     */
     while (slen >= sizeof(Buffer)) {
+        char batch[sizeof(Buffer) * 64];
+        int sublen = (slen < (int)sizeof(batch)) ? (slen - (slen % sizeof(Buffer))) : sizeof(batch);
         if (Control == DECRYPT) {
-            BF->Decrypt(source, sizeof(Buffer), Buffer);
+            BF->Decrypt(source, sublen, batch);
         } else {
-            BF->Encrypt(source, sizeof(Buffer), Buffer);
+            BF->Encrypt(source, sublen, batch);
         }
-        total += Pipe::Put(Buffer, sizeof(Buffer));
-        source = ((char *)source) + sizeof(Buffer);
-        slen -= sizeof(Buffer);
+        total += Pipe::Put(batch, sublen);
+        source = ((char *)source) + sublen;
+        slen -= sublen;
     }
 
     if (slen > 0) {
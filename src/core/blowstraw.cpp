@@ -60,6 +60,37 @@ int BlowStraw::Get(void * source, int slen)
         }
         if (slen == 0) break;
 
+        /**
+         *  If the request covers one or more whole blocks, fetch them straight
+         *  into the destination and process them in one go. This allows the
+         *  engine to work on several blocks at once instead of one at a time.
+         */
+        if (slen >= (int)sizeof(Buffer)) {
+            int wanted = slen - (slen % sizeof(Buffer));
+            int incount = Straw::Get(source, wanted);
+            if (incount == 0) break;
+
+            int whole = incount - (incount % sizeof(Buffer));
+            if (whole > 0) {
+                if (Control == DECRYPT) {
+                    BF->Decrypt(source, whole, source);
+                } else {
+                    BF->Encrypt(source, whole, source);
+                }
+            }
+
+            /**
+             *  A trailing partial block is passed through unprocessed, the same
+             *  as the block at a time path below does.
+             */
+            source = ((char *)source) + incount;
+            slen -= incount;
+            total += incount;
+
+            if (whole != incount) break;
+            continue;
+        }
+
         int incount = Straw::Get(Buffer, sizeof(Buffer));
         if (incount == 0) break;
 
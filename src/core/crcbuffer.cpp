@@ -0,0 +1,70 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          CRCBUFFER.CPP
+ *
+ *  @brief         Standard CRC-32 (IEEE 802.3) checksum.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "crcbuffer.h"
+
+
+/**
+ *  CRC-32 lookup table, generated on first use.
+ */
+static uint32_t CRC32Table[256];
+static bool CRC32TableReady = false;
+
+
+/**
+ *  Build the CRC-32 lookup table.
+ */
+static void Init_CRC32_Table()
+{
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int j = 0; j < 8; ++j) {
+            c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        }
+        CRC32Table[i] = c;
+    }
+    CRC32TableReady = true;
+}
+
+
+/**
+ *  Calculates the CRC-32 of the data. Pass the result of a previous call as
+ *  the initial value to continue a checksum over several buffers.
+ */
+uint32_t CRC32_Buffer(const void *data, int length, uint32_t crc)
+{
+    if (!CRC32TableReady) {
+        Init_CRC32_Table();
+    }
+
+    const unsigned char *ptr = static_cast<const unsigned char *>(data);
+
+    crc = ~crc;
+    while (length-- > 0) {
+        crc = CRC32Table[(crc ^ *ptr++) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
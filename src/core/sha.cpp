@@ -34,6 +34,8 @@
  ******************************************************************************/
 #include "sha.h"
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 
 void SHA::Process_Partial(void const * & data, long & length)
@@ -64,11 +66,11 @@ void SHA::Hash(void const * data, long length)
     if (length == 0) return;
 
     long blocks = (length / SRC_BLOCK_SIZE);
-    long const * source = (long const *)data;
+    char const * source = (char const *)data;
     for (int bcount = 0; bcount < blocks; bcount++) {
         Process_Block(source, Acc);
         Length += (long)SRC_BLOCK_SIZE;
-        source += SRC_BLOCK_SIZE/sizeof(long);
+        source += SRC_BLOCK_SIZE;
         length -= (long)SRC_BLOCK_SIZE;
     }
 
@@ -102,12 +104,13 @@ int SHA::Result(void * result) const
     }
 
     std::memset(&partial[partialcount], '\0', SRC_BLOCK_SIZE - partialcount);
-    *(long *)(&partial[SRC_BLOCK_SIZE-4]) = _byteswap_ulong((length*8));
+    uint32_t bits = _byteswap_ulong((uint32_t)(length*8));
+    std::memcpy(&partial[SRC_BLOCK_SIZE-4], &bits, sizeof(bits));
     Process_Block(&partial[0], acc);
 
     std::memcpy((char *)&FinalResult, &acc, sizeof(acc));
-    for (int index = 0; index < sizeof(FinalResult)/sizeof(long); index++) {
-        (long &)FinalResult.Long[index] = _byteswap_ulong(FinalResult.Long[index]);
+    for (int index = 0; index < int(sizeof(FinalResult)/sizeof(uint32_t)); index++) {
+        (uint32_t &)FinalResult.Long[index] = _byteswap_ulong(FinalResult.Long[index]);
     }
     (bool&)IsCached = true;
     std::memcpy(result, &FinalResult, sizeof(FinalResult));
@@ -118,28 +121,42 @@ int SHA::Result(void * result) const
 
 void SHA::Process_Block(void const * source, SHADigest & acc) const
 {
-    long block[PROC_BLOCK_SIZE/sizeof(long)];
-    long const * data = (long const *)source;
+    /**
+     *  The source may not be aligned, so it is copied before being read as words.
+     */
+    uint32_t block[PROC_BLOCK_SIZE/sizeof(uint32_t)];
+    std::memcpy(block, source, SRC_BLOCK_SIZE);
     int index;
-    for (index = 0; index < SRC_BLOCK_SIZE/sizeof(long); index++) {
-        block[index] = _byteswap_ulong(data[index]);
+    for (index = 0; index < int(SRC_BLOCK_SIZE/sizeof(uint32_t)); index++) {
+        block[index] = _byteswap_ulong(block[index]);
     }
 
-    for (index = SRC_BLOCK_SIZE/sizeof(long); index < PROC_BLOCK_SIZE/sizeof(long); index++) {
+    for (index = SRC_BLOCK_SIZE/sizeof(uint32_t); index < int(PROC_BLOCK_SIZE/sizeof(uint32_t)); index++) {
         block[index] = _rotl(block[index-3] ^ block[index-8] ^ block[index-14] ^ block[index-16], 1);
     }
 
-    SHADigest alt = acc;
-    for (index = 0; index < PROC_BLOCK_SIZE/sizeof(long); index++) {
-        long temp = _rotl(alt.Long[0], 5) +
-                        Do_Function(index, alt.Long[1], alt.Long[2], alt.Long[3]) +
-                        alt.Long[4] + block[index] + Get_Constant(index);
-        alt.Long[4] = alt.Long[3];
-        alt.Long[3] = alt.Long[2];
-        alt.Long[2] = _rotl(alt.Long[1], 30);
-        alt.Long[1] = alt.Long[0];
-        alt.Long[0] = temp;
+    /**
+     *  The round function and constant only change every 20 rounds, so the
+     *  rounds are split into four loops rather than selecting them per round.
+     */
+#define SHA_ROUND(func, constant) \
+    { \
+        uint32_t temp = _rotl(alt.Long[0], 5) + func(alt.Long[1], alt.Long[2], alt.Long[3]) + alt.Long[4] + block[index] + (uint32_t)constant; \
+        alt.Long[4] = alt.Long[3]; \
+        alt.Long[3] = alt.Long[2]; \
+        alt.Long[2] = _rotl(alt.Long[1], 30); \
+        alt.Long[1] = alt.Long[0]; \
+        alt.Long[0] = temp; \
     }
+
+    SHADigest alt = acc;
+    for (index = 0; index < 20; index++) SHA_ROUND(Function1, K1);
+    for (; index < 40; index++) SHA_ROUND(Function2, K2);
+    for (; index < 60; index++) SHA_ROUND(Function3, K3);
+    for (; index < 80; index++) SHA_ROUND(Function4, K4);
+
+#undef SHA_ROUND
+
     acc.Long[0] += alt.Long[0];
     acc.Long[1] += alt.Long[1];
     acc.Long[2] += alt.Long[2];
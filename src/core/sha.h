@@ -36,6 +36,7 @@
 
 #include "always.h"
 #include <new>
+#include <stdint.h>
 
 
 class SHA
@@ -66,7 +67,7 @@ class SHA
 
     private:
         typedef union {
-            unsigned long Long[5];
+            uint32_t Long[5];
             unsigned char Char[20];
         } SHADigest;
 
@@ -81,34 +82,34 @@ class SHA
             K2=0x6ed9eba1L,
             K3=0x8f1bbcdcL,
             K4=0xca62c1d6L,
-            SRC_BLOCK_SIZE=16*sizeof(long),
-            PROC_BLOCK_SIZE=80*sizeof(long)
+            SRC_BLOCK_SIZE=16*sizeof(uint32_t),
+            PROC_BLOCK_SIZE=80*sizeof(uint32_t)
         };
 
-        long Get_Constant(int index) const {
+        uint32_t Get_Constant(int index) const {
             if (index < 20) return K1;
             if (index < 40) return K2;
             if (index < 60) return K3;
             return K4;
         };
 
-        long Function1(long X, long Y, long Z) const {
+        uint32_t Function1(uint32_t X, uint32_t Y, uint32_t Z) const {
             return(Z ^ ( X & ( Y ^ Z ) ) );
         };
 
-        long Function2(long X, long Y, long Z) const {
+        uint32_t Function2(uint32_t X, uint32_t Y, uint32_t Z) const {
             return( X ^ Y ^ Z );
         };
 
-        long Function3(long X, long Y, long Z) const {
+        uint32_t Function3(uint32_t X, uint32_t Y, uint32_t Z) const {
             return( (X & Y) | (Z & (X | Y) ) );
         };
 
-        long Function4(long X, long Y, long Z) const {
+        uint32_t Function4(uint32_t X, uint32_t Y, uint32_t Z) const {
             return( X ^ Y ^ Z );
         };
 
-        long Do_Function(int index, long X, long Y, long Z) const {
+        uint32_t Do_Function(int index, uint32_t X, uint32_t Y, uint32_t Z) const {
             if (index < 20) return Function1(X, Y, Z);
             if (index < 40) return Function2(X, Y, Z);
             if (index < 60) return Function3(X, Y, Z);
@@ -36,11 +36,11 @@
 
 
 /**
- *  Redirect msize() to use HeapSize as we now control all memory allocations.
+ *  Redirect msize() to our allocator as we now control all memory allocations.
  */
 static unsigned int __cdecl vinifera_msize(void *ptr)
 {
-    return HeapSize(GetProcessHeap(), 0, ptr);
+    return vinifera_size(ptr);
 }
 
 
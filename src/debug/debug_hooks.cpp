@@ -529,11 +529,6 @@ static void Debug_Handler_Hooks()
      */
     Debug_Print_Patch();
 
-    /**
-     *  Skips the class size logging done at startup.
-     */
-    Patch_Jump(0x005FF81C, 0x005FFC41);
-
     /**
      *  
      */
@@ -110,6 +110,86 @@ static bool DebugHandler_DeveloperMode = false;
 
 static bool DebugHandler_NoConsole = false;
 
+/**
+ *  In-memory copy of the most recent log output, so the tail of the log can
+ *  be added to the debug bundle without reading the (possibly huge) log file.
+ */
+static char DebugLogRing[DEBUG_LOG_RING_SIZE];
+static int DebugLogRingPos = 0;
+static bool DebugLogRingWrapped = false;
+
+
+/**
+ *  Append the string to the in-memory log ring.
+ * 
+ *  @author: CCHyper
+ */
+static void Debug_Log_Ring_Write(const char *string)
+{
+    int len = (int)std::strlen(string);
+
+    /**
+     *  Only the end of a string larger than the ring can survive.
+     */
+    if (len > DEBUG_LOG_RING_SIZE) {
+        string += len - DEBUG_LOG_RING_SIZE;
+        len = DEBUG_LOG_RING_SIZE;
+    }
+
+    int first = DEBUG_LOG_RING_SIZE - DebugLogRingPos;
+    if (first > len) {
+        first = len;
+    }
+
+    std::memcpy(&DebugLogRing[DebugLogRingPos], string, first);
+    std::memcpy(&DebugLogRing[0], string + first, len - first);
+
+    DebugLogRingPos += len;
+    if (DebugLogRingPos >= DEBUG_LOG_RING_SIZE) {
+        DebugLogRingPos -= DEBUG_LOG_RING_SIZE;
+        DebugLogRingWrapped = true;
+    }
+}
+
+
+/**
+ *  Copies the most recent log output, oldest first, into the buffer. Returns
+ *  the number of bytes copied.
+ * 
+ *  @note: This does not take the log lock as it is used from the exception
+ *         handler, which may have been entered from within Vinifera_Printf.
+ * 
+ *  @author: CCHyper
+ */
+int Vinifera_Debug_Log_Tail(char *buffer, int buffer_size)
+{
+    if (!buffer || buffer_size <= 0) {
+        return 0;
+    }
+
+    int pos = DebugLogRingPos;
+    int available = DebugLogRingWrapped ? DEBUG_LOG_RING_SIZE : pos;
+    int size = (available < buffer_size) ? available : buffer_size;
+
+    /**
+     *  Start "size" bytes back from the write position.
+     */
+    int start = pos - size;
+    if (start < 0) {
+        start += DEBUG_LOG_RING_SIZE;
+    }
+
+    int first = DEBUG_LOG_RING_SIZE - start;
+    if (first > size) {
+        first = size;
+    }
+
+    std::memcpy(buffer, &DebugLogRing[start], first);
+    std::memcpy(buffer + first, &DebugLogRing[0], size - first);
+
+    return size;
+}
+
 
 void Vinifera_Output_Debug_String(const char *string)
 {
@@ -628,6 +708,8 @@ void Vinifera_Printf(DebugType type, const char *file, const char *function, int
      */
     if (write_to_file) {
 
+        Debug_Log_Ring_Write(filebuff);
+
         if (!DebugLogFileOpen) {
             DebugLogFile.open(DebugLogFilename, std::ios::app|std::ios::binary);
             DebugLogFileOpen = true;
@@ -131,6 +131,16 @@ void Vinifera_Output_Debug_String(const char *string);
  */
 void Vinifera_Escape_Percent_Sign(char *string, size_t buffer_length);
 
+/**
+ *  The amount of recent log output kept in memory for the debug bundle.
+ */
+#define DEBUG_LOG_RING_SIZE (1024 * 1024)
+
+/**
+ *  Copies the most recent log output into the buffer.
+ */
+int Vinifera_Debug_Log_Tail(char *buffer, int buffer_size);
+
 extern char CrashdumpFilename[PATH_MAX];
 
 extern bool DisableDebuggerOutput;
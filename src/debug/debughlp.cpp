@@ -27,6 +27,7 @@
  ******************************************************************************/
 #include "debughlp.h"
 #include "debughandler.h"
+#include "stackraw.h"
 
 
 /**
@@ -145,6 +146,12 @@ bool __cdecl Init_Symbol_Info()
 
     std::atexit(Uninit_Symbol_Info);
 
+    /**
+     *  Cache the module table for raw stack records now, while the process is
+     *  healthy. The crash handler refreshes it before it walks the stack.
+     */
+    Stack_Raw_Build_Module_Map();
+
     Init_DbgHelp();
 
     if (SymSetOptionsPtr != nullptr) {
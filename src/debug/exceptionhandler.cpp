@@ -27,6 +27,7 @@
  ******************************************************************************/
 #include "exceptionhandler.h"
 #include "stackdump.h"
+#include "stackraw.h"
 #include "minidump.h"
 #include "cpudetect.h"
 #include "buildnum.h"
@@ -400,6 +401,13 @@ static void Dump_Exception_Info(unsigned int e_code, struct _EXCEPTION_POINTERS
 
     int stack_skip_frames = 1; // #TODO: This needs checking. Value of 1 skips the EIP address, which seems ideal.
 
+    /**
+     *  Modules may have been loaded or unloaded since the module table for
+     *  the raw stack record was built at startup, so refresh it before the
+     *  stack is walked.
+     */
+    Stack_Raw_Build_Module_Map();
+
     Stack_Dump_From_Context(context->Eip, context->Esp, context->Ebp, Exception_Stack_Dump_Handler, stack_skip_frames);
 
     Exception_Printf("\r\n");
@@ -26,7 +26,9 @@
  *
  ******************************************************************************/
 #include "stackdump.h"
+#include "stackraw.h"
 #include "debughlp.h"
+#include "vinifera_globals.h"
 #include <Windows.h>
 #include <eh.h>
  
@@ -47,6 +49,21 @@
 static bool StripFilenamePaths = true;
 
 
+/**
+ *  The return addresses captured by the last stack walk.
+ */
+static uint32_t StackFrames[STACK_DEPTH_MAX];
+static int StackFrameCount = 0;
+
+
+extern int Execute_Day;
+extern int Execute_Month;
+extern int Execute_Year;
+extern int Execute_Hour;
+extern int Execute_Min;
+extern int Execute_Sec;
+
+
 static void Get_Function_Details(void *pointer, char *funcname, char *filename, unsigned *linenumber, uintptr_t *address)
 {
     char symbol_buffer[sizeof(IMAGEHLP_SYMBOL64) + STACK_SYMNAME_MAX];
@@ -180,6 +197,32 @@ static void Write_Stack_Line(void *address, stackcallback_ptr_t callback)
 }
 
 
+/**
+ *  Writes the addresses of the last stack walk to a raw stack record,
+ *  which can be symbolized offline with the module map files.
+ * 
+ *  Each dump in a session is numbered, so a later dump does not overwrite
+ *  the record of an earlier one.
+ */
+static void Write_Raw_Stack_Trace()
+{
+    static int _dump_count = 0;
+
+    char filename_buffer[PATH_MAX];
+
+    if (!StackFrameCount) {
+        return;
+    }
+
+    std::snprintf(filename_buffer, sizeof(filename_buffer), "%s\\STACK_%02u-%02u-%04u_%02u-%02u-%02u_%03d.BIN",
+        Vinifera_DebugDirectory,
+        Execute_Day, Execute_Month, Execute_Year, Execute_Hour, Execute_Min, Execute_Sec,
+        _dump_count++);
+
+    Stack_Raw_Write(filename_buffer, StackFrames, StackFrameCount);
+}
+
+
 void Make_Stack_Trace(register_t instructionptr, register_t stackptr, register_t frameptr, int skip_frames, stackcallback_ptr_t callback)
 {
     BOOL carry_on = true;
@@ -232,6 +275,8 @@ void Make_Stack_Trace(register_t instructionptr, register_t stackptr, register_t
         callback("Call Stack:\r\n");
     }
 
+    StackFrameCount = 0;
+
     /**
      *  Obtain a call stack trace.
      */
@@ -295,11 +340,24 @@ void Make_Stack_Trace(register_t instructionptr, register_t stackptr, register_t
                 }
 
                 if (carry_on) {
-                    Write_Stack_Line((void *)stack_frame.AddrPC.Offset, callback);
+                    StackFrames[StackFrameCount++] = (uint32_t)stack_frame.AddrPC.Offset;
                 }
             }
         }
     //}
+
+    /**
+     *  Write the raw addresses out before looking up any symbols, so the
+     *  trace survives even if the symbol engine fails in a damaged process.
+     */
+    Write_Raw_Stack_Trace();
+
+    /**
+     *  Now resolve the captured addresses to symbols.
+     */
+    for (int i = 0; i < StackFrameCount; ++i) {
+        Write_Stack_Line((void *)(uintptr_t)StackFrames[i], callback);
+    }
 }
 
 
@@ -0,0 +1,156 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          STACKRAW.CPP
+ *
+ *  @brief         Compact binary call stack records for offline symbolization.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "stackraw.h"
+#include <Windows.h>
+#include <tlhelp32.h>
+#include <cstring>
+
+
+/**
+ *  The cached table of modules loaded in the process.
+ */
+static StackRawModuleStruct ModuleMap[STACK_RAW_MODULES_MAX];
+static int ModuleMapCount = 0;
+static bool ModuleMapBuilt = false;
+
+
+/**
+ *  Read the link timestamp from the PE header of a loaded module.
+ */
+static uint32_t Get_Module_TimeStamp(const unsigned char *base)
+{
+    __try {
+        const IMAGE_DOS_HEADER *dos_header = reinterpret_cast<const IMAGE_DOS_HEADER *>(base);
+        if (dos_header->e_magic != IMAGE_DOS_SIGNATURE) {
+            return 0;
+        }
+
+        const IMAGE_NT_HEADERS *nt_header = reinterpret_cast<const IMAGE_NT_HEADERS *>(base + dos_header->e_lfanew);
+        if (nt_header->Signature != IMAGE_NT_SIGNATURE) {
+            return 0;
+        }
+
+        return nt_header->FileHeader.TimeDateStamp;
+
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        return 0;
+    }
+}
+
+
+/**
+ *  Build the table of modules loaded in the process.
+ *
+ *  This is done at startup, and again by the crash handler before it walks
+ *  the stack, so modules loaded or unloaded since startup are also mapped.
+ *  If the modules can not be enumerated, the previous table is kept.
+ */
+bool Stack_Raw_Build_Module_Map()
+{
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE, GetCurrentProcessId());
+    if (snapshot == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    MODULEENTRY32 entry;
+    entry.dwSize = sizeof(entry);
+
+    if (!Module32First(snapshot, &entry)) {
+        CloseHandle(snapshot);
+        return false;
+    }
+
+    ModuleMapCount = 0;
+
+    do {
+        StackRawModuleStruct &module = ModuleMap[ModuleMapCount++];
+
+        module.Base = (uint32_t)(uintptr_t)entry.modBaseAddr;
+        module.Size = (uint32_t)entry.modBaseSize;
+        module.TimeStamp = Get_Module_TimeStamp(entry.modBaseAddr);
+
+        std::strncpy(module.Name, entry.szModule, sizeof(module.Name));
+        module.Name[sizeof(module.Name)-1] = '\0';
+
+    } while (ModuleMapCount < STACK_RAW_MODULES_MAX && Module32Next(snapshot, &entry));
+
+    CloseHandle(snapshot);
+
+    ModuleMapBuilt = true;
+
+    return true;
+}
+
+
+/**
+ *  Write a raw stack record to file.
+ *
+ *  Only the return addresses and the module table are written, the addresses
+ *  are resolved to symbols afterwards. This avoids any symbol engine or heap
+ *  use, so it can be done before anything else in a crash handler.
+ */
+bool Stack_Raw_Write(const char *filename, const uint32_t *frames, int frame_count)
+{
+    if (!filename || !frames || frame_count <= 0) {
+        return false;
+    }
+
+    if (!ModuleMapBuilt) {
+        Stack_Raw_Build_Module_Map();
+    }
+
+    if (frame_count > STACK_RAW_FRAMES_MAX) {
+        frame_count = STACK_RAW_FRAMES_MAX;
+    }
+
+    HANDLE handle = CreateFileA(filename, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    StackRawHeaderStruct header;
+    header.Magic = STACK_RAW_MAGIC;
+    header.Version = STACK_RAW_VERSION;
+    header.ModuleCount = ModuleMapCount;
+    header.FrameCount = frame_count;
+
+    DWORD written = 0;
+    bool ok = WriteFile(handle, &header, sizeof(header), &written, nullptr) && written == sizeof(header);
+
+    if (ok && ModuleMapCount > 0) {
+        DWORD size = ModuleMapCount * sizeof(StackRawModuleStruct);
+        ok = WriteFile(handle, ModuleMap, size, &written, nullptr) && written == size;
+    }
+
+    if (ok) {
+        DWORD size = frame_count * sizeof(uint32_t);
+        ok = WriteFile(handle, frames, size, &written, nullptr) && written == size;
+    }
+
+    CloseHandle(handle);
+
+    return ok;
+}
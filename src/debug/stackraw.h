@@ -0,0 +1,74 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          STACKRAW.H
+ *
+ *  @brief         Compact binary call stack records for offline symbolization.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+/**
+ *  This header is shared with the standalone stack symbolizer tool, so the
+ *  record format must only depend on the standard fixed width types.
+ */
+#include <stdint.h>
+
+
+/**
+ *  A raw stack record file is laid out as follows;
+ *
+ *    StackRawHeaderStruct
+ *    StackRawModuleStruct[ModuleCount]
+ *    uint32_t[FrameCount]             (return addresses, innermost first)
+ *
+ *  All values are little endian.
+ */
+#define STACK_RAW_MAGIC             0x4B545356 // "VSTK"
+#define STACK_RAW_VERSION           1
+
+#define STACK_RAW_MODULE_NAME_MAX   64
+#define STACK_RAW_MODULES_MAX       256
+#define STACK_RAW_FRAMES_MAX        64
+
+
+#pragma pack(push, 1)
+struct StackRawHeaderStruct
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t ModuleCount;
+    uint32_t FrameCount;
+};
+
+struct StackRawModuleStruct
+{
+    uint32_t Base;
+    uint32_t Size;
+    uint32_t TimeStamp;     // TimeDateStamp from the PE header, to match the image to its symbols.
+    char Name[STACK_RAW_MODULE_NAME_MAX];
+};
+#pragma pack(pop)
+
+
+#ifdef _WIN32
+bool Stack_Raw_Build_Module_Map();
+bool Stack_Raw_Write(const char *filename, const uint32_t *frames, int frame_count);
+#endif
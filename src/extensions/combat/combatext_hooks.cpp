@@ -78,7 +78,7 @@ int Vinifera_Modify_Damage(int damage, WarheadTypeClass* warhead, ArmorType armo
         return 0;
     }
 
-    damage *= Verses::Get_Modifier(armor, warhead);
+    damage *= Verses::Get_Modifier(armor, WarheadType(warhead->Get_Heap_ID()));
 
     /**
      *	Vanilla used to enforce a minimum of 1 damage here.
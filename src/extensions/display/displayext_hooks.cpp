@@ -70,15 +70,21 @@ DECLARE_PATCH(_DisplayClass_Passes_Proximity_Passes_Check_Patch)
      */
     #define passes() _asm { mov byte ptr [esp+0x3C], 1 }
 
-    hptr = Houses[house];
-
     /**
      *  Stolen bytes/code.
      * 
      *  Ensure the building is considered eligible for adjacency checks.
      */
-    if (base->House->ID == house && base->Class->IsBase) {
-        passes();
+    if (base->House->ID == house) {
+        if (base->Class->IsBase) {
+            passes();
+        }
+
+        /**
+         *  Our own buildings can never pass the ally check, so there is
+         *  nothing more to do for this building.
+         */
+        goto continue_scan;
     }
 
     /**
@@ -86,15 +92,20 @@ DECLARE_PATCH(_DisplayClass_Passes_Proximity_Passes_Check_Patch)
      *  owned by an ally house and is eligible for adjacent building before
      *  passing the check.
      * 
+     *  The checks are ordered cheapest first as this runs for every building
+     *  around the placement footprint each time the cursor moves.
+     * 
      *  #NOTE: This feature is only available for multiplayer games.
      */
     if (Session.Type != GAME_NORMAL) {
         if (SessionExtension && SessionExtension->ExtOptions.IsBuildOffAlly) {
 
-            if (base->House != hptr && base->House->Is_Ally(hptr)) {
+            buildingtypeext = Extension::Fetch<BuildingTypeClassExtension>(base->Class);
+            if (buildingtypeext->IsEligibleForAllyBuilding) {
+
+                hptr = Houses[house];
 
-                buildingtypeext = Extension::Fetch<BuildingTypeClassExtension>(base->Class);
-                if (buildingtypeext->IsEligibleForAllyBuilding) {
+                if (base->House != hptr && base->House->Is_Ally(hptr)) {
 #ifndef NDEBUG
                     //DEV_DEBUG_INFO("Ally \"%s's\" building \"%s\" is eligible for building off.\n", base->House->IniName, base->Name());
 #endif
@@ -2149,7 +2149,7 @@ unsigned Extension::Get_Save_Version_Number()
     version += sizeof(ThemeControlExtension);
     version += sizeof(ArmorTypeClass);
     version += sizeof(RocketTypeClass);
-    version += sizeof(SpawnManagerClass);
+    version += sizeof(SpawnManagerClass) - sizeof(SpawnManagerClass::StatusCounts);   // The status counts are not saved.
     version += sizeof(KamikazeTrackerClass);
 
     return version;
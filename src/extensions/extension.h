@@ -161,19 +161,16 @@ namespace List
  *  @author: CCHyper
  */
 template<class BASE_CLASS, class EXT_CLASS>
-EXT_CLASS *Fetch(const BASE_CLASS *base, DynamicVectorClass<EXT_CLASS *> &list)
+EXT_CLASS *Fetch(const BASE_CLASS *base, const ExtensionListClass<EXT_CLASS> &list)
 {
     ASSERT(base != nullptr);
 
-    for (int index = 0; index < list.Count(); ++index) {
-        EXT_CLASS * ext = list[index];
-        if (list[index]->This() == base) {
-            EXT_DEBUG_INFO("Found \"%s\" extension.\n", Extension::Utility::Get_TypeID_Name<BASE_CLASS>().c_str());
-            return ext;
-        }
+    EXT_CLASS *ext = list.Find(base);
+    if (ext) {
+        EXT_DEBUG_INFO("Found \"%s\" extension.\n", Extension::Utility::Get_TypeID_Name<BASE_CLASS>().c_str());
     }
 
-    return nullptr;
+    return ext;
 }
 
 /**
@@ -182,7 +179,7 @@ EXT_CLASS *Fetch(const BASE_CLASS *base, DynamicVectorClass<EXT_CLASS *> &list)
  *  @author: CCHyper
  */
 template<class BASE_CLASS, class EXT_CLASS>
-EXT_CLASS *Make(const BASE_CLASS *base, DynamicVectorClass<EXT_CLASS *> &list)
+EXT_CLASS *Make(const BASE_CLASS *base, ExtensionListClass<EXT_CLASS> &list)
 {
     ASSERT(base != nullptr);
 
@@ -202,19 +199,18 @@ EXT_CLASS *Make(const BASE_CLASS *base, DynamicVectorClass<EXT_CLASS *> &list)
  *  @author: CCHyper
  */
 template<class BASE_CLASS, class EXT_CLASS>
-void Destroy(const BASE_CLASS *base, DynamicVectorClass<EXT_CLASS *> &list)
+void Destroy(const BASE_CLASS *base, ExtensionListClass<EXT_CLASS> &list)
 {
     ASSERT(base != nullptr);
 
-    for (int index = 0; index < list.Count(); ++index) {
-        EXT_CLASS * ext = list[index].This();
-        if (ext->This() == base) {
-            EXT_DEBUG_INFO("Found \"%s\" extension.\n", Extension::Utility::Get_TypeID_Name<BASE_CLASS>().c_str());
-            delete ext;
-            return;
-        }
+    EXT_CLASS *ext = list.Find(base);
+    if (!ext) {
+        return;
     }
 
+    list.Remove(ext);
+    delete ext;
+
     EXT_DEBUG_INFO("Destroyed \"%s\" extension.\n", Extension::Utility::Get_TypeID_Name<BASE_CLASS>().c_str());
 }
 
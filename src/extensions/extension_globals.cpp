@@ -69,4 +69,4 @@ SidebarClassExtension* SidebarExtension = nullptr;
 SessionClassExtension *SessionExtension = nullptr;
 OptionsClassExtension *OptionsExtension = nullptr;
 
-DynamicVectorClass<ThemeControlExtension *> ThemeControlExtensions;
+ExtensionListClass<ThemeControlExtension> ThemeControlExtensions;
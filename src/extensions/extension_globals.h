@@ -29,6 +29,7 @@
 
 #include "always.h"
 #include "vinifera_defines.h"
+#include "extension_list.h"
 #include "debughandler.h"
 #include "asserthandler.h"
 
@@ -153,4 +154,4 @@ extern OptionsClassExtension *OptionsExtension;
 /**
  *  Classes that require a list, but are not abstract derived.
  */
-extern DynamicVectorClass<ThemeControlExtension *> ThemeControlExtensions;
+extern ExtensionListClass<ThemeControlExtension> ThemeControlExtensions;
@@ -0,0 +1,276 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          EXTENSION_LIST.H
+ *
+ *  @brief         Extension list with constant time lookup by base object.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+#include "vector.h"
+#include "asserthandler.h"
+
+
+/**
+ *  A list of extension instances for classes that are not abstract derived,
+ *  and so have no extension pointer of their own to find the extension with.
+ * 
+ *  Alongside the list, a open addressing hash table maps the base object
+ *  pointer to its extension so fetching an extension does not need to search
+ *  the list. The table is kept in sync by Add and Remove, if the base object
+ *  pointers change (for example, after a load game remaps them) then Rebuild
+ *  must be called.
+ */
+template<class EXT_CLASS>
+class ExtensionListClass : public DynamicVectorClass<EXT_CLASS *>
+{
+    private:
+        struct SlotStruct
+        {
+            const void *Base;
+            EXT_CLASS *Extension;
+        };
+
+    public:
+        ExtensionListClass() : DynamicVectorClass<EXT_CLASS *>(), Table(nullptr), TableSize(0), TableCount(0) {}
+        ~ExtensionListClass() { delete [] Table; }
+
+        bool Add(EXT_CLASS *ext);
+        bool Remove(EXT_CLASS *ext);
+        void Clear();
+        void Rebuild();
+
+        EXT_CLASS *Find(const void *base) const;
+
+    private:
+        ExtensionListClass(const ExtensionListClass &) = delete;
+        ExtensionListClass &operator=(const ExtensionListClass &) = delete;
+
+        int Slot_Of(const void *base) const;
+        void Insert(const void *base, EXT_CLASS *ext);
+        void Resize(int size);
+
+        /**
+         *  Spreads the pointer bits over the table index, the low bits of a
+         *  pointer are mostly zero due to alignment.
+         */
+        unsigned Hash(const void *base) const { unsigned h = unsigned(uintptr_t(base)) * 2654435769U; return h ^ (h >> 15); }
+
+    private:
+        /**
+         *  The hash table, the size is always a power of two and the table is
+         *  kept at most half full so probe sequences stay short.
+         */
+        SlotStruct *Table;
+        int TableSize;
+        int TableCount;
+};
+
+
+/**
+ *  Add the extension to the list and the lookup table.
+ */
+template<class EXT_CLASS>
+bool ExtensionListClass<EXT_CLASS>::Add(EXT_CLASS *ext)
+{
+    ASSERT(ext != nullptr);
+
+    if (!DynamicVectorClass<EXT_CLASS *>::Add(ext)) {
+        return false;
+    }
+
+    if ((TableCount+1) * 2 > TableSize) {
+        Resize(TableSize > 0 ? TableSize * 2 : 64);
+    }
+
+    Insert(ext->This(), ext);
+
+    return true;
+}
+
+
+/**
+ *  Remove the extension from the list and the lookup table.
+ */
+template<class EXT_CLASS>
+bool ExtensionListClass<EXT_CLASS>::Remove(EXT_CLASS *ext)
+{
+    ASSERT(ext != nullptr);
+
+    if (!DynamicVectorClass<EXT_CLASS *>::Delete(ext)) {
+        return false;
+    }
+
+    int slot = Slot_Of(ext->This());
+    if (slot == -1 || Table[slot].Extension != ext) {
+        return true;
+    }
+
+    /**
+     *  Shift the following entries in the probe sequence back into the
+     *  gap, so lookups never need to step over deleted entries.
+     */
+    unsigned mask = TableSize-1;
+    unsigned hole = slot;
+    unsigned next = (hole + 1) & mask;
+
+    while (Table[next].Base != nullptr) {
+        unsigned home = Hash(Table[next].Base) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            Table[hole] = Table[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+
+    Table[hole].Base = nullptr;
+    Table[hole].Extension = nullptr;
+    --TableCount;
+
+    return true;
+}
+
+
+/**
+ *  Remove all extensions from the list and the lookup table. This does not
+ *  delete the extension instances.
+ */
+template<class EXT_CLASS>
+void ExtensionListClass<EXT_CLASS>::Clear()
+{
+    DynamicVectorClass<EXT_CLASS *>::Clear();
+
+    delete [] Table;
+    Table = nullptr;
+    TableSize = 0;
+    TableCount = 0;
+}
+
+
+/**
+ *  Rebuild the lookup table from the list.
+ */
+template<class EXT_CLASS>
+void ExtensionListClass<EXT_CLASS>::Rebuild()
+{
+    int size = 64;
+    while (this->Count() * 2 > size) {
+        size *= 2;
+    }
+
+    delete [] Table;
+    Table = nullptr;
+    TableSize = 0;
+    TableCount = 0;
+
+    Resize(size);
+
+    for (int index = 0; index < this->Count(); ++index) {
+        Insert((*this)[index]->This(), (*this)[index]);
+    }
+}
+
+
+/**
+ *  Find the extension for the base object.
+ */
+template<class EXT_CLASS>
+EXT_CLASS *ExtensionListClass<EXT_CLASS>::Find(const void *base) const
+{
+    int slot = Slot_Of(base);
+    return slot != -1 ? Table[slot].Extension : nullptr;
+}
+
+
+/**
+ *  Find the table slot of the base object, or -1 if it is not in the table.
+ */
+template<class EXT_CLASS>
+int ExtensionListClass<EXT_CLASS>::Slot_Of(const void *base) const
+{
+    if (!TableCount || base == nullptr) {
+        return -1;
+    }
+
+    unsigned mask = TableSize-1;
+    for (unsigned slot = Hash(base) & mask; Table[slot].Base != nullptr; slot = (slot + 1) & mask) {
+        if (Table[slot].Base == base) {
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+
+/**
+ *  Insert the entry into the table, the table must have room for it.
+ */
+template<class EXT_CLASS>
+void ExtensionListClass<EXT_CLASS>::Insert(const void *base, EXT_CLASS *ext)
+{
+    ASSERT(base != nullptr);
+    ASSERT(TableCount < TableSize);
+
+    unsigned mask = TableSize-1;
+    unsigned slot = Hash(base) & mask;
+
+    while (Table[slot].Base != nullptr) {
+        if (Table[slot].Base == base) {
+            Table[slot].Extension = ext;
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    Table[slot].Base = base;
+    Table[slot].Extension = ext;
+    ++TableCount;
+}
+
+
+/**
+ *  Resize the table, rehashing the existing entries.
+ */
+template<class EXT_CLASS>
+void ExtensionListClass<EXT_CLASS>::Resize(int size)
+{
+    SlotStruct *old_table = Table;
+    int old_size = TableSize;
+
+    Table = new SlotStruct[size];
+    TableSize = size;
+    TableCount = 0;
+
+    for (int slot = 0; slot < size; ++slot) {
+        Table[slot].Base = nullptr;
+        Table[slot].Extension = nullptr;
+    }
+
+    for (int slot = 0; slot < old_size; ++slot) {
+        if (old_table[slot].Base != nullptr) {
+            Insert(old_table[slot].Base, old_table[slot].Extension);
+        }
+    }
+
+    delete [] old_table;
+}
@@ -54,6 +54,7 @@
 #include "radarevent.h"
 #include "uicontrol.h"
 #include "vox.h"
+#include "overlayline.h"
 
 
 /**
@@ -79,18 +80,13 @@ private:
 /**
  *  Draws an action line with the given parameters.
  *
+ *  @note: The line is queued and drawn with the other lines of this object
+ *         at the end of _Draw_Action_Line.
+ *
  *  @author: CCHyper, ZivDero
  */
 void FootClassExt::_Draw_Line(Coordinate& start_coord, Coordinate& end_coord, bool is_dashed, bool is_thick, bool is_dropshadow, unsigned line_color, unsigned drop_color, int rate) const
 {
-    int point_size = 3;
-    Point2D point_offset(-1, -1);
-
-    if (is_thick) {
-        point_size = 4;
-        point_offset = Point2D(-2, -2);
-    }
-
     /**
      *  Convert the world coord to screen pixel.
      */
@@ -105,123 +101,17 @@ void FootClassExt::_Draw_Line(Coordinate& start_coord, Coordinate& end_coord, bo
     start_point += Point2D(TacticalRect.X, TacticalRect.Y);
     end_point += Point2D(TacticalRect.X, TacticalRect.Y);
 
-    /**
-     *  Draw the queue line.
-     */
-    if (Clip_Line(&start_point, &end_point, &TacticalRect)) {
-
-        Point2D drop_start_point = start_point;
-        Point2D drop_end_point = end_point;
-
-        drop_start_point.Y += 1;
-        drop_end_point.Y += 1;
-
-        if (is_dashed) {
-
-            /**
-             *  4 pixels on, 4 off, 4 pixels on, 4 off.
-             */
-            static bool _pattern[] = { true, true, true, true, false, false, false, false, true, true, true, true, false, false, false, false };
-
-            /**
-             *  Adjust the offset of the line pattern.
-             */
-            int time = timeGetTime();
-            int offset = (-time / rate) & (std::size(_pattern) - 1);
-
-            /**
-             *  Draw the drop shadow line.
-             */
-            if (is_dropshadow) {
-
-                if (is_thick) {
-                    drop_start_point.Y += 1;
-                    drop_end_point.Y += 1;
-                }
-
-                CompositeSurface->Draw_Dashed_Line(drop_start_point, drop_end_point, drop_color, _pattern, offset);
-
-                if (is_thick) {
-                    drop_start_point.Y += 1;
-                    drop_end_point.Y += 1;
-                    CompositeSurface->Draw_Dashed_Line(drop_start_point, drop_end_point, drop_color, _pattern, offset);
-                }
-
-            }
-
-            /**
-             *  Draw the dashed queue line.
-             */
-            CompositeSurface->Draw_Dashed_Line(start_point, end_point, line_color, _pattern, offset);
-
-            if (is_thick) {
-                start_point.Y += 1;
-                end_point.Y += 1;
-                CompositeSurface->Draw_Dashed_Line(start_point, end_point, line_color, _pattern, offset);
-            }
-
-        }
-        else {
-
-            /**
-             *  Draw the drop shadow line.
-             */
-            if (is_dropshadow) {
-
-                if (is_thick) {
-                    drop_start_point.Y += 1;
-                    drop_end_point.Y += 1;
-                }
-
-                CompositeSurface->Draw_Line(drop_start_point, drop_end_point, drop_color);
-
-                if (is_thick) {
-                    drop_start_point.Y += 1;
-                    drop_end_point.Y += 1;
-                    CompositeSurface->Draw_Line(drop_start_point, drop_end_point, drop_color);
-                }
-
-            }
-
-            /**
-             *  Draw the queue line.
-             */
-            CompositeSurface->Draw_Line(start_point, end_point, line_color);
-
-            if (is_thick) {
-                start_point.Y += 1;
-                end_point.Y += 1;
-                CompositeSurface->Draw_Line(start_point, end_point, line_color);
-            }
-
-        }
-
-    }
-
-    /**
-     *  Draw the queue line start and end squares.
-     */
-    if (is_dropshadow) {
-
-        const int drop_point_size = is_thick ? (point_size + 3) : (point_size + 2);
-        const Point2D drop_point_offset = is_thick ? (point_offset + Point2D(-2, -2)) : (point_offset + Point2D(-1, -1));
-
-        if (is_thick) {
-            point_size -= 1;
-        }
-
-        Rect drop_start_point_rect = TacticalRect.Intersect_With(Rect(start_point + drop_point_offset, drop_point_size, drop_point_size));
-        CompositeSurface->Fill_Rect(drop_start_point_rect, drop_color);
-
-        Rect drop_end_point_rect = TacticalRect.Intersect_With(Rect(end_point + drop_point_offset, drop_point_size, drop_point_size));
-        CompositeSurface->Fill_Rect(drop_end_point_rect, drop_color);
-    }
-
-    Rect start_point_rect = TacticalRect.Intersect_With(Rect(start_point + point_offset, point_size, point_size));
-    CompositeSurface->Fill_Rect(start_point_rect, line_color);
-
-    Rect end_point_rect = TacticalRect.Intersect_With(Rect(end_point + point_offset, point_size, point_size));
-    CompositeSurface->Fill_Rect(end_point_rect, line_color);
+    OverlayLineStyleStruct style;
+    style.IsDashed = is_dashed;
+    style.IsThick = is_thick;
+    style.IsDropShadow = is_dropshadow;
+    style.IsPath = false;
+    style.IsBlit = false;
+    style.Color = line_color;
+    style.DropColor = drop_color;
+    style.Rate = rate;
+
+    OverlayLineClass::Add(start_point, end_point, style);
 }
 
 
@@ -364,6 +254,12 @@ void FootClassExt::_Draw_Action_Line() const
         }
 
     }
+
+    /**
+     *  Draw the lines of this object now, so they are drawn between the same
+     *  objects as before.
+     */
+    OverlayLineClass::Draw_All();
 }
 
 
@@ -41,12 +41,14 @@
 #include "session.h"
 #include "iomap.h"
 #include "dsaudio.h"
+#include "mixprefetch.h"
 #include "vinifera_gitinfo.h"
 #include "tspp_gitinfo.h"
 #include "resource.h"
 #include "asserthandler.h"
 #include "debughandler.h"
 #include <Windows.h>
+#include <timeapi.h>
 #include <commctrl.h>
 
 #include "hooker.h"
@@ -278,6 +280,12 @@ void Vinifera_Create_Main_Window(HINSTANCE hInstance, int nCmdShow, int width, i
 {
     //DEV_DEBUG_INFO("Create_Main_Window(enter)\n");
 
+    /**
+     *  Start reading the mixfiles into the file cache while the window and
+     *  the rest of the startup process comes up.
+     */
+    MixPrefetchClass::Start();
+
     MainWindow = nullptr;
 
     HWND hWnd = nullptr;
@@ -604,6 +612,8 @@ bool Vinifera_Init_Secondary_Mixfiles()
     MFCC *mix;
     char buffer[16];
 
+    DWORD start_time = timeGetTime();
+
     DEBUG_INFO("\n"); // Fixes missing new-line after "Init Secondary Mixfiles....." print.
     //DEBUG_INFO("Init secondary mixfiles...\n");
 
@@ -802,6 +812,13 @@ bool Vinifera_Init_Secondary_Mixfiles()
         if (!CD::IsFilesLocal) DEBUG_INFO(" %s\n", buffer);
     }
 
+    DEBUG_INFO("Secondary mixfiles registered in %d ms.\n", timeGetTime() - start_time);
+
+    /**
+     *  All startup mixfiles have now been registered, the prefetch is no longer required.
+     */
+    MixPrefetchClass::Finish();
+
     return true;
 }
 
@@ -907,6 +924,14 @@ bool Vinifera_Init_Bootstrap_Mixfiles()
     bool ok;
     MFCC *mix;
 
+    DWORD start_time = timeGetTime();
+
+    /**
+     *  Make sure the mixfile prefetch is running, this is a no-op if it
+     *  was already started when the main window was created.
+     */
+    MixPrefetchClass::Start();
+
     int temp = CD::RequiredCD;
     CD::Set_Required_CD(-2);
 
@@ -971,6 +996,8 @@ bool Vinifera_Init_Bootstrap_Mixfiles()
 
     CD::Set_Required_CD(temp);
 
+    DEBUG_INFO("Bootstrap mixfiles registered in %d ms.\n", timeGetTime() - start_time);
+
     return true;
 }
 
@@ -38,9 +38,13 @@
 #include "ccfile.h"
 #include "addon.h"
 #include "ccini.h"
+#include "crcbuffer.h"
+#include "framepacer.h"
+#include "cncnet4.h"
 #include "fatal.h"
 #include "debughandler.h"
-#include "asserthandler.h"6
+#include "asserthandler.h"
+#include <timeapi.h>
 
 #include "hooker.h"
 #include "hooker_macros.h"
@@ -80,6 +84,133 @@ static void Before_Main_Loop()
 }
 
 
+/**
+ *  The time spent on the CRC checks and on parsing during the current reload.
+ */
+static DWORD ReloadCache_CheckTime;
+static DWORD ReloadCache_ParseTime;
+
+
+/**
+ *  Calculates the CRC of the contents of the file, used to detect if a file
+ *  has changed since it was last loaded without having to parse it.
+ * 
+ *  @author: CCHyper
+ */
+static uint32_t Get_File_CRC(const char *filename)
+{
+    CCFileClass file(filename);
+    if (!file.Is_Available()) {
+        return 0;
+    }
+
+    DWORD start_time = timeGetTime();
+
+    char buffer[4096];
+    uint32_t crc = 0;
+
+    file.Open(FILE_ACCESS_READ);
+
+    long read;
+    while ((read = file.Read(buffer, sizeof(buffer))) > 0) {
+        crc = CRC32_Buffer(buffer, read, crc);
+    }
+
+    file.Close();
+
+    ReloadCache_CheckTime += timeGetTime() - start_time;
+
+    return crc;
+}
+
+
+/**
+ *  The CRC of the source files for each ini database at the time it was last
+ *  loaded by the rules reload. A database is only cleared and parsed again
+ *  if the CRC of its source files has changed.
+ * 
+ *  Only the developer rules reload is cached. The parse at game start could
+ *  be intercepted (the hooks are installed from DllMain, before WinMain),
+ *  but a cache that outlives the session would have to write out and read
+ *  back the section and entry tables of CCINIClass, which are internal to
+ *  TS++. The first load at game start is therefore unchanged.
+ * 
+ *  Deciding that a file is unchanged reads it in full to calculate its CRC,
+ *  so the reload logs the time spent on the checks and on parsing separately.
+ */
+static struct {
+    bool IsValid;
+    uint32_t CRC;
+} ReloadCache_RuleINI, ReloadCache_FSRuleINI, ReloadCache_ArtINI, ReloadCache_ScenarioINI, ReloadCache_UIINI;
+
+static char ReloadCache_ScenarioName[PATH_MAX];
+
+/**
+ *  The scenario and UI databases are only used by the rules reload, so they
+ *  are owned here and created on first use. See MainLoop_Free_Reload_Cache().
+ */
+static CCINIClass *ReloadCache_ScenarioDatabase = nullptr;
+static CCINIClass *ReloadCache_UIDatabase = nullptr;
+
+
+/**
+ *  Checks the cache entry against the CRC of the source files, returns true
+ *  if the ini database needs to be reloaded and updates the entry.
+ * 
+ *  @author: CCHyper
+ */
+template<typename T>
+static bool Reload_Cache_Is_Stale(T &cache, uint32_t crc)
+{
+    if (cache.IsValid && cache.CRC == crc) {
+        return false;
+    }
+
+    cache.IsValid = true;
+    cache.CRC = crc;
+
+    return true;
+}
+
+
+/**
+ *  Clears and parses the ini database, timing the parse.
+ */
+static void Reload_Cache_Load(CCINIClass &ini, CCFileClass &file, bool clear = true)
+{
+    DWORD start_time = timeGetTime();
+
+    if (clear) {
+        ini.Clear();
+    }
+    ini.Load(file, false);
+
+    ReloadCache_ParseTime += timeGetTime() - start_time;
+}
+
+
+/**
+ *  Frees the ini databases owned by the rules reload cache.
+ * 
+ *  @author: CCHyper
+ */
+void MainLoop_Free_Reload_Cache()
+{
+    delete ReloadCache_ScenarioDatabase;
+    ReloadCache_ScenarioDatabase = nullptr;
+
+    delete ReloadCache_UIDatabase;
+    ReloadCache_UIDatabase = nullptr;
+
+    ReloadCache_RuleINI.IsValid = false;
+    ReloadCache_FSRuleINI.IsValid = false;
+    ReloadCache_ArtINI.IsValid = false;
+    ReloadCache_ScenarioINI.IsValid = false;
+    ReloadCache_UIINI.IsValid = false;
+    ReloadCache_ScenarioName[0] = '\0';
+}
+
+
 static void After_Main_Loop()
 {
     /**
@@ -87,31 +218,49 @@ static void After_Main_Loop()
      */
     if (Vinifera_Developer_IsToReloadRules) {
 
+        DWORD start_time = timeGetTime();
+
+        ReloadCache_CheckTime = 0;
+        ReloadCache_ParseTime = 0;
+
         /**
          *  Reinitalise the Rule instance to the defaults.
          */
         Rule->~RulesClass();
         new (Rule) RulesClass();
 
-        /**
-         *  Clear the current ini databases.
-         */
-        ArtINI.Clear();
-        RuleINI->Clear();
-        FSRuleINI.Clear();
+        bool firestorm = Is_Addon_Available(ADDON_FIRESTORM) && Is_Addon_Enabled(ADDON_FIRESTORM);
 
         /**
          *  Reload RULES.INI and FIRESTRM.INI.
+         * 
+         *  The ini databases are only cleared and parsed again if the files
+         *  have changed since they were last loaded, otherwise the already
+         *  parsed databases are reused.
          */
         {
             CCFileClass rulefile("RULES.INI");
-            RuleINI->Load(rulefile, false);
             ASSERT_FATAL(rulefile.Is_Available());
 
-            if (Is_Addon_Available(ADDON_FIRESTORM) && Is_Addon_Enabled(ADDON_FIRESTORM)) {
+            if (Reload_Cache_Is_Stale(ReloadCache_RuleINI, Get_File_CRC("RULES.INI"))) {
+                Reload_Cache_Load(*RuleINI, rulefile);
+            } else {
+                DEBUG_INFO("RULES.INI is unchanged, reusing parsed database.\n");
+            }
+
+            if (firestorm) {
                 rulefile.Set_Name("FIRESTRM.INI");
                 ASSERT_FATAL(rulefile.Is_Available());
-                FSRuleINI.Load(rulefile, false);
+
+                if (Reload_Cache_Is_Stale(ReloadCache_FSRuleINI, Get_File_CRC("FIRESTRM.INI"))) {
+                    Reload_Cache_Load(FSRuleINI, rulefile);
+                } else {
+                    DEBUG_INFO("FIRESTRM.INI is unchanged, reusing parsed database.\n");
+                }
+
+            } else {
+                FSRuleINI.Clear();
+                ReloadCache_FSRuleINI.IsValid = false;
             }
         }
 
@@ -119,19 +268,30 @@ static void After_Main_Loop()
          *  Reload ART.INI and ARTFS.INI.
          */
         {
-            CCFileClass artfile("ART.INI");
+            uint32_t art_crc = Get_File_CRC("ART.INI");
+            if (firestorm) {
+                art_crc = CRC32_Buffer(&art_crc, sizeof(art_crc), Get_File_CRC("ARTFS.INI"));
+            }
 
-            DEBUG_INFO("Loading ART.INI.\n");
-            ArtINI.Load(artfile, false);
-            ASSERT_FATAL(artfile.Is_Available());
-            DEBUG_INFO("Finished loading ART.INI.\n");
+            if (Reload_Cache_Is_Stale(ReloadCache_ArtINI, art_crc)) {
 
-            if (Is_Addon_Available(ADDON_FIRESTORM) && Is_Addon_Enabled(ADDON_FIRESTORM)) {
-                DEBUG_INFO("Loading ARTFS.INI.\n");
-                artfile.Set_Name("ARTFS.INI");
+                CCFileClass artfile("ART.INI");
+
+                DEBUG_INFO("Loading ART.INI.\n");
+                Reload_Cache_Load(ArtINI, artfile);
                 ASSERT_FATAL(artfile.Is_Available());
-                ArtINI.Load(artfile, false);
-                DEBUG_INFO("Finished loading ARTFS.INI.\n");
+                DEBUG_INFO("Finished loading ART.INI.\n");
+
+                if (firestorm) {
+                    DEBUG_INFO("Loading ARTFS.INI.\n");
+                    artfile.Set_Name("ARTFS.INI");
+                    ASSERT_FATAL(artfile.Is_Available());
+                    Reload_Cache_Load(ArtINI, artfile, false);
+                    DEBUG_INFO("Finished loading ARTFS.INI.\n");
+                }
+
+            } else {
+                DEBUG_INFO("ART.INI is unchanged, reusing parsed database.\n");
             }
         }
 
@@ -150,12 +310,27 @@ static void After_Main_Loop()
          *  Process scenario rule overrides.
          */
         {
+            if (!ReloadCache_ScenarioDatabase) {
+                ReloadCache_ScenarioDatabase = new CCINIClass;
+                ReloadCache_ScenarioINI.IsValid = false;
+            }
+
+            CCINIClass &scenini = *ReloadCache_ScenarioDatabase;
+
             CCFileClass scenfile(Scen->ScenarioName);
             ASSERT_FATAL(scenfile.Is_Available());
 
-            CCINIClass scenini;
+            /**
+             *  A different scenario invalidates the cached database.
+             */
+            if (std::strcmp(ReloadCache_ScenarioName, Scen->ScenarioName) != 0) {
+                std::strncpy(ReloadCache_ScenarioName, Scen->ScenarioName, sizeof(ReloadCache_ScenarioName)-1);
+                ReloadCache_ScenarioINI.IsValid = false;
+            }
 
-            scenini.Load(scenfile, false);
+            if (Reload_Cache_Is_Stale(ReloadCache_ScenarioINI, Get_File_CRC(Scen->ScenarioName))) {
+                Reload_Cache_Load(scenini, scenfile);
+            }
 
             DEBUG_INFO("Calling Rule->Addition() with scenario overrides.\n");
             Rule->Addition(scenini);
@@ -166,17 +341,27 @@ static void After_Main_Loop()
          *  Finally, reload miscellaneous classes.
          */
         {
+            if (!ReloadCache_UIDatabase) {
+                ReloadCache_UIDatabase = new CCINIClass;
+                ReloadCache_UIINI.IsValid = false;
+            }
+
+            CCINIClass &workingini = *ReloadCache_UIDatabase;
+
             CCFileClass workingfile;
-            CCINIClass workingini;
 
             DEBUG_INFO("Calling UIControls->Read_INI().\n");
             workingfile.Set_Name("UI.INI");
-            workingini.Clear();
-            workingini.Load(workingfile, false);
+            if (Reload_Cache_Is_Stale(ReloadCache_UIINI, Get_File_CRC("UI.INI"))) {
+                Reload_Cache_Load(workingini, workingfile);
+            }
             UIControls->Read_INI(workingini);
             DEBUG_INFO("Finished UIControls->Read_INI().\n");
         }
 
+        DEBUG_INFO("Rules reloaded in %d ms (%d ms checking for changes, %d ms parsing).\n",
+            timeGetTime() - start_time, ReloadCache_CheckTime, ReloadCache_ParseTime);
+
         /**
          *  All done!
          */
@@ -185,6 +370,12 @@ static void After_Main_Loop()
 }
 
 
+/**
+ *  The rate the map is redrawn at while frame step mode is waiting for input.
+ */
+#define FRAMESTEP_REDRAW_RATE   60
+
+
 /**
  *  Main loop for the frame step mode. This should only handle basic
  *  input, redraw the map and update the scroll position.
@@ -229,7 +420,7 @@ static bool FrameStep_Main_Loop()
 
     }
 
-    Sleep(1);
+    FramePacerClass::Wait_For_Frame(FRAMESTEP_REDRAW_RATE);
 
     //DEV_DEBUG_INFO("FrameStep_Main_Loop(exit)\n");
 
@@ -241,6 +432,10 @@ static bool Main_Loop_Intercept()
 {
     bool ret = false;
 
+    FramePacerClass::Record_Frame();
+
+    CnCNet4::Process();
+
     /**
      *  Frame step mode enabled but no frames to process, so just perform
      *  a basic redraw and update of the screen, no game logic.
@@ -29,3 +29,5 @@
 
 
 void MainLoop_Hooks();
+
+void MainLoop_Free_Reload_Cache();
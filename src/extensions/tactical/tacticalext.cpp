@@ -41,6 +41,7 @@
 #include "session.h"
 #include "scenario.h"
 #include "ebolt.h"
+#include "framepacer.h"
 #include "house.h"
 #include "housetype.h"
 #include "super.h"
@@ -215,12 +216,17 @@ void TacticalExtension::Draw_Debug_Overlay()
 
     int padding = 2;
 
+    FramePacerClass::StatisticsStruct frame_stats = FramePacerClass::Get_Statistics();
+
     char buffer[256];
     std::snprintf(buffer, sizeof(buffer),
-        "[%s] %3d %3d 0x%08X",
+        "[%s] %3d %3d %5.1f %5.1f %d 0x%08X",
         strupr(Scen->ScenarioName),
         Session.DesiredFrameRate,
         FramesPerSecond,
+        frame_stats.Median,
+        frame_stats.Percentile99,
+        frame_stats.MissedDeadlines,
         CurrentObjects.Count() == 1 ? CurrentObjects.Fetch_Head() : 0
     );
 
@@ -30,6 +30,7 @@
 #include "tibsun_defines.h"
 
 #include "wwfont.h"
+#include "textlayout.h"
 
 
 #include "fatal.h"
@@ -40,13 +41,79 @@
 #include "hooker_macros.h"
 
 
+/**
+ *  The maximum number of fonts that have a glyph width table.
+ */
+#define FONT_WIDTH_TABLE_MAX    16
+
+
+/**
+ *  Glyph width tables for the fonts, so the width of a character is a table
+ *  lookup rather than a call into the font.
+ */
+static struct FontWidthTableStruct
+{
+    WWFontClass *Font;
+    int Widths[TEXT_LAYOUT_GLYPH_COUNT];
+} FontWidthTables[FONT_WIDTH_TABLE_MAX];
+
+static int FontWidthTableNext = 0;
+
+
+/**
+ *  Fetches the glyph width table for the font, building it if required.
+ *
+ *  @author: CCHyper
+ */
+static const int *Font_Width_Table(WWFontClass *font)
+{
+    for (int i = 0; i < FONT_WIDTH_TABLE_MAX; ++i) {
+        FontWidthTableStruct &table = FontWidthTables[i];
+        if (table.Font != font) {
+            continue;
+        }
+
+        /**
+         *  The character spacing of a font can be changed after it is loaded,
+         *  so check the table still agrees with the font.
+         */
+        if (table.Widths[' '] == font->Char_Pixel_Width(' ')) {
+            return table.Widths;
+        }
+
+        TextLayoutClass::Flush(font);
+
+        for (int c = 0; c < TEXT_LAYOUT_GLYPH_COUNT; ++c) {
+            table.Widths[c] = font->Char_Pixel_Width((char)c);
+        }
+
+        return table.Widths;
+    }
+
+    FontWidthTableStruct &table = FontWidthTables[FontWidthTableNext];
+    FontWidthTableNext = (FontWidthTableNext + 1) % FONT_WIDTH_TABLE_MAX;
+
+    if (table.Font) {
+        TextLayoutClass::Flush(table.Font);
+    }
+
+    table.Font = font;
+    for (int c = 0; c < TEXT_LAYOUT_GLYPH_COUNT; ++c) {
+        table.Widths[c] = font->Char_Pixel_Width((char)c);
+    }
+
+    return table.Widths;
+}
+
+
 /**
  *  #issue-1085
  *
  *  Reimplements Format_Window_String to fix a bug where the width of the modified string
  *  can exceed the given max line length.
  *
- *  Reimplemented based on Red Alert source code.
+ *  Reimplemented based on Red Alert source code. The line breaking itself is done
+ *  by TextLayoutClass, from the glyph width table of the font.
  *
  *  @author: 03/27/1992  SB : Created.
  *           05/18/1995 JLB : Greatly revised for new font system.
@@ -55,8 +122,6 @@
  */
 int _Format_Window_String_Custom_Implementation(char* string, WWFontClass* font, int maxlinelen, int& width, int& height)
 {
-    int    linelen;
-    int    lines = 0;
     width = 0;
     height = 0;
 
@@ -68,58 +133,9 @@ int _Format_Window_String_Custom_Implementation(char* string, WWFontClass* font,
     if (!font)
         return 0;
 
-    // While there are more letters left divide the line up.
-    while (*string) {
-        linelen = 0;
-        height += font->Get_Font_Height() + font->Get_Y_Spacing();
-        lines++;
-
-        /*
-        **    Look for special line break character and force a line break when it is
-        **    discovered.
-        */
-        if (*string == '@') {
-            *string = '\r';
-        }
-
-        // While the current line is less then the max length...
-        while (linelen < maxlinelen && *string != '\r' && *string != '\0' && *string != '@') {
-            linelen += font->Char_Pixel_Width(*string);
-            string++;
-        }
-
-        // if the line is too long...
-        if (linelen >= maxlinelen) {
-
-            /*
-            **    Back up to an appropriate location to break.
-            */
-            while (linelen > maxlinelen || (*string != ' ' && *string != '\r' && *string != '\0' && *string != '@')) {
-                linelen -= font->Char_Pixel_Width(*string);
-                string--;
-            }
-        }
-
-        /*
-        **    Record the largest width of the worst case string.
-        */
-        if (linelen > width) {
-            width = linelen;
-
-            if (width > maxlinelen) {
-                width = linelen;
-            }
-        }
-
-        /*
-        **    Force a break at the end of the line.
-        */
-        if (*string) {
-            *string++ = '\r';
-        }
-    }
+    int lineheight = font->Get_Font_Height() + font->Get_Y_Spacing();
 
-    return lines;
+    return TextLayoutClass::Format_Cached(font, string, Font_Width_Table(font), lineheight, maxlinelen, width, height);
 }
 
 
@@ -26,8 +26,15 @@
  *
  ******************************************************************************/
 #include "unitext.h"
+#include "unittypeext.h"
 #include "unit.h"
+#include "unittype.h"
 #include "building.h"
+#include "cell.h"
+#include "iomap.h"
+#include "rules.h"
+#include "spawnmanager.h"
+#include "tibsun_globals.h"
 #include "vinifera_saveload.h"
 #include "wwcrc.h"
 #include "extension.h"
@@ -42,7 +49,11 @@
  */
 UnitClassExtension::UnitClassExtension(const UnitClass *this_ptr) :
     FootClassExtension(this_ptr),
-    LastDockedBuilding(nullptr)
+    LastDockedBuilding(nullptr),
+    DrawVoxel(nullptr),
+    DrawVoxelIndex(nullptr),
+    DrawVoxelFrame(-1),
+    DrawVoxelClass(nullptr)
 {
     //if (this_ptr) EXT_DEBUG_TRACE("UnitClassExtension::UnitClassExtension - Name: %s (0x%08X)\n", Name(), (uintptr_t)(This()));
 
@@ -112,6 +123,14 @@ HRESULT UnitClassExtension::Load(IStream *pStm)
     
     VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(LastDockedBuilding, "LastDockedBuilding");
 
+    /**
+     *  Force the draw voxel to be selected again.
+     */
+    DrawVoxel = nullptr;
+    DrawVoxelIndex = nullptr;
+    DrawVoxelFrame = -1;
+    DrawVoxelClass = nullptr;
+
     return hr;
 }
 
@@ -175,3 +194,102 @@ void UnitClassExtension::Compute_CRC(WWCRCEngine &crc) const
 
     crc(LastDockedBuilding != nullptr ? LastDockedBuilding->Fetch_ID() : 0);
 }
+
+
+/**
+ *  Returns the voxel variant conditions (VoxelConditionType) this unit
+ *  currently meets.
+ *  
+ *  @author: CCHyper
+ */
+unsigned UnitClassExtension::Voxel_Conditions() const
+{
+    const UnitClass *unit = This_Const();
+    unsigned conditions = VOXEL_CONDITION_NONE;
+
+    if (Map[unit->Get_Coord()].Land_Type() == LAND_WATER) {
+        conditions |= VOXEL_CONDITION_ON_WATER;
+    }
+
+    if (unit->IsOnBridge) {
+        conditions |= VOXEL_CONDITION_ON_BRIDGE;
+    }
+
+    if (unit->Get_Height() >= CELL_HEIGHT(1)) {
+        conditions |= VOXEL_CONDITION_AIRBORNE;
+    }
+
+    if (!SpawnManager || SpawnManager->Docked_Count() > 0) {
+        conditions |= VOXEL_CONDITION_SPAWNS_DOCKED;
+    }
+
+    if (unit->Health_Ratio() <= Rule->ConditionYellow) {
+        conditions |= VOXEL_CONDITION_DAMAGED;
+    }
+
+    if (unit->Get_Mission() == MISSION_UNLOAD) {
+        conditions |= VOXEL_CONDITION_DEPLOYED;
+    }
+
+    return conditions;
+}
+
+
+/**
+ *  Selects the voxel model to draw this unit with from the voxel variants
+ *  of its type.
+ *  
+ *  @author: CCHyper
+ */
+void UnitClassExtension::Update_Draw_Voxel()
+{
+    UnitClass *unit = This();
+    UnitTypeClass *unittype = unit->Class;
+    UnitTypeClassExtension *unittypeext = Extension::Fetch<UnitTypeClassExtension>(unittype);
+
+    DrawVoxel = &unittype->Voxel;
+    DrawVoxelIndex = &unittype->VoxelIndex;
+    DrawVoxelFrame = Frame;
+    DrawVoxelClass = unittype;
+
+    /**
+     *  Most unit types have no variants, so avoid looking up the conditions.
+     */
+    if (!unittypeext->VoxelVariantCount) {
+        return;
+    }
+
+    int index = unittypeext->Select_Voxel_Variant(Voxel_Conditions());
+    if (index == -1) {
+        return;
+    }
+
+    VoxelVariantStruct &variant = unittypeext->VoxelVariants[index];
+
+    switch (variant.Source) {
+
+        /**
+         *  The auxiliary voxel is drawn without a cache, as the original
+         *  APC water model was.
+         */
+        case VOXEL_VARIANT_AUX:
+            DrawVoxel = &unittype->AuxVoxel;
+            DrawVoxelIndex = nullptr;
+            break;
+
+        case VOXEL_VARIANT_ALT:
+            DrawVoxel = &unittypeext->AltVoxel;
+            DrawVoxelIndex = &unittypeext->AltVoxelIndex;
+            break;
+
+        case VOXEL_VARIANT_IMAGE:
+            if (variant.Voxel.VoxelLibrary) {
+                DrawVoxel = &variant.Voxel;
+                DrawVoxelIndex = &variant.VoxelIndex;
+            }
+            break;
+
+        default:
+            break;
+    };
+}
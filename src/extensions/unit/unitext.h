@@ -30,6 +30,7 @@
 #include "footext.h"
 #include "unit.h"
 #include "building.h"
+#include "unittype.h"
 
 
 class DECLSPEC_UUID(UUID_UNIT_EXTENSION)
@@ -60,6 +61,9 @@ UnitClassExtension final : public FootClassExtension
         virtual const UnitClass *This_Const() const override { return reinterpret_cast<const UnitClass *>(FootClassExtension::This_Const()); }
         virtual RTTIType What_Am_I() const override { return RTTI_UNIT; }
 
+        unsigned Voxel_Conditions() const;
+        void Update_Draw_Voxel();
+
     public:
         /**
         *  #issue-203
@@ -69,4 +73,14 @@ UnitClassExtension final : public FootClassExtension
         *  when picking a tiberium cell to harvest from.
         */
         BuildingClass *LastDockedBuilding;
+
+        /**
+         *  The voxel model (and its cache) to draw this unit with, selected from
+         *  the voxel variants of the unit type. This is only reevaluated once per
+         *  game frame, or when the unit type changes.
+         */
+        VoxelObject *DrawVoxel;
+        VoxelIndexClass *DrawVoxelIndex;
+        long DrawVoxelFrame;
+        const UnitTypeClass *DrawVoxelClass;
 };
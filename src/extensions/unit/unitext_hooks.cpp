@@ -202,33 +202,23 @@ void UnitClassExt::_Draw_Voxel(unsigned int frame, int key, Rect& rect, Point2D&
 {
     Matrix3D matrix;
     Matrix3D::Multiply(Get_Voxel_Draw_Matrix(), other_matrix, &matrix);
-    const auto typeext = Extension::Fetch<UnitTypeClassExtension>(Class);
     const auto ext = Extension::Fetch<UnitClassExtension>(this);
 
-    VoxelObject* voxel = nullptr;
-    VoxelIndexClass* cache = nullptr;
+    /**
+     *  The voxel variant is only selected once per frame.
+     */
+    if (ext->DrawVoxelFrame != Frame || ext->DrawVoxelClass != Class) {
+        ext->Update_Draw_Voxel();
+    }
 
-    if (!std::strcmp(Class->IniName, "APC")
-        && Map[Get_Coord()].Land_Type() == LAND_WATER
-        && !IsOnBridge
-        && Get_Height() < CELL_HEIGHT(1))
-    {
-        voxel = &Class->AuxVoxel;
-        cache = nullptr;
+    /**
+     *  Voxels without a cache can not be drawn with a cache key.
+     */
+    if (!ext->DrawVoxelIndex) {
         key = -1;
     }
-    else if (typeext->NoSpawnAlt && ext->SpawnManager && !ext->SpawnManager->Docked_Count())
-    {
-        voxel = &typeext->AltVoxel;
-        cache = &typeext->AltVoxelIndex;
-    }
-    else
-    {
-        voxel = &Class->Voxel;
-        cache = &Class->VoxelIndex;
-    }
 
-    Draw_Voxel(*voxel, frame, key, *cache, rect, point, matrix, color, flags);
+    Draw_Voxel(*ext->DrawVoxel, frame, key, *ext->DrawVoxelIndex, rect, point, matrix, color, flags);
 }
 
 
@@ -31,8 +31,12 @@
 #include "tibsun_globals.h"
 #include "extension.h"
 #include "vinifera_saveload.h"
+#include "voxellib.h"
+#include "motionlib.h"
+#include "miscutil.h"
 #include "asserthandler.h"
 #include "debughandler.h"
+#include <cstring>
 
 
 /**
@@ -48,7 +52,10 @@ UnitTypeClassExtension::UnitTypeClassExtension(const UnitTypeClass *this_ptr) :
     StartIdleFrame(0),
     IdleFrames(0),
     TransformsInto(nullptr),
-    IsTransformRequiresFullCharge(false)
+    IsTransformRequiresFullCharge(false),
+    VoxelVariants(),
+    VoxelVariantCount(0),
+    VoxelVariantINICount(0)
 {
     //if (this_ptr) EXT_DEBUG_TRACE("UnitTypeClassExtension::UnitTypeClassExtension - Name: %s (0x%08X)\n", Name(), (uintptr_t)(This()));
 
@@ -77,6 +84,8 @@ UnitTypeClassExtension::~UnitTypeClassExtension()
 {
     //EXT_DEBUG_TRACE("UnitTypeClassExtension::~UnitTypeClassExtension - Name: %s (0x%08X)\n", Name(), (uintptr_t)(This()));
 
+    Free_Voxel_Variants();
+
     UnitTypeExtensions.Delete(this);
 }
 
@@ -109,6 +118,8 @@ HRESULT UnitTypeClassExtension::Load(IStream *pStm)
 {
     //EXT_DEBUG_TRACE("UnitTypeClassExtension::Load - Name: %s (0x%08X)\n", Name(), (uintptr_t)(This()));
 
+    Free_Voxel_Variants();
+
     HRESULT hr = TechnoTypeClassExtension::Load(pStm);
     if (FAILED(hr)) {
         return E_FAIL;
@@ -118,6 +129,17 @@ HRESULT UnitTypeClassExtension::Load(IStream *pStm)
     
     VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(TransformsInto, "TransformsInto");
 
+    /**
+     *  The voxel models are not saved, reload them from the image names.
+     */
+    for (int i = 0; i < VoxelVariantCount; ++i) {
+        VoxelVariants[i].VoxelIndex.Clear();
+        VoxelVariants[i].Voxel.VoxelLibrary = nullptr;
+        VoxelVariants[i].Voxel.MotionLibrary = nullptr;
+    }
+
+    Fetch_Voxel_Variants();
+
     return hr;
 }
 
@@ -213,7 +235,130 @@ bool UnitTypeClassExtension::Read_INI(CCINIClass &ini)
     StartIdleFrame = ArtINI.Get_Int(graphic_name, "StartIdleFrame", StartIdleFrame);
     IdleFrames = ArtINI.Get_Int(graphic_name, "IdleFrames", IdleFrames);
 
+    /**
+     *  Read the voxel variants, these are numbered from 1 and the list ends
+     *  at the first missing entry. The list is only replaced if this INI
+     *  defines one, so a scenario INI does not clear the variants from RULES.
+     */
+    bool variants_read = false;
+
+    if (ini.Is_Present(ini_name, "VoxelVariant1")) {
+
+        Free_Voxel_Variants();
+        VoxelVariantINICount = 0;
+
+        char entry[64];
+        char buffer[256];
+
+        for (int index = 1; VoxelVariantINICount < VOXEL_VARIANT_MAX-2; ++index) {
+
+            std::snprintf(entry, sizeof(entry), "VoxelVariant%d", index);
+            if (ini.Get_String(ini_name, entry, "", buffer, sizeof(buffer)) <= 0) {
+                break;
+            }
+
+            VoxelVariantStruct &variant = VoxelVariants[VoxelVariantINICount];
+            variant.Source = VOXEL_VARIANT_IMAGE;
+            std::strncpy(variant.ImageName, buffer, sizeof(variant.ImageName));
+            variant.ImageName[sizeof(variant.ImageName)-1] = '\0';
+
+            std::snprintf(entry, sizeof(entry), "VoxelVariant%d.Conditions", index);
+            ini.Get_String(ini_name, entry, "", buffer, sizeof(buffer));
+            if (!Parse_Voxel_Conditions(buffer, variant.Required, variant.Excluded)) {
+                DEBUG_WARNING("UnitType: Unknown condition in \"%s\" of \"%s\"!\n", entry, ini_name);
+            }
+
+            ++VoxelVariantINICount;
+        }
+
+        variants_read = true;
+    }
+
+    /**
+     *  The built-in variants always follow the INI variants. They are added
+     *  again on every read, so they are never duplicated and a change to
+     *  NoSpawnAlt in a later INI is picked up.
+     */
+    VoxelVariantCount = VoxelVariantINICount;
+
+    /**
+     *  The APC switches to its auxiliary voxel while on water.
+     */
+    if (!strcmpi(This()->IniName, "APC")) {
+        VoxelVariantStruct &variant = VoxelVariants[VoxelVariantCount++];
+        variant.Source = VOXEL_VARIANT_AUX;
+        variant.Required = VOXEL_CONDITION_ON_WATER;
+        variant.Excluded = VOXEL_CONDITION_ON_BRIDGE|VOXEL_CONDITION_AIRBORNE;
+        variant.ImageName[0] = '\0';
+    }
+
+    /**
+     *  Units with NoSpawnAlt switch to the alternative voxel while all their spawns are out.
+     */
+    if (NoSpawnAlt) {
+        VoxelVariantStruct &variant = VoxelVariants[VoxelVariantCount++];
+        variant.Source = VOXEL_VARIANT_ALT;
+        variant.Required = VOXEL_CONDITION_NONE;
+        variant.Excluded = VOXEL_CONDITION_SPAWNS_DOCKED;
+        variant.ImageName[0] = '\0';
+    }
+
+    if (variants_read && This()->IsVoxel) {
+        Fetch_Voxel_Variants();
+    }
+
     IsInitialized = true;
 
     return true;
 }
+
+
+/**
+ *  Load the voxel models for the image voxel variants.
+ *  
+ *  @author: CCHyper
+ */
+void UnitTypeClassExtension::Fetch_Voxel_Variants()
+{
+    for (int i = 0; i < VoxelVariantCount; ++i) {
+
+        VoxelVariantStruct &variant = VoxelVariants[i];
+        if (variant.Source != VOXEL_VARIANT_IMAGE) {
+            continue;
+        }
+
+        if (Load_Voxel(variant.Voxel, variant.ImageName, true)) {
+            variant.VoxelIndex.Clear();
+
+        } else {
+            DEBUG_WARNING("UnitType: Failed to load voxel variant \"%s\" for \"%s\"!\n", variant.ImageName, Name());
+            delete variant.Voxel.VoxelLibrary;
+            delete variant.Voxel.MotionLibrary;
+            variant.Voxel.VoxelLibrary = nullptr;
+            variant.Voxel.MotionLibrary = nullptr;
+        }
+    }
+}
+
+
+/**
+ *  Release the voxel models of the image voxel variants.
+ *  
+ *  @author: CCHyper
+ */
+void UnitTypeClassExtension::Free_Voxel_Variants()
+{
+    for (int i = 0; i < VoxelVariantCount; ++i) {
+
+        VoxelVariantStruct &variant = VoxelVariants[i];
+        if (variant.Source != VOXEL_VARIANT_IMAGE) {
+            continue;
+        }
+
+        variant.VoxelIndex.Clear();
+        delete variant.Voxel.VoxelLibrary;
+        delete variant.Voxel.MotionLibrary;
+        variant.Voxel.VoxelLibrary = nullptr;
+        variant.Voxel.MotionLibrary = nullptr;
+    }
+}
@@ -29,6 +29,35 @@
 
 #include "technotypeext.h"
 #include "unittype.h"
+#include "voxelvariant.h"
+
+
+/**
+ *  The maximum number of voxel variants a unit type can have, this includes
+ *  the built-in variants for the APC water model and NoSpawnAlt.
+ */
+#define VOXEL_VARIANT_MAX   8
+
+
+/**
+ *  An alternative voxel model for a unit type, and the conditions under which
+ *  it is drawn. The conditions are masks of VoxelConditionType, all of the
+ *  required conditions must be met and none of the excluded ones.
+ */
+struct VoxelVariantStruct
+{
+    VoxelVariantSourceType Source;
+    unsigned Required;
+    unsigned Excluded;
+
+    /**
+     *  The image name, and the voxel model loaded from it and its cache.
+     *  Only used by image variants.
+     */
+    char ImageName[24 + 1];
+    VoxelObject Voxel;
+    VoxelIndexClass VoxelIndex;
+};
 
 
 class DECLSPEC_UUID(UUID_UNITTYPE_EXTENSION)
@@ -61,6 +90,12 @@ UnitTypeClassExtension final : public TechnoTypeClassExtension
 
         virtual bool Read_INI(CCINIClass &ini) override;
 
+        int Select_Voxel_Variant(unsigned conditions) const { return ::Select_Voxel_Variant(VoxelVariants, VoxelVariantCount, conditions); }
+
+    private:
+        void Fetch_Voxel_Variants();
+        void Free_Voxel_Variants();
+
     public:
         /**
          *  Can this unit be picked up (toted) by the carryall aircraft?
@@ -96,4 +131,13 @@ UnitTypeClassExtension final : public TechnoTypeClassExtension
          *  If set, transforming to another unit will require this unit to have full charge.
          */
         bool IsTransformRequiresFullCharge;
+
+        /**
+         *  The voxel variants of this unit, in the order they are tested. If
+         *  none of them match, the normal voxel model is drawn. The variants
+         *  read from the INI come first, followed by the built-in variants.
+         */
+        VoxelVariantStruct VoxelVariants[VOXEL_VARIANT_MAX];
+        int VoxelVariantCount;
+        int VoxelVariantINICount;
 };
@@ -102,10 +102,17 @@ BOOL WINAPI DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved
                               Execute_Day, Execute_Month, Execute_Year, Execute_Hour, Execute_Min, Execute_Sec);
 
             /**
-             *  Setup hooks and any other systems here.
+             *  Setup hooks and any other systems here. The patches are staged
+             *  and then applied together once all hooks have been set up.
              */
+            Hook_Begin_Transaction();
+
             Setup_Hooks();
 
+            if (!Hook_Commit_Transaction()) {
+                return FALSE;
+            }
+
             OutputDebugString("\n\nSetup_Hooks() done!\n\n");
 
             DLLInstance = hModule;
@@ -30,6 +30,18 @@
 #include "hooker.h"
 #include "mapview.h"
 #include "asserthandler.h"
+#include "hookpatch.h"
+#include <cstring>
+
+
+/**
+ *  The staging table lives in static storage as patches are applied from
+ *  DllMain, before it is safe to rely on the heap. Once committed, it holds
+ *  the bytes replaced by the transaction until the next one is opened.
+ */
+static HookPatchTableClass PatchTable;
+static bool IsTransactionOpen = false;
+static bool IsTransactionFailed = false;
 
 
 static DWORD OriginalCodeProtect = 0;
@@ -37,6 +49,11 @@ static DWORD OriginalDataProtect = 0;
 
 static bool HookingFlag = false;
 
+/**
+ *  The sections made writable by StartHooking.
+ */
+static ImageSectionInfo HookingSections;
+
 
 /**
  *  Unprotects the binary, run before patches are applied.
@@ -69,6 +86,10 @@ bool StartHooking()
 
     HookingFlag = success;
 
+    if (success) {
+        HookingSections = info;
+    }
+
     return success;
 }
 
@@ -103,3 +124,170 @@ bool StopHooking()
 
     return success;
 }
+
+
+/**
+ *  Is the range inside one of the sections made writable by StartHooking?
+ */
+static bool Hook_Is_Section_Writable(uintptr_t address, size_t size)
+{
+    if (!HookingFlag) {
+        return false;
+    }
+
+    uintptr_t code = (uintptr_t)HookingSections.BaseOfCode;
+    uintptr_t data = (uintptr_t)HookingSections.BaseOfData;
+
+    return (address >= code && address + size <= code + HookingSections.SizeOfCode)
+        || (address >= data && address + size <= data + HookingSections.SizeOfData);
+}
+
+
+/**
+ *  The memory functions used by the patch table. Almost every patch is to
+ *  the code or data section of the binary, which StartHooking has already
+ *  made writable for the life of the DLL, so those are not unprotected
+ *  again. The old protection of zero marks them for Hook_Protect_Memory.
+ */
+static bool Hook_Unprotect_Memory(uintptr_t address, size_t size, unsigned long &old_protect)
+{
+    if (Hook_Is_Section_Writable(address, size)) {
+        old_protect = 0;
+        return true;
+    }
+
+    DWORD protect = 0;
+    if (!VirtualProtectEx(GetCurrentProcess(), (LPVOID)address, size, PAGE_EXECUTE_READWRITE, &protect)) {
+        return false;
+    }
+    old_protect = protect;
+    return true;
+}
+
+static void Hook_Protect_Memory(uintptr_t address, size_t size, unsigned long protect)
+{
+    if (!protect) {
+        return;
+    }
+
+    DWORD old_protect;
+    VirtualProtectEx(GetCurrentProcess(), (LPVOID)address, size, protect, &old_protect);
+}
+
+static void Hook_Flush_Memory(uintptr_t address, size_t size)
+{
+    FlushInstructionCache(GetCurrentProcess(), (LPCVOID)address, size);
+}
+
+
+/**
+ *  Write the memory immediately, used outside of a transaction.
+ */
+static void Hook_Write_Memory_Immediate(uintptr_t address, const void *data, int size)
+{
+    unsigned long old_protect = 0;
+
+    bool success = Hook_Unprotect_Memory(address, size, old_protect);
+    ASSERT_FATAL_PRINT(success == true, "Failed to change permissions for patch at 0x%p!", address);
+    if (!success) {
+        return;
+    }
+
+    std::memcpy((void *)address, data, size);
+
+    Hook_Protect_Memory(address, size, old_protect);
+    Hook_Flush_Memory(address, size);
+}
+
+
+/**
+ *  Start staging patches. This also drops the record of the last committed
+ *  transaction, so it can no longer be rolled back.
+ */
+void Hook_Begin_Transaction()
+{
+    ASSERT_FATAL_PRINT(!IsTransactionOpen, "Patch transaction is already open!");
+
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+
+    PatchTable.Clear();
+    PatchTable.Set_Memory_Functions(sysinfo.dwPageSize, Hook_Unprotect_Memory, Hook_Protect_Memory, Hook_Flush_Memory);
+
+    IsTransactionOpen = true;
+    IsTransactionFailed = false;
+}
+
+
+/**
+ *  Apply all patches staged since the transaction was opened. If any two
+ *  patches write the same byte, or any page can not be made writable,
+ *  nothing is written and false is returned.
+ */
+bool Hook_Commit_Transaction()
+{
+    ASSERT_FATAL_PRINT(IsTransactionOpen, "No patch transaction is open!");
+
+    IsTransactionOpen = false;
+
+    if (IsTransactionFailed) {
+        ASSERT_FATAL_PRINT(false, "Patch transaction overflowed the staging table!");
+        PatchTable.Clear();
+        return false;
+    }
+
+    if (!PatchTable.Apply()) {
+        ASSERT_FATAL_PRINT(false, "Failed to apply patch transaction! %d overlapping patches.", PatchTable.Overlap_Count());
+        PatchTable.Clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ *  Discard all patches staged in the open transaction. If no transaction is
+ *  open, the last committed transaction is undone by writing back the bytes
+ *  it replaced.
+ */
+bool Hook_Rollback_Transaction()
+{
+    IsTransactionOpen = false;
+    IsTransactionFailed = false;
+
+    return PatchTable.Rollback();
+}
+
+
+/**
+ *  Write the data to the address, staging it if a transaction is open.
+ */
+void Hook_Write_Memory(uintptr_t address, const void *data, int size)
+{
+    if (!IsTransactionOpen) {
+        Hook_Write_Memory_Immediate(address, data, size);
+        return;
+    }
+
+    if (!PatchTable.Stage(address, data, size)) {
+        IsTransactionFailed = true;
+    }
+}
+
+
+/**
+ *  Fill a range at the address with the value, staging it if a transaction is open.
+ */
+void Hook_Fill_Memory(uintptr_t address, uint8_t value, int count)
+{
+    uint8_t buffer[HOOK_PATCH_CHUNK_SIZE];
+    std::memset(buffer, value, sizeof(buffer));
+
+    while (count > 0) {
+        int chunk = (count < HOOK_PATCH_CHUNK_SIZE) ? count : HOOK_PATCH_CHUNK_SIZE;
+        Hook_Write_Memory(address, buffer, chunk);
+        address += chunk;
+        count -= chunk;
+    }
+}
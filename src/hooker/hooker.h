@@ -66,6 +66,23 @@ struct /*alignas(1)*/ call_opcode
 #pragma pack()
 
 
+/**
+ *  Patch transactions. While a transaction is open, patches are staged in a
+ *  table instead of being written one at a time. Committing checks that no
+ *  two patches write the same byte, unprotects each run of affected pages
+ *  once and then writes all patches before flushing the instruction cache;
+ *  if anything fails, nothing is written. The last committed transaction can
+ *  be rolled back until the next one is opened. Outside of a transaction,
+ *  patches are written immediately.
+ */
+void Hook_Begin_Transaction();
+bool Hook_Commit_Transaction();
+bool Hook_Rollback_Transaction();
+
+void Hook_Write_Memory(uintptr_t address, const void *data, int size);
+void Hook_Fill_Memory(uintptr_t address, uint8_t value, int count);
+
+
 /**
  *  Patch a call hook to the input address/function.
  */
@@ -74,12 +91,9 @@ void Patch_Call(uintptr_t address, T new_address)
 {
     static_assert(sizeof(call_opcode) == 5, "Call struct not expected size!");
 
-    SIZE_T bytes_written;
-
     call_opcode cmd;
     cmd.addr = reinterpret_cast<uintptr_t>((void*&)new_address) - address - sizeof(call_opcode);
-    WriteProcessMemory(GetCurrentProcess(), (LPVOID)address, &cmd, sizeof(call_opcode), &bytes_written);
-    ASSERT_FATAL_PRINT(bytes_written == sizeof(call_opcode), "Failed to patch call at 0x%p!", address);
+    Hook_Write_Memory(address, &cmd, sizeof(call_opcode));
 }
 
 
@@ -91,12 +105,9 @@ void Patch_Jump(uintptr_t address, T new_address)
 {
     static_assert(sizeof(jump_opcode) == 5, "Jump struct not expected size!");
 
-    SIZE_T bytes_written;
-
     jump_opcode cmd;
     cmd.addr = reinterpret_cast<uintptr_t>((void*&)new_address) - address - sizeof(jump_opcode);
-    WriteProcessMemory(GetCurrentProcess(), (LPVOID)address, &cmd, sizeof(jump_opcode), &bytes_written);
-    ASSERT_FATAL_PRINT(bytes_written == sizeof(jump_opcode), "Failed to patch jump at 0x%p!", address);
+    Hook_Write_Memory(address, &cmd, sizeof(jump_opcode));
 }
 
 
@@ -105,33 +116,22 @@ void Patch_Jump(uintptr_t address, T new_address)
  */
 inline void Patch_Byte(uintptr_t in, uint8_t byte)
 {
-    SIZE_T bytes_written;
-    WriteProcessMemory(GetCurrentProcess(), (LPVOID)in, &byte, sizeof(uint8_t), &bytes_written);
-    ASSERT_FATAL_PRINT(bytes_written == sizeof(uint8_t), "Failed to patch byte at 0x%p!", in);
+    Hook_Write_Memory(in, &byte, sizeof(uint8_t));
 }
 
 inline void Patch_Word(uintptr_t in, uint16_t word)
 {
-    SIZE_T bytes_written;
-    WriteProcessMemory(GetCurrentProcess(), (LPVOID)in, &word, sizeof(uint16_t), &bytes_written);
-    ASSERT_FATAL_PRINT(bytes_written == sizeof(uint16_t), "Failed to patch word at 0x%p!", in);
+    Hook_Write_Memory(in, &word, sizeof(uint16_t));
 }
 
 inline void Patch_Dword(uintptr_t in, uint32_t dword)
 {
-    SIZE_T bytes_written;
-    WriteProcessMemory(GetCurrentProcess(), (LPVOID)in, &dword, sizeof(uint32_t), &bytes_written);
-    ASSERT_FATAL_PRINT(bytes_written == sizeof(uint32_t), "Failed to patch dword at 0x%p!", in);
+    Hook_Write_Memory(in, &dword, sizeof(uint32_t));
 }
 
 inline void Patch_Byte_Range(uintptr_t in, uint8_t byte, int count = 1)
 {
-    SIZE_T bytes_written;
-    for (int i = 0; i < count; ++i) {
-        uintptr_t in_adj = in+i;
-        WriteProcessMemory(GetCurrentProcess(), (LPVOID)in_adj, &byte, sizeof(uint8_t), &bytes_written);
-        ASSERT_FATAL_PRINT(bytes_written == sizeof(uint8_t), "Failed to patch %d bytes at 0x%p!", count, in);
-    }
+    Hook_Fill_Memory(in, byte, count);
 }
 
 
@@ -176,25 +176,11 @@ __forceinline void Change_Address(uintptr_t addr, uintptr_t newaddr)
  */
 __forceinline void Change_Virtual_Address(uintptr_t addr, uintptr_t newaddr)
 {
-    //Patch_Dword(addr, newaddr);   // Fails when modifying .rdata segment.
-
     /**
-     *  We need to change the permissions for .rdata segment access on the fly, otherwise
-     *  it WriteProcessMemory will fail.
+     *  The table is in the .rdata segment, the patch writer changes the page
+     *  permissions itself, so this goes through the transaction like any other patch.
      */
-    bool success = false;
-    DWORD oldprotect;
-
-    success = VirtualProtect((LPVOID)addr, sizeof(uint32_t), PAGE_EXECUTE_READWRITE, &oldprotect);
-    ASSERT_FATAL_PRINT(success == true, "VirtualProtect failed to change permissions at 0x%p!", addr);
-
-    //std::memcpy((void *)addr, (void *)newaddr, sizeof(uint32_t));
-    SIZE_T bytes_written;
-    WriteProcessMemory(GetCurrentProcess(), (LPVOID)addr, &newaddr, sizeof(uint32_t), &bytes_written);
-    ASSERT_FATAL_PRINT(bytes_written == sizeof(uint32_t), "Failed to patch dword at 0x%p!", addr);
-
-    success = VirtualProtect((LPVOID)addr, sizeof(uint32_t), oldprotect, &oldprotect);
-    ASSERT_FATAL_PRINT(success == true, "VirtualProtect failed to restore permissions at 0x%p!", addr);
+    Hook_Write_Memory(addr, &newaddr, sizeof(uint32_t));
 }
 
 
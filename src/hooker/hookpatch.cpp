@@ -0,0 +1,287 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          HOOKPATCH.CPP
+ *
+ *  @brief         Platform independent staging of patch transactions.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "hookpatch.h"
+#include "hookpatch.h"
+#include "debughandler.h"
+#include <cstdlib>  // for std::qsort
+#include <cstring>
+
+
+HookPatchTableClass::HookPatchTableClass() :
+    PageSize(4096),
+    UnprotectFunc(nullptr),
+    ProtectFunc(nullptr),
+    FlushFunc(nullptr),
+    PatchCount(0),
+    OverlapCount(0),
+    IsApplied(false)
+{
+}
+
+
+/**
+ *  Set the page size and the functions used to change page protection and
+ *  flush the instruction cache when the table is applied.
+ */
+void HookPatchTableClass::Set_Memory_Functions(size_t page_size, HookUnprotectFuncPtr unprotect, HookProtectFuncPtr protect, HookFlushFuncPtr flush)
+{
+    PageSize = page_size;
+    UnprotectFunc = unprotect;
+    ProtectFunc = protect;
+    FlushFunc = flush;
+}
+
+
+/**
+ *  This compare function presumes that its parameters are pointing to PatchStruct.
+ */
+int __cdecl HookPatchTableClass::address_compare_func(const void *ptr1, const void *ptr2)
+{
+    const PatchStruct *p1 = static_cast<const PatchStruct *>(ptr1);
+    const PatchStruct *p2 = static_cast<const PatchStruct *>(ptr2);
+
+    if (p1->Address != p2->Address) {
+        return (p1->Address < p2->Address) ? -1 : 1;
+    }
+    return 0;
+}
+
+
+/**
+ *  Stage a patch. Returns false if the table is full, or has been applied
+ *  and not yet cleared.
+ */
+bool HookPatchTableClass::Stage(uintptr_t address, const void *data, int size)
+{
+    /**
+     *  The table can not take more patches once it has been applied, it must
+     *  be cleared first so the rollback record is not mixed with new patches.
+     */
+    if (IsApplied) {
+        return false;
+    }
+
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+    while (size > 0) {
+
+        if (PatchCount >= HOOK_PATCH_TABLE_SIZE) {
+            return false;
+        }
+
+        int chunk = (size < HOOK_PATCH_CHUNK_SIZE) ? size : HOOK_PATCH_CHUNK_SIZE;
+
+        PatchStruct &patch = Patches[PatchCount++];
+        patch.Address = address;
+        patch.Size = chunk;
+        std::memcpy(patch.Bytes, bytes, chunk);
+
+        address += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+
+    return true;
+}
+
+
+/**
+ *  Sorts the table by address and gathers the pages written to into runs of
+ *  contiguous pages. Every pair of overlapping patches is reported, if there
+ *  are any, -1 is returned. Otherwise returns the run count.
+ */
+int HookPatchTableClass::Build_Page_Runs()
+{
+    const uintptr_t page_mask = ~(uintptr_t(PageSize) - 1);
+
+    std::qsort(Patches, PatchCount, sizeof(PatchStruct), address_compare_func);
+
+    OverlapCount = 0;
+
+    int run_count = 0;
+    int prev = -1;
+
+    for (int i = 0; i < PatchCount; ++i) {
+        const PatchStruct &patch = Patches[i];
+
+        if (prev != -1 && Patches[prev].Address + Patches[prev].Size > patch.Address) {
+            DEBUG_ERROR("Hooker: Patch at 0x%08X overlaps patch at 0x%08X!\n", patch.Address, Patches[prev].Address);
+            ++OverlapCount;
+        }
+
+        if (prev == -1 || patch.Address + patch.Size > Patches[prev].Address + Patches[prev].Size) {
+            prev = i;
+        }
+
+        uintptr_t first_page = patch.Address & page_mask;
+        uintptr_t end_page = ((patch.Address + patch.Size - 1) & page_mask) + PageSize;
+
+        if (run_count > 0) {
+            PageRunStruct &run = PageRuns[run_count-1];
+            if (first_page <= run.Address + run.Size) {
+                if (end_page > run.Address + run.Size) {
+                    run.Size = end_page - run.Address;
+                }
+                continue;
+            }
+        }
+
+        PageRunStruct &run = PageRuns[run_count++];
+        run.Address = first_page;
+        run.Size = end_page - first_page;
+        run.OldProtect = 0;
+    }
+
+    return OverlapCount ? -1 : run_count;
+}
+
+
+/**
+ *  Make the page runs writable. If any run fails, the runs changed so far
+ *  are restored and false is returned.
+ */
+bool HookPatchTableClass::Unprotect_Page_Runs(int run_count)
+{
+    for (int i = 0; i < run_count; ++i) {
+        PageRunStruct &run = PageRuns[i];
+        if (!UnprotectFunc(run.Address, run.Size, run.OldProtect)) {
+            DEBUG_ERROR("Hooker: Failed to change permissions for patches at 0x%08X!\n", run.Address);
+            Protect_Page_Runs(i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ *  Restore the protection of the page runs.
+ */
+void HookPatchTableClass::Protect_Page_Runs(int run_count)
+{
+    for (int i = 0; i < run_count; ++i) {
+        ProtectFunc(PageRuns[i].Address, PageRuns[i].Size, PageRuns[i].OldProtect);
+    }
+}
+
+
+/**
+ *  Applies all the staged patches, either all of them are written or none are.
+ */
+bool HookPatchTableClass::Apply()
+{
+    if (IsApplied) {
+        return false;
+    }
+
+    if (!PatchCount) {
+        IsApplied = true;
+        return true;
+    }
+
+    int run_count = Build_Page_Runs();
+
+    if (run_count < 0) {
+        DEBUG_ERROR("Hooker: %d overlapping patches, nothing was written!\n", OverlapCount);
+        return false;
+    }
+
+    if (!Unprotect_Page_Runs(run_count)) {
+        return false;
+    }
+
+    /**
+     *  No two patches write the same byte, so the order they are written in
+     *  does not matter. The bytes each one replaces are kept for Rollback.
+     */
+    for (int i = 0; i < PatchCount; ++i) {
+        PatchStruct &patch = Patches[i];
+        std::memcpy(patch.Original, (const void *)patch.Address, patch.Size);
+        std::memcpy((void *)patch.Address, patch.Bytes, patch.Size);
+    }
+
+    Protect_Page_Runs(run_count);
+
+    uintptr_t low = PageRuns[0].Address;
+    uintptr_t high = PageRuns[run_count-1].Address + PageRuns[run_count-1].Size;
+    FlushFunc(low, high - low);
+
+    IsApplied = true;
+
+    return true;
+}
+
+
+/**
+ *  Discards the staged patches. If the table has been applied, the bytes
+ *  each patch replaced are written back first.
+ */
+bool HookPatchTableClass::Rollback()
+{
+    bool success = true;
+
+    if (IsApplied && PatchCount > 0) {
+
+        /**
+         *  The table is still sorted from Apply, and was checked for overlaps,
+         *  so this only gathers the page runs again.
+         */
+        int run_count = Build_Page_Runs();
+
+        if (run_count > 0 && Unprotect_Page_Runs(run_count)) {
+
+            for (int i = 0; i < PatchCount; ++i) {
+                const PatchStruct &patch = Patches[i];
+                std::memcpy((void *)patch.Address, patch.Original, patch.Size);
+            }
+
+            Protect_Page_Runs(run_count);
+
+            uintptr_t low = PageRuns[0].Address;
+            uintptr_t high = PageRuns[run_count-1].Address + PageRuns[run_count-1].Size;
+            FlushFunc(low, high - low);
+
+        } else {
+            success = false;
+        }
+    }
+
+    Clear();
+
+    return success;
+}
+
+
+/**
+ *  Empties the table, after this an applied transaction can no longer be rolled back.
+ */
+void HookPatchTableClass::Clear()
+{
+    PatchCount = 0;
+    OverlapCount = 0;
+    IsApplied = false;
+}
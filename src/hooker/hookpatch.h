@@ -0,0 +1,122 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          HOOKPATCH.H
+ *
+ *  @brief         Platform independent staging of patch transactions.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+
+
+/**
+ *  The most bytes held by a single staged patch, larger writes are split.
+ */
+#define HOOK_PATCH_CHUNK_SIZE   16
+
+/**
+ *  The number of patches that can be staged in one transaction.
+ */
+#define HOOK_PATCH_TABLE_SIZE   8192
+
+
+/**
+ *  The memory functions used to apply a transaction. The protection functions
+ *  work on whole page runs, the old protection value is opaque to the table.
+ */
+typedef bool (*HookUnprotectFuncPtr)(uintptr_t address, size_t size, unsigned long &old_protect);
+typedef void (*HookProtectFuncPtr)(uintptr_t address, size_t size, unsigned long protect);
+typedef void (*HookFlushFuncPtr)(uintptr_t address, size_t size);
+
+
+/**
+ *  Stages the patches of a transaction and applies them as one.
+ *
+ *  Applying first checks that no two patches write the same byte, as the
+ *  result would depend on the order the hooks were set up in. It then
+ *  unprotects each run of affected pages once, writes the patches and
+ *  restores the page protection before flushing the instruction cache. If
+ *  any patches overlap or any page can not be unprotected, nothing is
+ *  written.
+ *
+ *  The bytes each patch replaces are recorded as it is written, so the
+ *  transaction can be rolled back until the table is cleared.
+ *
+ *  This has no dependency on the platform, the memory functions are passed
+ *  in, so it can be tested against a fake memory image.
+ */
+class HookPatchTableClass
+{
+    public:
+        HookPatchTableClass();
+
+        void Set_Memory_Functions(size_t page_size, HookUnprotectFuncPtr unprotect, HookProtectFuncPtr protect, HookFlushFuncPtr flush);
+
+        bool Stage(uintptr_t address, const void *data, int size);
+
+        bool Apply();
+        bool Rollback();
+        void Clear();
+
+        int Count() const { return PatchCount; }
+        int Overlap_Count() const { return OverlapCount; }
+        bool Is_Applied() const { return IsApplied; }
+
+    private:
+        struct PatchStruct
+        {
+            uintptr_t Address;
+            int Size;
+            uint8_t Bytes[HOOK_PATCH_CHUNK_SIZE];
+            uint8_t Original[HOOK_PATCH_CHUNK_SIZE];    // Recorded when the patch is written.
+        };
+
+        struct PageRunStruct
+        {
+            uintptr_t Address;
+            size_t Size;
+            unsigned long OldProtect;
+        };
+
+        int Build_Page_Runs();
+        bool Unprotect_Page_Runs(int run_count);
+        void Protect_Page_Runs(int run_count);
+
+        static int __cdecl address_compare_func(const void *ptr1, const void *ptr2);
+
+    private:
+        size_t PageSize;
+        HookUnprotectFuncPtr UnprotectFunc;
+        HookProtectFuncPtr ProtectFunc;
+        HookFlushFuncPtr FlushFunc;
+
+        /**
+         *  The tables live in the instance, which is expected to be in static
+         *  storage as patches are applied from DllMain, before it is safe to
+         *  rely on the heap.
+         */
+        PatchStruct Patches[HOOK_PATCH_TABLE_SIZE];
+        PageRunStruct PageRuns[HOOK_PATCH_TABLE_SIZE];
+        int PatchCount;
+        int OverlapCount;
+        bool IsApplied;
+};
@@ -0,0 +1,264 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          FRAMEPACER.CPP
+ *
+ *  @brief         High resolution frame pacing and frame time statistics.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "framepacer.h"
+#include "debughandler.h"
+#include "asserthandler.h"
+#include <cstdlib>  // for std::qsort
+#include <cstring>
+
+
+/**
+ *  Not defined in older SDKs, supported from Windows 10 1803.
+ */
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION   0x00000002
+#endif
+
+/**
+ *  How long before the deadline to stop waiting on the timer and start spinning,
+ *  in microseconds. The standard timer can wake up to a scheduler tick late.
+ */
+#define FRAME_PACER_SPIN_HIGH_RESOLUTION    500
+#define FRAME_PACER_SPIN_STANDARD           2000
+
+
+FramePacerClass::ClockFuncPtr FramePacerClass::Clock = nullptr;
+HANDLE FramePacerClass::Timer = nullptr;
+bool FramePacerClass::IsHighResolution = false;
+LONGLONG FramePacerClass::Frequency = 0;
+LONGLONG FramePacerClass::NextDeadline = 0;
+LONGLONG FramePacerClass::LastFrameTime = 0;
+LONGLONG FramePacerClass::History[FRAME_PACER_HISTORY_SIZE];
+int FramePacerClass::HistoryCount = 0;
+int FramePacerClass::HistoryIndex = 0;
+int FramePacerClass::MissedDeadlines = 0;
+
+
+/**
+ *  This compare function presumes that its parameters are pointing to LONGLONG.
+ */
+static int __cdecl frame_time_compare_func(const void *ptr1, const void *ptr2)
+{
+    LONGLONG t1 = *static_cast<const LONGLONG *>(ptr1);
+    LONGLONG t2 = *static_cast<const LONGLONG *>(ptr2);
+
+    if (t1 != t2) {
+        return (t1 < t2) ? -1 : 1;
+    }
+    return 0;
+}
+
+
+/**
+ *  Create the waitable timer used for pacing.
+ */
+void FramePacerClass::Init()
+{
+    if (Timer) {
+        return;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    Frequency = frequency.QuadPart;
+
+    Timer = CreateWaitableTimerEx(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    IsHighResolution = (Timer != nullptr);
+
+    if (!Timer) {
+        Timer = CreateWaitableTimerEx(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+
+    if (!Timer) {
+        DEV_DEBUG_WARNING("FramePacer: Failed to create waitable timer, pacing will spin!\n");
+    }
+
+    NextDeadline = 0;
+    Reset_Statistics();
+}
+
+
+/**
+ *  Replace the performance counter with another clock, used to test the pacing
+ *  against a simulated clock. Passing nullptr restores the performance counter.
+ */
+void FramePacerClass::Set_Clock(ClockFuncPtr clock, LONGLONG frequency)
+{
+    Clock = clock;
+
+    if (Clock) {
+        Frequency = frequency;
+    } else {
+        LARGE_INTEGER counter_frequency;
+        QueryPerformanceFrequency(&counter_frequency);
+        Frequency = counter_frequency.QuadPart;
+    }
+
+    NextDeadline = 0;
+    Reset_Statistics();
+}
+
+
+/**
+ *  Fetch the current performance counter value.
+ */
+LONGLONG FramePacerClass::Now()
+{
+    if (Clock) {
+        return Clock();
+    }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+
+/**
+ *  Block until the start of the next frame at the requested rate.
+ */
+void FramePacerClass::Wait_For_Frame(int rate)
+{
+    if (!Frequency) {
+        Init();
+    }
+
+    if (rate <= 0) {
+        return;
+    }
+
+    LONGLONG period = Frequency / rate;
+    LONGLONG now = Now();
+
+    /**
+     *  Deadlines are scheduled from the previous deadline, not from when the
+     *  frame finished, so the rate does not drift. The first frame has no
+     *  previous deadline, so it can not have missed it.
+     */
+    bool is_first = (NextDeadline == 0);
+
+    NextDeadline += period;
+
+    if (now > NextDeadline) {
+
+        if (!is_first) {
+            ++MissedDeadlines;
+        }
+
+        /**
+         *  If the loop has fallen more than a whole frame behind then start
+         *  over from now rather than trying to catch up with a burst of frames.
+         */
+        if (now - NextDeadline > period) {
+            NextDeadline = now;
+        }
+
+        return;
+    }
+
+    LONGLONG spin = (Frequency * (IsHighResolution ? FRAME_PACER_SPIN_HIGH_RESOLUTION : FRAME_PACER_SPIN_STANDARD)) / 1000000;
+
+    /**
+     *  Sleep on the timer for the bulk of the wait. Waitable timer due times
+     *  are in 100 nanosecond units, negative for a relative time.
+     */
+    LONGLONG remaining = NextDeadline - now - spin;
+    if (Timer && !Clock && remaining > 0) {
+        LARGE_INTEGER due;
+        due.QuadPart = -((remaining * 10000000) / Frequency);
+        if (due.QuadPart < 0 && SetWaitableTimer(Timer, &due, 0, nullptr, nullptr, FALSE)) {
+            WaitForSingleObject(Timer, INFINITE);
+        }
+    }
+
+    /**
+     *  Spin out the remainder.
+     */
+    while (Now() < NextDeadline) {
+        YieldProcessor();
+    }
+}
+
+
+/**
+ *  Record the time since the previous call as a frame time.
+ */
+void FramePacerClass::Record_Frame()
+{
+    if (!Frequency) {
+        Init();
+    }
+
+    LONGLONG now = Now();
+
+    if (LastFrameTime) {
+        History[HistoryIndex] = now - LastFrameTime;
+        HistoryIndex = (HistoryIndex + 1) % FRAME_PACER_HISTORY_SIZE;
+        if (HistoryCount < FRAME_PACER_HISTORY_SIZE) {
+            ++HistoryCount;
+        }
+    }
+
+    LastFrameTime = now;
+}
+
+
+/**
+ *  Clear the recorded frame times and missed deadline count.
+ */
+void FramePacerClass::Reset_Statistics()
+{
+    LastFrameTime = 0;
+    HistoryCount = 0;
+    HistoryIndex = 0;
+    MissedDeadlines = 0;
+}
+
+
+/**
+ *  Calculates the frame time statistics from the recorded history.
+ */
+FramePacerClass::StatisticsStruct FramePacerClass::Get_Statistics()
+{
+    StatisticsStruct stats;
+    stats.Median = 0.0;
+    stats.Percentile99 = 0.0;
+    stats.Samples = HistoryCount;
+    stats.MissedDeadlines = MissedDeadlines;
+
+    if (!HistoryCount || !Frequency) {
+        return stats;
+    }
+
+    LONGLONG sorted[FRAME_PACER_HISTORY_SIZE];
+    std::memcpy(sorted, History, HistoryCount * sizeof(LONGLONG));
+    std::qsort(sorted, HistoryCount, sizeof(LONGLONG), frame_time_compare_func);
+
+    stats.Median = (double)sorted[HistoryCount / 2] * 1000.0 / (double)Frequency;
+    stats.Percentile99 = (double)sorted[(HistoryCount * 99) / 100] * 1000.0 / (double)Frequency;
+
+    return stats;
+}
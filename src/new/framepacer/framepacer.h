@@ -0,0 +1,118 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          FRAMEPACER.H
+ *
+ *  @brief         High resolution frame pacing and frame time statistics.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+#include <Windows.h>
+
+
+/**
+ *  The number of recent frame times kept for the statistics.
+ */
+#define FRAME_PACER_HISTORY_SIZE    256
+
+
+/**
+ *  Paces a loop to a fixed rate without spinning on Sleep(1).
+ *
+ *  The wait is split in two; the bulk of it is spent blocked on a waitable
+ *  timer (high resolution where the system supports it), then the last
+ *  fraction of a millisecond is spun on the performance counter so the loop
+ *  wakes on the deadline rather than on the next scheduler tick.
+ *
+ *  The time between frames is also recorded so the median and 99th percentile
+ *  frame times, and the number of missed deadlines, can be reported.
+ */
+class FramePacerClass
+{
+    public:
+        struct StatisticsStruct
+        {
+            double Median;          // Median frame time, in milliseconds.
+            double Percentile99;    // 99th percentile frame time, in milliseconds.
+            int Samples;            // Number of frame times the above are from.
+            int MissedDeadlines;    // Number of paced frames that woke after their deadline.
+        };
+
+        /**
+         *  Returns the current time, in ticks of the clock frequency.
+         */
+        typedef LONGLONG (*ClockFuncPtr)();
+
+    public:
+        static void Init();
+        static void Set_Clock(ClockFuncPtr clock, LONGLONG frequency);
+
+        static void Wait_For_Frame(int rate);
+        static void Record_Frame();
+        static void Reset_Statistics();
+
+        static StatisticsStruct Get_Statistics();
+
+    private:
+        static LONGLONG Now();
+
+    private:
+        /**
+         *  The clock used in place of the performance counter, if set. The
+         *  waitable timer runs on real time, so it is not used with this clock.
+         */
+        static ClockFuncPtr Clock;
+
+        /**
+         *  The waitable timer used for the coarse part of the wait.
+         */
+        static HANDLE Timer;
+
+        /**
+         *  Does the timer support high resolution waits?
+         */
+        static bool IsHighResolution;
+
+        /**
+         *  Performance counter ticks per second.
+         */
+        static LONGLONG Frequency;
+
+        /**
+         *  The deadline of the next paced frame, in performance counter ticks.
+         */
+        static LONGLONG NextDeadline;
+
+        /**
+         *  The time the previous frame was recorded, in performance counter ticks.
+         */
+        static LONGLONG LastFrameTime;
+
+        /**
+         *  Ring of recent frame times, in performance counter ticks.
+         */
+        static LONGLONG History[FRAME_PACER_HISTORY_SIZE];
+        static int HistoryCount;
+        static int HistoryIndex;
+
+        static int MissedDeadlines;
+};
@@ -0,0 +1,171 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          KAMIKAZEINDEX.CPP
+ *
+ *  @brief         Maps tracked aircraft to their kamikaze control.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "kamikazeindex.h"
+#include <cstring>
+
+
+/**
+ *  The table grows when it is more than half full, so probes stay short.
+ */
+#define KAMIKAZE_INDEX_MIN_SIZE     64
+
+
+KamikazeIndexClass::KamikazeIndexClass() :
+    Entries(nullptr),
+    Size(0),
+    ActiveCount(0)
+{
+}
+
+
+KamikazeIndexClass::~KamikazeIndexClass()
+{
+    delete [] Entries;
+    Entries = nullptr;
+}
+
+
+/**
+ *  Returns the slot the aircraft is in, or the empty slot where it would go.
+ */
+int KamikazeIndexClass::Slot_Of(AircraftClass const *aircraft) const
+{
+    /**
+     *  Objects are at least 16 byte aligned, so the low bits carry nothing.
+     */
+    uint32_t hash = uint32_t(uintptr_t(aircraft) >> 4) * 2654435769u;
+    int mask = Size - 1;
+    int slot = int(hash >> 8) & mask;
+
+    while (Entries[slot].Aircraft && Entries[slot].Aircraft != aircraft) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+
+/**
+ *  Returns the control index of the aircraft, or -1 if it is not in the table.
+ */
+int KamikazeIndexClass::Find(AircraftClass const *aircraft) const
+{
+    if (!aircraft || !ActiveCount) {
+        return -1;
+    }
+
+    const EntryStruct &entry = Entries[Slot_Of(aircraft)];
+    return entry.Aircraft ? entry.Index : -1;
+}
+
+
+/**
+ *  Adds the aircraft to the table, or updates its control index.
+ */
+void KamikazeIndexClass::Set(AircraftClass const *aircraft, int index)
+{
+    if (!aircraft) {
+        return;
+    }
+
+    if ((ActiveCount + 1) * 2 > Size) {
+        Resize(Size ? Size * 2 : KAMIKAZE_INDEX_MIN_SIZE);
+    }
+
+    EntryStruct &entry = Entries[Slot_Of(aircraft)];
+    if (!entry.Aircraft) {
+        entry.Aircraft = aircraft;
+        ++ActiveCount;
+    }
+    entry.Index = index;
+}
+
+
+/**
+ *  Removes the aircraft from the table.
+ */
+void KamikazeIndexClass::Remove(AircraftClass const *aircraft)
+{
+    if (!aircraft || !ActiveCount) {
+        return;
+    }
+
+    int slot = Slot_Of(aircraft);
+    if (!Entries[slot].Aircraft) {
+        return;
+    }
+
+    Entries[slot].Aircraft = nullptr;
+    --ActiveCount;
+
+    /**
+     *  Move back any following entries that can no longer be reached past
+     *  the new hole, so no tombstones are needed.
+     */
+    int mask = Size - 1;
+    for (int next = (slot + 1) & mask; Entries[next].Aircraft; next = (next + 1) & mask) {
+
+        EntryStruct moved = Entries[next];
+        Entries[next].Aircraft = nullptr;
+
+        EntryStruct &entry = Entries[Slot_Of(moved.Aircraft)];
+        entry = moved;
+    }
+}
+
+
+/**
+ *  Removes every aircraft from the table, keeping the storage.
+ */
+void KamikazeIndexClass::Clear()
+{
+    if (Entries) {
+        std::memset(Entries, 0, sizeof(EntryStruct) * Size);
+    }
+    ActiveCount = 0;
+}
+
+
+/**
+ *  Reallocates the table and inserts the existing entries again.
+ */
+void KamikazeIndexClass::Resize(int size)
+{
+    EntryStruct *old_entries = Entries;
+    int old_size = Size;
+
+    Entries = new EntryStruct[size];
+    std::memset(Entries, 0, sizeof(EntryStruct) * size);
+    Size = size;
+
+    for (int i = 0; i < old_size; ++i) {
+        if (old_entries[i].Aircraft) {
+            Entries[Slot_Of(old_entries[i].Aircraft)] = old_entries[i];
+        }
+    }
+
+    delete [] old_entries;
+}
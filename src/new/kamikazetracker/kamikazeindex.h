@@ -0,0 +1,76 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          KAMIKAZEINDEX.H
+ *
+ *  @brief         Maps tracked aircraft to their kamikaze control.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <cstdint>
+
+
+class AircraftClass;
+
+
+/**
+ *  An open addressing table from an aircraft to the index of its control in
+ *  the kamikaze tracker. The table holds no state that is saved, the tracker
+ *  rebuilds it from its controls when needed.
+ */
+class KamikazeIndexClass
+{
+    public:
+        KamikazeIndexClass();
+        ~KamikazeIndexClass();
+
+        int Find(AircraftClass const *aircraft) const;
+        void Set(AircraftClass const *aircraft, int index);
+        void Remove(AircraftClass const *aircraft);
+        void Clear();
+
+        int Count() const { return ActiveCount; }
+
+    private:
+        struct EntryStruct
+        {
+            AircraftClass const *Aircraft;
+            int Index;
+        };
+
+        int Slot_Of(AircraftClass const *aircraft) const;
+        void Resize(int size);
+
+        KamikazeIndexClass(const KamikazeIndexClass &) = delete;
+        KamikazeIndexClass &operator=(const KamikazeIndexClass &) = delete;
+
+    private:
+        /**
+         *  The slots of the table, the size is always a power of two.
+         */
+        EntryStruct *Entries;
+        int Size;
+
+        /**
+         *  The number of aircraft in the table.
+         */
+        int ActiveCount;
+};
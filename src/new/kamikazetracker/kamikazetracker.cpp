@@ -37,6 +37,11 @@
 #include "mouse.h"
 #include "vinifera_globals.h"
 #include "vinifera_saveload.h"
+#include "asserthandler.h"
+
+
+KamikazeIndexClass KamikazeTrackerClass::ControlIndex;
+bool KamikazeTrackerClass::IsIndexValid = true;
 
 
 /**
@@ -46,8 +51,7 @@
  */
 KamikazeTrackerClass::~KamikazeTrackerClass()
 {
-    for (int i = 0; i < Controls.Count(); i++)
-        delete Controls[i];
+    ControlIndex.Clear();
 }
 
 
@@ -95,18 +99,26 @@ HRESULT KamikazeTrackerClass::Load(IStream* pStm)
     if (FAILED(hr))
         return hr;
 
-    new (&Controls) DynamicVectorClass<KamikazeControl*>();
+    new (&Controls) DynamicVectorClass<KamikazeControl>();
+
+    /**
+     *  The index is rebuilt from the controls the next time it is used.
+     */
+    ControlIndex.Clear();
+    IsIndexValid = false;
 
     if (count <= 0)
         return hr;
 
+    Controls.Set_Growth_Step(count);
+
     /**
      *  Read each of the controls as a binary blob.
      */
     for (int index = 0; index < count; ++index)
     {
-        const auto control = new KamikazeControl;
-        hr = pStm->Read(control, sizeof(KamikazeControl), nullptr);
+        KamikazeControl control;
+        hr = pStm->Read(&control, sizeof(KamikazeControl), nullptr);
         if (FAILED(hr))
             return hr;
         Controls.Add(control);
@@ -114,8 +126,8 @@ HRESULT KamikazeTrackerClass::Load(IStream* pStm)
 
     for (int index = 0; index < count; index++)
     {
-        VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(Controls[index]->Aircraft, "Aircraft");
-        VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(Controls[index]->Cell, "Cell");
+        VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(Controls[index].Aircraft, "Aircraft");
+        VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(Controls[index].Cell, "Cell");
     }
 
     return hr;
@@ -172,7 +184,7 @@ HRESULT KamikazeTrackerClass::Save(IStream* pStm, BOOL fClearDirty)
      */
     for (int index = 0; index < count; ++index)
     {
-        hr = pStm->Write(Controls[index], sizeof(KamikazeControl), nullptr);
+        hr = pStm->Write(&Controls[index], sizeof(KamikazeControl), nullptr);
         if (FAILED(hr))
             return hr;
     }
@@ -194,14 +206,29 @@ void KamikazeTrackerClass::Add(AircraftClass* aircraft, TARGET target)
         return;
     }
 
-    const auto control = new KamikazeControl();
-    control->Aircraft = aircraft;
-    control->Cell = target == nullptr ?
+    CellClass* cell = target == nullptr ?
         &aircraft->Get_Cell_Ptr()->Adjacent_Cell(Dir_Facing(aircraft->PrimaryFacing.Current().Get_Dir())) :
         &Map[Coord_Cell(target->Center_Coord())];
+
     aircraft->IsKamikaze = true;
     aircraft->Ammo = 1;
+
+    /**
+     *  If the aircraft is already being tracked, just retarget it.
+     */
+    const int index = Index_Of(aircraft);
+    if (index != -1)
+    {
+        Controls[index].Cell = cell;
+        return;
+    }
+
+    KamikazeControl control;
+    control.Aircraft = aircraft;
+    control.Cell = cell;
     Controls.Add(control);
+
+    ControlIndex.Set(aircraft, Controls.Count() - 1);
 }
 
 
@@ -219,9 +246,9 @@ void KamikazeTrackerClass::AI()
 
     for (int i = 0; i < Controls.Count(); i++)
     {
-        const auto control = Controls[i];
-        CellClass* cell = control->Cell;
-        AircraftClass* aircraft = control->Aircraft;
+        const auto& control = Controls[i];
+        CellClass* cell = control.Cell;
+        AircraftClass* aircraft = control.Aircraft;
 
         aircraft->Ammo = 1;
         if (cell)
@@ -241,16 +268,63 @@ void KamikazeTrackerClass::AI()
  */
 void KamikazeTrackerClass::Detach(AircraftClass const* aircraft)
 {
+    const int index = Index_Of(aircraft);
+    if (index == -1)
+        return;
+
+    /**
+     *  Move the last control into the vacated slot.
+     */
+    const int last = Controls.Count() - 1;
+    if (index != last)
+    {
+        Controls[index] = Controls[last];
+        ControlIndex.Set(Controls[index].Aircraft, index);
+    }
+
+    Controls.Delete(last);
+    ControlIndex.Remove(aircraft);
+}
+
+
+/**
+ *  Returns the index of the aircraft's control, or -1 if it is not tracked.
+ *
+ *  @author: ZivDero
+ */
+int KamikazeTrackerClass::Index_Of(AircraftClass const* aircraft) const
+{
+    /**
+     *  Only aircraft that have been added to the tracker are marked as kamikaze,
+     *  this filters out almost every aircraft without a table lookup.
+     */
+    if (aircraft == nullptr || !aircraft->IsKamikaze)
+        return -1;
+
+    if (!IsIndexValid)
+        Rebuild_Index();
+
+    const int index = ControlIndex.Find(aircraft);
+
+    ASSERT(index == -1 || (index < Controls.Count() && Controls[index].Aircraft == aircraft));
+
+    return index;
+}
+
+
+/**
+ *  Rebuilds the aircraft to control index table from the controls.
+ */
+void KamikazeTrackerClass::Rebuild_Index() const
+{
+    ControlIndex.Clear();
+
     for (int i = 0; i < Controls.Count(); i++)
     {
-        const auto control = Controls[i];
-        if (control->Aircraft == aircraft)
-        {
-            delete control;
-            Controls.Delete(control);
-            return;
-        }
+        ControlIndex.Set(Controls[i].Aircraft, i);
     }
+
+    IsIndexValid = true;
 }
 
 
@@ -261,10 +335,9 @@ void KamikazeTrackerClass::Detach(AircraftClass const* aircraft)
  */
 void KamikazeTrackerClass::Clear()
 {
-    for (int i = 0; i  < Controls.Count(); i++)
-        delete Controls[i];
-
     Controls.Clear();
+    ControlIndex.Clear();
+    IsIndexValid = true;
     UpdateTimer.Start();
     UpdateTimer = 1;
 }
@@ -31,6 +31,7 @@
 #include "ftimer.h"
 #include "ttimer.h"
 #include "vector.h"
+#include "kamikazeindex.h"
 
 class AircraftClass;
 class CellClass;
@@ -42,6 +43,9 @@ public:
     struct KamikazeControl {
         AircraftClass* Aircraft;
         CellClass* Cell;
+
+        bool operator==(const KamikazeControl &that) const { return Aircraft == that.Aircraft && Cell == that.Cell; }
+        bool operator!=(const KamikazeControl &that) const { return Aircraft != that.Aircraft || Cell != that.Cell; }
     };
 
     KamikazeTrackerClass() noexcept : UpdateTimer(100), Controls() { }
@@ -55,6 +59,10 @@ public:
     void Detach(AircraftClass const* aircraft);
     void Clear();
 
+private:
+    int Index_Of(AircraftClass const* aircraft) const;
+    void Rebuild_Index() const;
+
     KamikazeTrackerClass(const KamikazeTrackerClass&) = delete;
     KamikazeTrackerClass& operator= (const KamikazeTrackerClass&) = delete;
 
@@ -65,7 +73,23 @@ public:
     CDTimerClass<FrameTimerClass> UpdateTimer;
 
     /**
-     *  The vector that contains all kamikaze controls.
+     *  The vector that contains all kamikaze controls. The controls are stored
+     *  densely, ControlIndex maps each tracked aircraft to its control so it
+     *  can be removed without a search.
+     */
+    DynamicVectorClass<KamikazeControl> Controls;
+
+private:
+    /**
+     *  The aircraft to control index table. This is static so it is not part
+     *  of the binary blob written by Save, and does not change the size of
+     *  this class, which is part of the save version.
+     */
+    static KamikazeIndexClass ControlIndex;
+
+    /**
+     *  Does ControlIndex match Controls? Cleared by Load, as the aircraft
+     *  pointers are only remapped after Load has returned.
      */
-    DynamicVectorClass<KamikazeControl*> Controls;
+    static bool IsIndexValid;
 };
@@ -0,0 +1,182 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          MIXPREFETCH.CPP
+ *
+ *  @brief         Background read-ahead of mixfiles during startup.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "mixprefetch.h"
+#include "debughandler.h"
+#include "asserthandler.h"
+#include <cstdio>
+
+
+HANDLE MixPrefetchClass::Thread = nullptr;
+volatile LONG MixPrefetchClass::IsCancelled = FALSE;
+
+
+/**
+ *  The size of the read buffer used by the worker thread.
+ */
+#define MIX_PREFETCH_CHUNK_SIZE     (256 * 1024)
+
+/**
+ *  How much of a mixfile to read when only the header is wanted. This covers
+ *  the header and index of all the retail mixfiles.
+ */
+#define MIX_PREFETCH_HEADER_SIZE    (64 * 1024)
+
+
+/**
+ *  The mixfiles to prefetch, in the order they are registered by the bootstrap
+ *  and secondary mixfile init.
+ */
+static const struct {
+    const char *Pattern;
+    bool WholeFile;
+} PrefetchList[] = {
+    { "PATCH.MIX",      false },
+    { "PCACHE.MIX",     true },
+    { "EXPAND*.MIX",    false },
+    { "ECACHE*.MIX",    true },
+    { "ELOCAL*.MIX",    false },
+    { "TIBSUN.MIX",     false },
+    { "CACHE.MIX",      true },
+    { "LOCAL.MIX",      false },
+    { "GENERIC.MIX",    true },
+    { "ISOGEN.MIX",     true },
+    { "CONQUER.MIX",    false },
+    { "MAPS*.MIX",      false },
+    { "MULTI.MIX",      false },
+    { "SOUNDS*.MIX",    false },
+    { "SCORES*.MIX",    false },
+    { "MOVIES*.MIX",    false }
+};
+
+
+/**
+ *  Start the prefetch worker thread.
+ */
+void MixPrefetchClass::Start()
+{
+    if (Thread) {
+        return;
+    }
+
+    InterlockedExchange(&IsCancelled, FALSE);
+
+    Thread = CreateThread(nullptr, 0, Prefetch_Thread, nullptr, 0, nullptr);
+    if (!Thread) {
+        DEV_DEBUG_WARNING("MixPrefetch: Failed to create worker thread!\n");
+        return;
+    }
+
+    /**
+     *  The worker should never compete with the main thread for the CPU.
+     */
+    SetThreadPriority(Thread, THREAD_PRIORITY_BELOW_NORMAL);
+}
+
+
+/**
+ *  Stop the prefetch worker thread and wait for it to exit.
+ */
+void MixPrefetchClass::Finish()
+{
+    if (!Thread) {
+        return;
+    }
+
+    InterlockedExchange(&IsCancelled, TRUE);
+
+    WaitForSingleObject(Thread, INFINITE);
+    CloseHandle(Thread);
+    Thread = nullptr;
+}
+
+
+/**
+ *  The worker thread entry point.
+ */
+DWORD WINAPI MixPrefetchClass::Prefetch_Thread(LPVOID param)
+{
+    for (int i = 0; i < int(sizeof(PrefetchList)/sizeof(PrefetchList[0])); ++i) {
+        if (IsCancelled) {
+            break;
+        }
+        Prefetch_Pattern(PrefetchList[i].Pattern, PrefetchList[i].WholeFile);
+    }
+
+    return 0;
+}
+
+
+/**
+ *  Prefetch all files that match the pattern in the current directory.
+ */
+void MixPrefetchClass::Prefetch_Pattern(const char *pattern, bool whole_file)
+{
+    WIN32_FIND_DATA data;
+
+    HANDLE find = FindFirstFile(pattern, &data);
+    if (find == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    do {
+        if (IsCancelled) {
+            break;
+        }
+        if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+            Prefetch_File(data.cFileName, whole_file);
+        }
+    } while (FindNextFile(find, &data));
+
+    FindClose(find);
+}
+
+
+/**
+ *  Read the file into the operating system file cache.
+ */
+void MixPrefetchClass::Prefetch_File(const char *filename, bool whole_file)
+{
+    static char buffer[MIX_PREFETCH_CHUNK_SIZE];
+
+    HANDLE handle = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    DWORD remaining = whole_file ? GetFileSize(handle, nullptr) : MIX_PREFETCH_HEADER_SIZE;
+
+    while (remaining > 0 && !IsCancelled) {
+        DWORD bytesread = 0;
+        DWORD toread = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
+        if (!ReadFile(handle, buffer, toread, &bytesread, nullptr) || bytesread == 0) {
+            break;
+        }
+        remaining -= bytesread;
+    }
+
+    CloseHandle(handle);
+}
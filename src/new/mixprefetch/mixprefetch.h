@@ -0,0 +1,63 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          MIXPREFETCH.H
+ *
+ *  @brief         Background read-ahead of mixfiles during startup.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+#include <Windows.h>
+
+
+/**
+ *  Warms the operating system file cache with the mixfiles the game is about
+ *  to register, so the main thread does not stall on disk seeks while it
+ *  decrypts each mixfile header in turn.
+ *
+ *  Mixfiles that are going to be cached are read in full, all others only have
+ *  their header region read. The worker thread only ever touches the files
+ *  through the Win32 file API, it does not interact with the mixfile system.
+ */
+class MixPrefetchClass
+{
+    public:
+        static void Start();
+        static void Finish();
+
+    private:
+        static DWORD WINAPI Prefetch_Thread(LPVOID param);
+
+        static void Prefetch_Pattern(const char *pattern, bool whole_file);
+        static void Prefetch_File(const char *filename, bool whole_file);
+
+    private:
+        /**
+         *  Handle to the background worker thread.
+         */
+        static HANDLE Thread;
+
+        /**
+         *  Set by the main thread to request the worker to stop early.
+         */
+        static volatile LONG IsCancelled;
+};
@@ -0,0 +1,319 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          OVERLAYLINE.CPP
+ *
+ *  @brief         Batched drawing of tactical overlay lines (action and NavCom lines).
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "overlayline.h"
+#include "tibsun_globals.h"
+#include "dsurface.h"
+#include "clipline.h"
+#include "rect.h"
+#include "debughandler.h"
+#include "asserthandler.h"
+#include <Windows.h>
+#include <timeapi.h>
+#include <iterator>
+
+
+OverlayLineClass::OverlayLineStruct OverlayLineClass::Lines[OVERLAY_LINE_MAX_BATCH];
+int OverlayLineClass::LineCount = 0;
+
+
+/**
+ *  4 pixels on, 4 off, 4 pixels on, 4 off.
+ */
+static bool DashPattern[] = { true, true, true, true, false, false, false, false, true, true, true, true, false, false, false, false };
+
+/**
+ *  5 pixels on, 3 off, 5 pixels on, 3 off.
+ */
+static bool PathPattern[] = { true, true, true, true, true, false, false, false, true, true, true, true, true, false, false, false };
+
+
+/**
+ *  Submits a line to be drawn by the next call to Draw_All.
+ *
+ *  @note: The points must already be in screen pixels, relative to the
+ *         surface. Clipping is performed when the batch is drawn. If no
+ *         surface is given, the line is drawn to the composite surface.
+ */
+void OverlayLineClass::Add(const Point2D &start, const Point2D &end, const OverlayLineStyleStruct &style, XSurface *surface)
+{
+    if (LineCount >= OVERLAY_LINE_MAX_BATCH) {
+        DEV_DEBUG_WARNING("OverlayLine: Batch limit reached, drawing early!\n");
+        Draw_All();
+    }
+
+    OverlayLineStruct &line = Lines[LineCount++];
+    line.Surface = surface;
+    line.Start = start;
+    line.End = end;
+    line.Style = style;
+}
+
+
+/**
+ *  Draws all the lines submitted since the last call, in submission order,
+ *  then empties the batch.
+ */
+void OverlayLineClass::Draw_All()
+{
+    if (!LineCount) {
+        return;
+    }
+
+    /**
+     *  All dashed lines animate off the same clock sample.
+     */
+    int time = timeGetTime();
+
+    /**
+     *  Hold a lock on each surface while its lines are drawn, the lock taken
+     *  by each line and rect fill below is then nested and does not reach
+     *  the driver. Lines for the same surface are usually submitted together,
+     *  so the lock is only changed when the surface does.
+     */
+    XSurface *locked_surface = nullptr;
+    bool locked = false;
+
+    for (int i = 0; i < LineCount; ++i) {
+        OverlayLineStruct &line = Lines[i];
+
+        XSurface *surface = line.Surface ? line.Surface : CompositeSurface;
+        if (!surface) {
+            continue;
+        }
+
+        if (surface != locked_surface) {
+            if (locked) {
+                locked_surface->Unlock();
+            }
+            locked_surface = surface;
+            locked = (surface->Lock() != nullptr);
+        }
+
+        if (line.Style.IsPath) {
+            Draw_Path_Line(surface, line, time);
+        } else {
+            Draw_Line(surface, line, time);
+        }
+    }
+
+    if (locked) {
+        locked_surface->Unlock();
+    }
+
+    Clear_All();
+}
+
+
+/**
+ *  Discards all the submitted lines without drawing them.
+ */
+void OverlayLineClass::Clear_All()
+{
+    LineCount = 0;
+}
+
+
+/**
+ *  Draws a single line with its start and end squares.
+ */
+void OverlayLineClass::Draw_Line(XSurface *surface, const OverlayLineStruct &line, int time)
+{
+    const OverlayLineStyleStruct &style = line.Style;
+
+    Point2D start_point = line.Start;
+    Point2D end_point = line.End;
+
+    int point_size = 3;
+    Point2D point_offset(-1, -1);
+
+    if (style.IsThick) {
+        point_size = 4;
+        point_offset = Point2D(-2, -2);
+    }
+
+    if (Clip_Line(&start_point, &end_point, &TacticalRect)) {
+
+        Point2D drop_start_point = start_point;
+        Point2D drop_end_point = end_point;
+
+        drop_start_point.Y += 1;
+        drop_end_point.Y += 1;
+
+        if (style.IsDashed) {
+
+            /**
+             *  Adjust the offset of the line pattern.
+             */
+            int offset = (-time / style.Rate) & (std::size(DashPattern) - 1);
+
+            /**
+             *  Draw the drop shadow line.
+             */
+            if (style.IsDropShadow) {
+
+                if (style.IsThick) {
+                    drop_start_point.Y += 1;
+                    drop_end_point.Y += 1;
+                }
+
+                surface->Draw_Dashed_Line(drop_start_point, drop_end_point, style.DropColor, DashPattern, offset);
+
+                if (style.IsThick) {
+                    drop_start_point.Y += 1;
+                    drop_end_point.Y += 1;
+                    surface->Draw_Dashed_Line(drop_start_point, drop_end_point, style.DropColor, DashPattern, offset);
+                }
+
+            }
+
+            /**
+             *  Draw the dashed line.
+             */
+            surface->Draw_Dashed_Line(start_point, end_point, style.Color, DashPattern, offset);
+
+            if (style.IsThick) {
+                start_point.Y += 1;
+                end_point.Y += 1;
+                surface->Draw_Dashed_Line(start_point, end_point, style.Color, DashPattern, offset);
+            }
+
+        } else {
+
+            /**
+             *  Draw the drop shadow line.
+             */
+            if (style.IsDropShadow) {
+
+                if (style.IsThick) {
+                    drop_start_point.Y += 1;
+                    drop_end_point.Y += 1;
+                }
+
+                surface->Draw_Line(drop_start_point, drop_end_point, style.DropColor);
+
+                if (style.IsThick) {
+                    drop_start_point.Y += 1;
+                    drop_end_point.Y += 1;
+                    surface->Draw_Line(drop_start_point, drop_end_point, style.DropColor);
+                }
+
+            }
+
+            /**
+             *  Draw the line.
+             */
+            surface->Draw_Line(start_point, end_point, style.Color);
+
+            if (style.IsThick) {
+                start_point.Y += 1;
+                end_point.Y += 1;
+                surface->Draw_Line(start_point, end_point, style.Color);
+            }
+
+        }
+
+    }
+
+    /**
+     *  Draw the line start and end squares.
+     */
+    if (style.IsDropShadow) {
+
+        const int drop_point_size = style.IsThick ? (point_size + 3) : (point_size + 2);
+        const Point2D drop_point_offset = style.IsThick ? (point_offset + Point2D(-2, -2)) : (point_offset + Point2D(-1, -1));
+
+        if (style.IsThick) {
+            point_size -= 1;
+        }
+
+        Rect drop_start_point_rect = TacticalRect.Intersect_With(Rect(start_point + drop_point_offset, drop_point_size, drop_point_size));
+        surface->Fill_Rect(drop_start_point_rect, style.DropColor);
+
+        Rect drop_end_point_rect = TacticalRect.Intersect_With(Rect(end_point + drop_point_offset, drop_point_size, drop_point_size));
+        surface->Fill_Rect(drop_end_point_rect, style.DropColor);
+    }
+
+    Rect start_point_rect = TacticalRect.Intersect_With(Rect(start_point + point_offset, point_size, point_size));
+    surface->Fill_Rect(start_point_rect, style.Color);
+
+    Rect end_point_rect = TacticalRect.Intersect_With(Rect(end_point + point_offset, point_size, point_size));
+    surface->Fill_Rect(end_point_rect, style.Color);
+}
+
+
+/**
+ *  Draws a single waypoint or rally point path line.
+ *
+ *  @note: These lines have already been clipped by the game when they were
+ *         submitted, so they are drawn as is.
+ */
+void OverlayLineClass::Draw_Path_Line(XSurface *surface, const OverlayLineStruct &line, int time)
+{
+    const OverlayLineStyleStruct &style = line.Style;
+
+    Point2D start_point = line.Start;
+    Point2D end_point = line.End;
+
+    /**
+     *  Draw the drop shadow line.
+     */
+    start_point.Y += 2;
+    end_point.Y += 2;
+
+    if (style.IsDashed) {
+
+        /**
+         *  Adjust the offset of the line pattern.
+         */
+        int offset = (-time / style.Rate) & (std::size(PathPattern) - 1);
+
+        surface->entry_48(start_point, end_point, style.DropColor, PathPattern, offset, style.IsBlit);
+
+        /**
+         *  Draw two lines, offset by one pixel from each other, giving the
+         *  impression that it is double the thickness.
+         */
+        --start_point.Y;
+        --end_point.Y;
+        surface->entry_48(start_point, end_point, style.Color, PathPattern, offset, style.IsBlit);
+
+        --start_point.Y;
+        --end_point.Y;
+        surface->entry_48(start_point, end_point, style.Color, PathPattern, offset, style.IsBlit);
+
+    } else {
+
+        surface->entry_4C(start_point, end_point, style.DropColor);
+
+        --start_point.Y;
+        --end_point.Y;
+        surface->entry_4C(start_point, end_point, style.Color);
+
+        --start_point.Y;
+        --end_point.Y;
+        surface->entry_4C(start_point, end_point, style.Color);
+    }
+}
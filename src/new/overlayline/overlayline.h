@@ -0,0 +1,108 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          OVERLAYLINE.H
+ *
+ *  @brief         Batched drawing of tactical overlay lines (action and NavCom lines).
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+#include "point.h"
+
+
+class XSurface;
+
+
+/**
+ *  The maximum number of lines held before the batch is drawn early. This is
+ *  only reached if a call site submits more lines than this before drawing.
+ */
+#define OVERLAY_LINE_MAX_BATCH      1024
+
+
+/**
+ *  The drawing style of an overlay line.
+ */
+struct OverlayLineStyleStruct
+{
+    bool IsDashed;
+    bool IsThick;
+    bool IsDropShadow;
+
+    /**
+     *  Path lines (waypoint and rally point lines) are drawn as two lines one
+     *  pixel apart over a drop shadow two pixels below, with the longer dash
+     *  pattern and without the start and end squares.
+     */
+    bool IsPath;
+    bool IsBlit;
+
+    unsigned Color;
+    unsigned DropColor;
+
+    /**
+     *  The animation rate of the dash pattern, in milliseconds per pixel.
+     */
+    int Rate;
+};
+
+
+/**
+ *  Collects the overlay lines submitted by a draw call site and draws them
+ *  in a single pass when that call site calls Draw_All. The lines are drawn
+ *  where the game drew them before, so they keep their place between the
+ *  objects and text drawn around them.
+ *
+ *  Batching allows each surface to be locked once for all of its lines, and
+ *  the dash pattern offset to be calculated once rather than for every line.
+ */
+class OverlayLineClass
+{
+    private:
+        struct OverlayLineStruct
+        {
+            XSurface *Surface;
+            Point2D Start;
+            Point2D End;
+            OverlayLineStyleStruct Style;
+        };
+
+    public:
+        static void Add(const Point2D &start, const Point2D &end, const OverlayLineStyleStruct &style, XSurface *surface = nullptr);
+
+        static void Draw_All();
+        static void Clear_All();
+
+        static int Count() { return LineCount; }
+
+    private:
+        static void Draw_Line(XSurface *surface, const OverlayLineStruct &line, int time);
+        static void Draw_Path_Line(XSurface *surface, const OverlayLineStruct &line, int time);
+
+    private:
+        /**
+         *  The lines submitted since the last draw, in submission order. This is
+         *  a fixed buffer so the batch never allocates while the game is running.
+         */
+        static OverlayLineStruct Lines[OVERLAY_LINE_MAX_BATCH];
+        static int LineCount;
+};
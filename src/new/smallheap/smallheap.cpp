@@ -0,0 +1,594 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          SMALLHEAP.CPP
+ *
+ *  @brief         Size class allocator for small memory blocks.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "smallheap.h"
+
+#include <cstdlib>  // for std::qsort
+#include <cstring>
+
+
+/**
+ *  The block sizes of each size class.
+ */
+static const unsigned short ClassSizes[SMALL_HEAP_CLASS_COUNT] = {
+    8, 16, 24, 32, 40, 48, 56, 64,
+    80, 96, 112, 128, 160, 192, 224, 256,
+    320, 384, 448, 512, 640, 768, 896, 1024
+};
+
+/**
+ *  Values of TrackHeaderStruct::Magic.
+ */
+#define SMALL_HEAP_MAGIC_LIVE       0x4C495645
+#define SMALL_HEAP_MAGIC_FREE       0x46524545
+
+/**
+ *  The value of FreeLinkStruct::Next for the last block of a free list.
+ */
+#define SMALL_HEAP_FREE_LIST_END    0xFFFFFFFF
+
+/**
+ *  The fill value of the guard bytes, and of freed blocks when tracking.
+ */
+#define SMALL_HEAP_GUARD_FILL       0xFD
+#define SMALL_HEAP_FREED_FILL       0xDD
+
+
+
+/**
+ *  Prepare the heap to allocate from the region. The region must be zero
+ *  filled once committed; if no commit function is given it must already be.
+ */
+bool SmallHeapClass::Init(void *region, size_t size, CommitFuncType commit, bool tracking)
+{
+    static_assert(sizeof(TrackHeaderStruct) <= SMALL_HEAP_HEADER_SIZE, "TrackHeaderStruct does not fit the block header!");
+    static_assert(sizeof(FreeLinkStruct) <= SMALL_HEAP_GRANULE, "FreeLinkStruct does not fit the smallest block!");
+    static_assert(((uint64_t)SMALL_HEAP_MAX_RUNS << SMALL_HEAP_RUN_SHIFT) < SMALL_HEAP_FREE_LIST_END, "Region offsets do not fit FreeLinkStruct::Next!");
+
+    if (Base != nullptr || region == nullptr) {
+        return false;
+    }
+
+    /**
+     *  Align the start of the region to the run size, so the run of a block
+     *  can be found from its address.
+     */
+    uintptr_t start = ((uintptr_t)region + (SMALL_HEAP_RUN_SIZE - 1)) & ~(uintptr_t)(SMALL_HEAP_RUN_SIZE - 1);
+    uintptr_t end = (uintptr_t)region + size;
+    if (end <= start) {
+        return false;
+    }
+
+    size_t runs = (end - start) >> SMALL_HEAP_RUN_SHIFT;
+    if (runs > SMALL_HEAP_MAX_RUNS) {
+        runs = SMALL_HEAP_MAX_RUNS;
+    }
+    if (runs == 0) {
+        return false;
+    }
+
+    int cls = 0;
+    for (int granules = 0; granules < int(sizeof(SizeClass)); ++granules) {
+        while (ClassSizes[cls] < granules * SMALL_HEAP_GRANULE) {
+            ++cls;
+        }
+        SizeClass[granules] = (uint8_t)cls;
+    }
+
+    RunCount = runs;
+    RunsUsed = 0;
+    CommitFunc = commit;
+    IsTracking = tracking;
+
+    Base = (char *)start;
+
+    return true;
+}
+
+
+/**
+ *  Allocate a zero filled block. Returns null if the block is too large for
+ *  the small heap, or the region is full.
+ */
+void *SmallHeapClass::Allocate(size_t size, const void *caller)
+{
+    if (Base == nullptr) {
+        return nullptr;
+    }
+
+    size_t block_size = size;
+    if (IsTracking) {
+        block_size += SMALL_HEAP_HEADER_SIZE + SMALL_HEAP_GUARD_SIZE;
+    }
+
+    int cls = Size_To_Class(block_size);
+    if (cls == -1) {
+        return nullptr;
+    }
+
+    ClassStruct &c = Classes[cls];
+    size_t class_size = ClassSizes[cls];
+
+    Lock(c);
+
+    char *block = (char *)c.FreeList;
+    if (block != nullptr) {
+        uint32_t next = ((FreeLinkStruct *)block)->Next;
+        c.FreeList = (next != SMALL_HEAP_FREE_LIST_END) ? Base + next : nullptr;
+
+    } else {
+        if (c.Carve == c.CarveEnd) {
+            c.Carve = New_Run(cls);
+            if (c.Carve == nullptr) {
+                c.CarveEnd = nullptr;
+                Unlock(c);
+                return nullptr;
+            }
+            c.CarveEnd = c.Carve + (SMALL_HEAP_RUN_SIZE / class_size) * class_size;
+        }
+        block = c.Carve;
+        c.Carve += class_size;
+    }
+
+    ++c.Live;
+    c.LiveBytes += IsTracking ? size : class_size;
+
+    Unlock(c);
+
+    if (!IsTracking) {
+        std::memset(block, 0, class_size);
+        return block;
+    }
+
+    TrackHeaderStruct *header = (TrackHeaderStruct *)block;
+    header->Caller = caller;
+    header->Size = (uint32_t)size;
+    header->Magic = SMALL_HEAP_MAGIC_LIVE;
+
+    char *ptr = block + SMALL_HEAP_HEADER_SIZE;
+    std::memset(ptr, 0, size);
+    std::memset(ptr + size, SMALL_HEAP_GUARD_FILL, class_size - SMALL_HEAP_HEADER_SIZE - size);
+
+    return ptr;
+}
+
+
+/**
+ *  Resize a block of the small heap. Returns null, leaving the block as it
+ *  was, if the new size does not fit in the small heap. Memory added to the
+ *  block is zero filled.
+ */
+void *SmallHeapClass::Reallocate(void *ptr, size_t size, const void *caller)
+{
+    if (ptr == nullptr) {
+        return Allocate(size, caller);
+    }
+
+    if (!Owns(ptr) || Block_Class(ptr) == -1) {
+        return nullptr;
+    }
+
+    int cls = Block_Class(ptr);
+    size_t block_size = IsTracking ? size + SMALL_HEAP_HEADER_SIZE + SMALL_HEAP_GUARD_SIZE : size;
+
+    if (Size_To_Class(block_size) == -1) {
+        return nullptr;
+    }
+
+    /**
+     *  Leave a damaged or freed block alone, freeing it will report it.
+     */
+    SmallHeapFreeResultType result;
+    if (IsTracking && !Check_Block(Block_Start(ptr, cls), result)) {
+        return nullptr;
+    }
+
+    /**
+     *  Shrink or grow in place if the size class is unchanged.
+     */
+    if (Size_To_Class(block_size) == cls) {
+        size_t old_size = Size(ptr);
+        size_t class_size = ClassSizes[cls];
+
+        if (!IsTracking) {
+            if (size < class_size) {
+                std::memset((char *)ptr + size, 0, class_size - size);
+            }
+            return ptr;
+        }
+
+        TrackHeaderStruct *header = (TrackHeaderStruct *)Block_Start(ptr, cls);
+
+        ClassStruct &c = Classes[cls];
+        Lock(c);
+        c.LiveBytes += size;
+        c.LiveBytes -= old_size;
+        Unlock(c);
+
+        if (size > old_size) {
+            std::memset((char *)ptr + old_size, 0, size - old_size);
+        }
+        std::memset((char *)ptr + size, SMALL_HEAP_GUARD_FILL, class_size - SMALL_HEAP_HEADER_SIZE - size);
+        header->Size = (uint32_t)size;
+
+        return ptr;
+    }
+
+    void *newptr = Allocate(size, caller);
+    if (newptr == nullptr) {
+        return nullptr;
+    }
+
+    size_t old_size = Size(ptr);
+    std::memcpy(newptr, ptr, old_size < size ? old_size : size);
+
+    Free(ptr);
+
+    return newptr;
+}
+
+
+/**
+ *  Return a block to its size class.
+ */
+SmallHeapFreeResultType SmallHeapClass::Free(void *ptr)
+{
+    if (!Owns(ptr)) {
+        return SMALL_HEAP_FREE_NOT_OWNED;
+    }
+
+    int cls = Block_Class(ptr);
+    if (cls == -1) {
+        return SMALL_HEAP_FREE_NOT_OWNED;
+    }
+
+    ClassStruct &c = Classes[cls];
+    char *block = Block_Start(ptr, cls);
+    size_t size = ClassSizes[cls];
+
+    if (IsTracking) {
+        SmallHeapFreeResultType result;
+        if (!Check_Block(block, result)) {
+            return result;
+        }
+
+        TrackHeaderStruct *header = (TrackHeaderStruct *)block;
+        size = header->Size;
+
+        header->Magic = SMALL_HEAP_MAGIC_FREE;
+        std::memset(block + SMALL_HEAP_HEADER_SIZE, SMALL_HEAP_FREED_FILL, ClassSizes[cls] - SMALL_HEAP_HEADER_SIZE);
+    }
+
+    Lock(c);
+
+    FreeLinkStruct *link = (FreeLinkStruct *)block;
+    link->Next = (c.FreeList != nullptr) ? uint32_t((char *)c.FreeList - Base) : SMALL_HEAP_FREE_LIST_END;
+    c.FreeList = block;
+
+    --c.Live;
+    c.LiveBytes -= size;
+
+    Unlock(c);
+
+    return SMALL_HEAP_FREE_OK;
+}
+
+
+/**
+ *  The usable size of the block. This is the requested size when tracking,
+ *  otherwise the size of the block's size class.
+ */
+size_t SmallHeapClass::Size(const void *ptr) const
+{
+    if (!Owns(ptr)) {
+        return 0;
+    }
+
+    int cls = Block_Class(ptr);
+    if (cls == -1) {
+        return 0;
+    }
+
+    if (IsTracking) {
+        return ((const TrackHeaderStruct *)Block_Start(ptr, cls))->Size;
+    }
+
+    return ClassSizes[cls];
+}
+
+
+/**
+ *  The number of live blocks.
+ */
+unsigned SmallHeapClass::Live_Count() const
+{
+    unsigned count = 0;
+    for (int i = 0; i < SMALL_HEAP_CLASS_COUNT; ++i) {
+        count += Classes[i].Live;
+    }
+    return count;
+}
+
+
+/**
+ *  The number of bytes held by the live blocks. This is the requested size
+ *  of the blocks when tracking, otherwise the size of their size classes.
+ */
+size_t SmallHeapClass::Live_Bytes() const
+{
+    size_t bytes = 0;
+    for (int i = 0; i < SMALL_HEAP_CLASS_COUNT; ++i) {
+        bytes += Classes[i].LiveBytes;
+    }
+    return bytes;
+}
+
+
+/**
+ *  Reports the live blocks grouped by the address they were allocated from,
+ *  largest total size first. Returns the number of call sites, or -1 if
+ *  tracking is not enabled.
+ */
+int SmallHeapClass::Report(ReportFuncType func, void *data, int max_sites)
+{
+    if (!IsTracking || Base == nullptr) {
+        return -1;
+    }
+
+    unsigned live = Live_Count();
+    if (live == 0) {
+        return 0;
+    }
+
+    /**
+     *  Blocks may be allocated while the report is gathered, so allow for a few more.
+     */
+    unsigned capacity = live + live / 4 + 16;
+
+    SiteStruct *sites = (SiteStruct *)std::malloc(capacity * sizeof(SiteStruct));
+    if (sites == nullptr) {
+        return -1;
+    }
+
+    unsigned count = 0;
+
+    for (int cls = 0; cls < SMALL_HEAP_CLASS_COUNT; ++cls) {
+        ClassStruct &c = Classes[cls];
+        size_t class_size = ClassSizes[cls];
+
+        Lock(c);
+
+        for (unsigned run = 0; run < RunsUsed && count < capacity; ++run) {
+            if (RunClass[run] != cls + 1) {
+                continue;
+            }
+
+            const char *block = Base + ((size_t)run << SMALL_HEAP_RUN_SHIFT);
+            const char *end = block + (SMALL_HEAP_RUN_SIZE / class_size) * class_size;
+
+            for (; block < end && count < capacity; block += class_size) {
+                const TrackHeaderStruct *header = (const TrackHeaderStruct *)block;
+                if (header->Magic == SMALL_HEAP_MAGIC_LIVE) {
+                    sites[count].Caller = header->Caller;
+                    sites[count].Count = 1;
+                    sites[count].Bytes = header->Size;
+                    ++count;
+                }
+            }
+        }
+
+        Unlock(c);
+    }
+
+    /**
+     *  Merge the blocks of each call site.
+     */
+    std::qsort(sites, count, sizeof(SiteStruct), site_caller_compare_func);
+
+    unsigned merged = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        if (merged > 0 && sites[merged-1].Caller == sites[i].Caller) {
+            sites[merged-1].Count += sites[i].Count;
+            sites[merged-1].Bytes += sites[i].Bytes;
+            continue;
+        }
+        sites[merged++] = sites[i];
+    }
+
+    std::qsort(sites, merged, sizeof(SiteStruct), site_bytes_compare_func);
+
+    if (func != nullptr) {
+        for (unsigned i = 0; i < merged && (max_sites <= 0 || int(i) < max_sites); ++i) {
+            func(sites[i].Caller, sites[i].Count, sites[i].Bytes, data);
+        }
+    }
+
+    std::free(sites);
+
+    return (int)merged;
+}
+
+
+/**
+ *  Checks the guard bytes of every live block. Returns the number of damaged
+ *  blocks, or -1 if tracking is not enabled.
+ */
+int SmallHeapClass::Check_All()
+{
+    if (!IsTracking || Base == nullptr) {
+        return -1;
+    }
+
+    int damaged = 0;
+
+    for (int cls = 0; cls < SMALL_HEAP_CLASS_COUNT; ++cls) {
+        ClassStruct &c = Classes[cls];
+        size_t class_size = ClassSizes[cls];
+
+        Lock(c);
+
+        for (unsigned run = 0; run < RunsUsed; ++run) {
+            if (RunClass[run] != cls + 1) {
+                continue;
+            }
+
+            const char *block = Base + ((size_t)run << SMALL_HEAP_RUN_SHIFT);
+            const char *end = block + (SMALL_HEAP_RUN_SIZE / class_size) * class_size;
+
+            for (; block < end; block += class_size) {
+                const TrackHeaderStruct *header = (const TrackHeaderStruct *)block;
+                if (header->Magic != SMALL_HEAP_MAGIC_LIVE) {
+                    continue;
+                }
+                SmallHeapFreeResultType result;
+                if (!Check_Block(block, result)) {
+                    ++damaged;
+                }
+            }
+        }
+
+        Unlock(c);
+    }
+
+    return damaged;
+}
+
+
+/**
+ *  The size class that holds blocks of the size, or -1 if it is too large.
+ */
+int SmallHeapClass::Size_To_Class(size_t size) const
+{
+    if (size > SMALL_HEAP_MAX_SIZE) {
+        return -1;
+    }
+
+    return SizeClass[(size + (SMALL_HEAP_GRANULE - 1)) / SMALL_HEAP_GRANULE];
+}
+
+
+/**
+ *  The start of the block (including the tracking header) holding the pointer.
+ */
+char *SmallHeapClass::Block_Start(const void *ptr, int cls) const
+{
+    size_t offset = ((const char *)ptr - Base) & (SMALL_HEAP_RUN_SIZE - 1);
+    size_t class_size = ClassSizes[cls];
+
+    return (char *)ptr - (offset % class_size);
+}
+
+
+/**
+ *  Hand a new run to the size class. Returns null if the region is full.
+ */
+char *SmallHeapClass::New_Run(int cls)
+{
+    while (RunLock.test_and_set(std::memory_order_acquire)) {
+        Small_Heap_Spin_Pause();
+    }
+
+    if (RunsUsed >= RunCount) {
+        RunLock.clear(std::memory_order_release);
+        return nullptr;
+    }
+
+    char *run = Base + ((size_t)RunsUsed << SMALL_HEAP_RUN_SHIFT);
+
+    if (CommitFunc != nullptr && !CommitFunc(run, SMALL_HEAP_RUN_SIZE)) {
+        RunLock.clear(std::memory_order_release);
+        return nullptr;
+    }
+
+    RunClass[RunsUsed] = (uint8_t)(cls + 1);
+    ++RunsUsed;
+
+    RunLock.clear(std::memory_order_release);
+
+    return run;
+}
+
+
+/**
+ *  Checks the tracking header and guard bytes of the block.
+ */
+bool SmallHeapClass::Check_Block(const char *block, SmallHeapFreeResultType &result) const
+{
+    const TrackHeaderStruct *header = (const TrackHeaderStruct *)block;
+
+    if (header->Magic == SMALL_HEAP_MAGIC_FREE) {
+        result = SMALL_HEAP_FREE_DOUBLE;
+        return false;
+    }
+
+    int cls = Block_Class(block);
+    size_t room = ClassSizes[cls] - SMALL_HEAP_HEADER_SIZE;
+
+    if (header->Magic != SMALL_HEAP_MAGIC_LIVE || header->Size > room - SMALL_HEAP_GUARD_SIZE) {
+        result = SMALL_HEAP_FREE_CORRUPT_HEAD;
+        return false;
+    }
+
+    const unsigned char *guard = (const unsigned char *)block + SMALL_HEAP_HEADER_SIZE + header->Size;
+    for (size_t i = 0; i < room - header->Size; ++i) {
+        if (guard[i] != SMALL_HEAP_GUARD_FILL) {
+            result = SMALL_HEAP_FREE_CORRUPT_TAIL;
+            return false;
+        }
+    }
+
+    result = SMALL_HEAP_FREE_OK;
+    return true;
+}
+
+
+/**
+ *  Orders call sites by address.
+ */
+int SmallHeapClass::site_caller_compare_func(const void *ptr1, const void *ptr2)
+{
+    const SiteStruct *s1 = static_cast<const SiteStruct *>(ptr1);
+    const SiteStruct *s2 = static_cast<const SiteStruct *>(ptr2);
+
+    if (s1->Caller != s2->Caller) {
+        return ((uintptr_t)s1->Caller < (uintptr_t)s2->Caller) ? -1 : 1;
+    }
+    return 0;
+}
+
+
+/**
+ *  Orders call sites by total size, largest first.
+ */
+int SmallHeapClass::site_bytes_compare_func(const void *ptr1, const void *ptr2)
+{
+    const SiteStruct *s1 = static_cast<const SiteStruct *>(ptr1);
+    const SiteStruct *s2 = static_cast<const SiteStruct *>(ptr2);
+
+    if (s1->Bytes != s2->Bytes) {
+        return (s1->Bytes > s2->Bytes) ? -1 : 1;
+    }
+    return 0;
+}
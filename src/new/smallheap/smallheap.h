@@ -0,0 +1,231 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          SMALLHEAP.H
+ *
+ *  @brief         Size class allocator for small memory blocks.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+/**
+ *  This file has no dependency on Windows or the game so it can also be
+ *  built into the host tools (see tools/heaptest).
+ */
+
+/**
+ *  The region is divided into runs, each run only holds blocks of one size.
+ */
+#define SMALL_HEAP_RUN_SHIFT        16
+#define SMALL_HEAP_RUN_SIZE         (1 << SMALL_HEAP_RUN_SHIFT)
+
+/**
+ *  The largest region that can be managed, in runs.
+ */
+#define SMALL_HEAP_MAX_RUNS         4096
+
+/**
+ *  Blocks larger than this are not handled by the small heap.
+ */
+#define SMALL_HEAP_MAX_SIZE         1024
+
+/**
+ *  All block sizes are a multiple of this.
+ */
+#define SMALL_HEAP_GRANULE          8
+
+/**
+ *  The number of size classes.
+ */
+#define SMALL_HEAP_CLASS_COUNT      24
+
+/**
+ *  The size of the header in front of each block when tracking is enabled,
+ *  and the number of guard bytes after the block.
+ */
+#define SMALL_HEAP_HEADER_SIZE      16
+#define SMALL_HEAP_GUARD_SIZE       4
+
+
+/**
+ *  Tells the processor it is in a spin wait loop, so it does not starve the
+ *  other hyper-thread of the core or mispredict on leaving the loop.
+ */
+inline void Small_Heap_Spin_Pause()
+{
+#if defined(_MSC_VER)
+    _mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+
+typedef enum SmallHeapFreeResultType
+{
+    SMALL_HEAP_FREE_OK,
+    SMALL_HEAP_FREE_NOT_OWNED,      // The block does not belong to the small heap.
+    SMALL_HEAP_FREE_DOUBLE,         // The block has already been freed (only reported when tracking).
+    SMALL_HEAP_FREE_CORRUPT_HEAD,   // The header of the block has been overwritten.
+    SMALL_HEAP_FREE_CORRUPT_TAIL,   // The guard bytes after the block have been overwritten.
+} SmallHeapFreeResultType;
+
+
+/**
+ *  Allocates small blocks from fixed size classes carved out of one
+ *  contiguous region, with a free list for each size class. Blocks are
+ *  returned zero filled, and any request the heap can not satisfy returns
+ *  null so the caller can fall back to another heap.
+ *
+ *  Each size class has its own lock, so threads only contend when they use
+ *  the same size class at the same time.
+ *
+ *  When tracking is enabled each block has a header holding the address
+ *  it was allocated from and its size, and guard bytes after it. This lets
+ *  the heap detect overruns and double frees, and report the live blocks
+ *  grouped by where they were allocated from. Without tracking a block
+ *  holds nothing but user data, so double frees are not detected.
+ *
+ *  The heap has no constructor; it must be zero initialised (a global, or
+ *  value initialised) and then have Init called. This allows it to be used
+ *  by the global new and delete before static constructors have run.
+ */
+class SmallHeapClass
+{
+    public:
+        /**
+         *  Commits the memory of a run before it is first used. The memory
+         *  must be zero filled.
+         */
+        typedef bool (*CommitFuncType)(void *ptr, size_t size);
+
+        /**
+         *  Receives one call site from Report.
+         */
+        typedef void (*ReportFuncType)(const void *caller, unsigned count, size_t bytes, void *data);
+
+    public:
+        bool Init(void *region, size_t size, CommitFuncType commit = nullptr, bool tracking = false);
+
+        void *Allocate(size_t size, const void *caller = nullptr);
+        void *Reallocate(void *ptr, size_t size, const void *caller = nullptr);
+        SmallHeapFreeResultType Free(void *ptr);
+
+        bool Owns(const void *ptr) const { return Base != nullptr && (const char *)ptr >= Base && (const char *)ptr < Base + (RunCount << SMALL_HEAP_RUN_SHIFT); }
+        size_t Size(const void *ptr) const;
+
+        bool Is_Initialised() const { return Base != nullptr; }
+        bool Is_Tracking() const { return IsTracking; }
+
+        unsigned Live_Count() const;
+        size_t Live_Bytes() const;
+        unsigned Runs_Used() const { return RunsUsed; }
+
+        int Report(ReportFuncType func, void *data = nullptr, int max_sites = 0);
+        int Check_All();
+
+        static size_t Max_Size() { return SMALL_HEAP_MAX_SIZE; }
+
+    private:
+        struct TrackHeaderStruct
+        {
+            const void *Caller;
+            uint32_t Size;
+            uint32_t Magic;
+        };
+
+        /**
+         *  Held in the first bytes of a block while it is on the free list.
+         *  The link is an offset from the base of the region. It overlaps
+         *  the caller of the tracking header, never its magic.
+         */
+        struct FreeLinkStruct
+        {
+            uint32_t Next;
+        };
+
+        struct ClassStruct
+        {
+            std::atomic_flag Lock;
+            void *FreeList;
+            char *Carve;
+            char *CarveEnd;
+            unsigned Live;
+            size_t LiveBytes;
+        };
+
+        struct SiteStruct
+        {
+            const void *Caller;
+            unsigned Count;
+            size_t Bytes;
+        };
+
+        int Size_To_Class(size_t size) const;
+        int Block_Class(const void *block) const { return RunClass[((const char *)block - Base) >> SMALL_HEAP_RUN_SHIFT] - 1; }
+        char *Block_Start(const void *ptr, int cls) const;
+        char *New_Run(int cls);
+
+        bool Check_Block(const char *block, SmallHeapFreeResultType &result) const;
+
+        static void Lock(ClassStruct &c) { while (c.Lock.test_and_set(std::memory_order_acquire)) { Small_Heap_Spin_Pause(); } }
+        static void Unlock(ClassStruct &c) { c.Lock.clear(std::memory_order_release); }
+
+        static int site_caller_compare_func(const void *ptr1, const void *ptr2);
+        static int site_bytes_compare_func(const void *ptr1, const void *ptr2);
+
+    private:
+        /**
+         *  The start of the region, aligned to the run size, and the number
+         *  of runs that fit in the region.
+         */
+        char *Base;
+        size_t RunCount;
+
+        /**
+         *  The number of runs handed out to the size classes so far.
+         */
+        unsigned RunsUsed;
+        std::atomic_flag RunLock;
+
+        CommitFuncType CommitFunc;
+        bool IsTracking;
+
+        ClassStruct Classes[SMALL_HEAP_CLASS_COUNT];
+
+        /**
+         *  The size class (plus one) of each run, zero if the run is unused.
+         */
+        uint8_t RunClass[SMALL_HEAP_MAX_RUNS];
+
+        /**
+         *  The size class of each size, in granules.
+         */
+        uint8_t SizeClass[SMALL_HEAP_MAX_SIZE / SMALL_HEAP_GRANULE + 1];
+};
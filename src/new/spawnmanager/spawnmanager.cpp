@@ -45,6 +45,7 @@
 #include "weapontypeext.h"
 #include "rockettype.h"
 #include "vinifera_saveload.h"
+#include "asserthandler.h"
 
 
 /**
@@ -83,25 +84,35 @@ IFACEMETHODIMP SpawnManagerClass::Load(IStream* pStm)
     if (FAILED(hr))
         return hr;
 
-    new (&SpawnControls) DynamicVectorClass<SpawnControl*>();
+    new (&SpawnControls) DynamicVectorClass<SpawnControl>();
 
-    if (SpawnCount <= 0)
+    /**
+     *  The status counts are not part of the saved data, so they must be
+     *  rebuilt even when there are no controls.
+     */
+    if (SpawnCount <= 0) {
+        Recount_Status();
         return hr;
+    }
+
+    SpawnControls.Set_Growth_Step(SpawnCount);
 
     /**
      *  Read each of the controls as a binary blob.
      */
     for (int index = 0; index < SpawnCount; ++index)
     {
-        const auto control = new SpawnControl;
-        hr = pStm->Read(control, sizeof(SpawnControl), nullptr);
+        SpawnControl control;
+        hr = pStm->Read(&control, sizeof(SpawnControl), nullptr);
         if (FAILED(hr))
             return hr;
         SpawnControls.Add(control);
     }
 
     for (int i = 0; i < SpawnCount; i++)
-        VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(SpawnControls[i]->Spawnee, "Spawnee");
+        VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(SpawnControls[i].Spawnee, "Spawnee");
+
+    Recount_Status();
 
     VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(Owner, "Owner");
     VINIFERA_SWIZZLE_REQUEST_POINTER_REMAP(SpawnType, "SpawnType");
@@ -138,7 +149,7 @@ IFACEMETHODIMP SpawnManagerClass::Save(IStream* pStm, BOOL fClearDirty)
      */
     for (int index = 0; index < SpawnCount; ++index)
     {
-        hr = pStm->Write(SpawnControls[index], sizeof(SpawnControl), nullptr);
+        hr = pStm->Write(&SpawnControls[index], sizeof(SpawnControl), nullptr);
         if (FAILED(hr))
             return hr;
     }
@@ -160,6 +171,8 @@ SpawnManagerClass::SpawnManagerClass() :
     QueuedTarget(nullptr),
     Status(SpawnManagerStatus::Idle)
 {
+    Recount_Status();
+
     SpawnManagers.Add(this);
 }
 
@@ -181,26 +194,31 @@ SpawnManagerClass::SpawnManagerClass(TechnoClass* owner, const AircraftTypeClass
     QueuedTarget(nullptr),
     Status(SpawnManagerStatus::Idle)
 {
+    /**
+     *  The controls are stored by value, so reserve them all up front.
+     */
+    if (SpawnCount > 0)
+        SpawnControls.Set_Growth_Step(SpawnCount);
+
     for (int i = 0; i < SpawnCount; i++)
     {
-        auto control = new SpawnControl();
-        if (control == nullptr)
-            break;
-
         auto spawnee = static_cast<AircraftClass*>(SpawnType->Create_One_Of(owner->Owning_House()));
-        control->Spawnee = spawnee;
 
         if (spawnee != nullptr)
         {
-            control->IsSpawnedMissile = RocketTypeClass::From_AircraftType(SpawnType) != nullptr;
-            control->Spawnee->Limbo();
-            Extension::Fetch<AircraftClassExtension>(control->Spawnee)->SpawnOwner = Owner;
-            control->Status = SpawnControlStatus::Idle;
-            control->ReloadTimer = 0;
+            SpawnControl control;
+            control.Spawnee = spawnee;
+            control.IsSpawnedMissile = RocketTypeClass::From_AircraftType(SpawnType) != nullptr;
+            control.Spawnee->Limbo();
+            Extension::Fetch<AircraftClassExtension>(control.Spawnee)->SpawnOwner = Owner;
+            control.Status = SpawnControlStatus::Idle;
+            control.ReloadTimer = 0;
             SpawnControls.Add(control);
         }
     }
 
+    Recount_Status();
+
     SpawnManagers.Add(this);
 }
 
@@ -215,12 +233,6 @@ SpawnManagerClass::~SpawnManagerClass()
     if (GameActive)
         Detach_Spawns();
 
-    for (int i = SpawnControls.Count() - 1; i >= 0; i--)
-    {
-        if (SpawnControls[i] != nullptr)
-            delete SpawnControls[i];
-    }
-
     SpawnManagers.Delete(this);
 }
 
@@ -243,7 +255,11 @@ RTTIType SpawnManagerClass::Kind_Of() const
  */
 int SpawnManagerClass::Size_Of(bool firestorm) const
 {
-    return sizeof(*this);
+    /**
+     *  The status counts are the last member and are rebuilt on load, so
+     *  they are left out of the saved data.
+     */
+    return sizeof(*this) - sizeof(StatusCounts);
 }
 
 
@@ -292,15 +308,24 @@ void SpawnManagerClass::AI()
 
     LogicTimer = LogicRate;
 
+#ifndef NDEBUG
+    if (Vinifera_DeveloperMode)
+        Validate_Status();
+#endif
+
+    /**
+     *  The owner does not change during the tick, so only fetch its extensions once.
+     */
+    const auto owner_ext = Extension::Fetch<TechnoClassExtension>(Owner);
+    const auto owner_type_ext = Extension::Fetch<TechnoTypeClassExtension>(Owner->Techno_Type_Class());
+
     /**
      *  Iterate all the controls.
      */
     for (int i = 0; i < SpawnControls.Count(); i++)
     {
-        SpawnControl* control = SpawnControls[i];
+        SpawnControl* control = &SpawnControls[i];
         AircraftClass* spawnee = control->Spawnee;
-        const auto owner_ext = Extension::Fetch<TechnoClassExtension>(Owner);
-        const auto owner_type_ext = Extension::Fetch<TechnoTypeClassExtension>(Owner->Techno_Type_Class());
 
         switch (control->Status)
         {
@@ -360,7 +385,7 @@ void SpawnManagerClass::AI()
                 /**
                  *  Update our status.
                  */
-                control->Status = SpawnControlStatus::Preparing;
+                Set_Status(control, SpawnControlStatus::Preparing);
 
                 WeaponSlotType weapon_slot = Extension::Fetch<WeaponTypeClassExtension>(Owner->Get_Weapon(WEAPON_SLOT_PRIMARY)->Weapon)->IsSpawner ? WEAPON_SLOT_PRIMARY : WEAPON_SLOT_SECONDARY;
 
@@ -455,7 +480,7 @@ void SpawnManagerClass::AI()
                     spawnee->Assign_Target(nullptr);
                     spawnee->Assign_Mission(MISSION_MOVE);
                     spawnee->Commence();
-                    control->Status = SpawnControlStatus::Returning;
+                    Set_Status(control, SpawnControlStatus::Returning);
                 }
                 /**
                  *  Send the aircraft to attack.
@@ -491,7 +516,7 @@ void SpawnManagerClass::AI()
                     spawnee->Assign_Destination(Owner);
                     spawnee->Assign_Target(nullptr);
                     spawnee->Assign_Mission(MISSION_MOVE);
-                    control->Status = SpawnControlStatus::Returning;
+                    Set_Status(control, SpawnControlStatus::Returning);
                 }
                 break;
             }
@@ -508,7 +533,7 @@ void SpawnManagerClass::AI()
                 Next_Target();
                 if (spawnee->Ammo > 0 && Target)
                 {
-                    control->Status = SpawnControlStatus::Attacking;
+                    Set_Status(control, SpawnControlStatus::Attacking);
                     spawnee->Assign_Target(Target);
                     spawnee->Assign_Mission(MISSION_ATTACK);
                     break;
@@ -524,7 +549,7 @@ void SpawnManagerClass::AI()
                 if (owner_coord == spawnee_coord && std::abs(spawnee->Coord.Z - Owner->Coord.Z) < 20)
                 {
                     spawnee->Limbo();
-                    control->Status = SpawnControlStatus::Reloading;
+                    Set_Status(control, SpawnControlStatus::Reloading);
                     control->ReloadTimer = ReloadRate;
                 }
                 else
@@ -551,7 +576,7 @@ void SpawnManagerClass::AI()
                 /**
                  *  Then reset the spawn to max ammo and health.
                  */
-                control->Status = SpawnControlStatus::Idle;
+                Set_Status(control, SpawnControlStatus::Idle);
                 spawnee->Ammo = spawnee->Class->MaxAmmo;
                 spawnee->Strength = spawnee->Class->MaxStrength;
                 break;
@@ -575,7 +600,7 @@ void SpawnManagerClass::AI()
                 control->IsSpawnedMissile = RocketTypeClass::From_AircraftType(SpawnType) != nullptr;
                 control->Spawnee->Limbo();
                 Extension::Fetch<AircraftClassExtension>(control->Spawnee)->SpawnOwner = Owner;
-                control->Status = SpawnControlStatus::Idle;
+                Set_Status(control, SpawnControlStatus::Idle);
                 break;
             }
         }
@@ -612,12 +637,8 @@ void SpawnManagerClass::AI()
          *  Check to make sure all of our spawns are currently preparing to launch.
          *  This should only happen when the spawns are missiles, I believe.
          */
-        for (int i = 0; i < SpawnControls.Count(); i++)
-        {
-            const SpawnControl* control = SpawnControls[i];
-            if (control->Status != SpawnControlStatus::Preparing && control->Status != SpawnControlStatus::Dead)
-                return;
-        }
+        if (Status_Count(SpawnControlStatus::Preparing) + Status_Count(SpawnControlStatus::Dead) != SpawnControls.Count())
+            return;
 
         /**
          *  Process all our missiles.
@@ -625,7 +646,7 @@ void SpawnManagerClass::AI()
         bool is_missile_launcher = false;
         for (int i = 0; i < SpawnControls.Count(); i++)
         {
-            SpawnControl* control = SpawnControls[i];
+            SpawnControl* control = &SpawnControls[i];
             AircraftClass* spawnee = control->Spawnee;
 
             /**
@@ -645,7 +666,7 @@ void SpawnManagerClass::AI()
 
                     if (control->IsSpawnedMissile)
                     {
-                        control->Status = SpawnControlStatus::Takeoff;
+                        Set_Status(control, SpawnControlStatus::Takeoff);
                         const auto atype = control->Spawnee->Class;
                         const RocketTypeClass* rocket = RocketTypeClass::From_AircraftType(atype);
                         control->ReloadTimer = rocket->IsCruiseMissile ? 0 : rocket->PauseFrames + rocket->TiltFrames;
@@ -660,7 +681,7 @@ void SpawnManagerClass::AI()
                  */
                 else
                 {
-                    control->Status = SpawnControlStatus::Attacking;
+                    Set_Status(control, SpawnControlStatus::Attacking);
                     spawnee->Assign_Target(Target);
                     spawnee->Assign_Mission(MISSION_ATTACK);
                 }
@@ -685,18 +706,7 @@ void SpawnManagerClass::AI()
      */
     else if (Status == SpawnManagerStatus::Cooldown)
     {
-        bool is_idle = true;
-        for (int i = 0; i < SpawnControls.Count(); i++)
-        {
-            SpawnControl* control = SpawnControls[i];
-            if (control->Status == SpawnControlStatus::Attacking || control->Status == SpawnControlStatus::Returning)
-            {
-                is_idle = false;
-                break;
-            }
-        }
-
-        if (is_idle)
+        if (Status_Count(SpawnControlStatus::Attacking) + Status_Count(SpawnControlStatus::Returning) == 0)
             Status = SpawnManagerStatus::Idle;
     }
 }
@@ -719,7 +729,7 @@ void SpawnManagerClass::Detach_Spawns()
         /**
          *  Don't need to do anything about dead spawns.
          */
-        SpawnControl* control = SpawnControls[i];
+        SpawnControl* control = &SpawnControls[i];
         if (control->Status == SpawnControlStatus::Dead)
             continue;
 
@@ -728,7 +738,7 @@ void SpawnManagerClass::Detach_Spawns()
          */
         if (control->Status == SpawnControlStatus::Idle || control->Status == SpawnControlStatus::Reloading)
         {
-            control->Status = SpawnControlStatus::Dead;
+            Set_Status(control, SpawnControlStatus::Dead);
             control->Spawnee->Remove_This();
         }
         else
@@ -739,7 +749,7 @@ void SpawnManagerClass::Detach_Spawns()
             if (control->Status == SpawnControlStatus::Takeoff)
             {
                 KamikazeTracker->Detach(control->Spawnee);
-                control->Status = SpawnControlStatus::Dead;
+                Set_Status(control, SpawnControlStatus::Dead);
                 control->Spawnee->Remove_This();
             }
             /**
@@ -747,7 +757,7 @@ void SpawnManagerClass::Detach_Spawns()
              */
             else
             {
-                control->Status = SpawnControlStatus::Dead;
+                Set_Status(control, SpawnControlStatus::Dead);
                 KamikazeTracker->Add(control->Spawnee, Target);
             }
         }
@@ -785,7 +795,7 @@ void SpawnManagerClass::Abandon_Target()
      */
     for (int i = 0; i < SpawnControls.Count(); ++i)
     {
-        SpawnControl* control = SpawnControls[i];
+        SpawnControl* control = &SpawnControls[i];
         if (control->Status == SpawnControlStatus::Preparing)
         {
             const auto extension = Extension::Fetch<AircraftTypeClassExtension>(control->Spawnee->Techno_Type_Class());
@@ -852,16 +862,22 @@ void SpawnManagerClass::Detach(TARGET target)
     {
         /**
          *  Check if it's one of the spawns. If so, remove it.
+         *  Spawns are always aircraft of our spawn type, so anything
+         *  else can be skipped without searching the controls.
          */
-        for (int i = 0; i < SpawnControls.Count(); i++)
+        const bool is_spawn_type = target != nullptr
+            && target->What_Am_I() == RTTI_AIRCRAFT
+            && static_cast<const AircraftClass*>(target)->Class == SpawnType;
+
+        for (int i = 0; is_spawn_type && i < SpawnControls.Count(); i++)
         {
-            const auto control = SpawnControls[i];
+            SpawnControl* control = &SpawnControls[i];
             if (control->Spawnee == target)
             {
                 if (control->Spawnee->Strength <= 0 || control->Spawnee->IsKamikaze || control->IsSpawnedMissile)
                 {
                     control->Spawnee = nullptr;
-                    control->Status = SpawnControlStatus::Dead;
+                    Set_Status(control, SpawnControlStatus::Dead);
                     control->ReloadTimer = RegenRate;
                 }
 
@@ -888,13 +904,7 @@ void SpawnManagerClass::Detach(TARGET target)
  */
 int SpawnManagerClass::Active_Count()
 {
-    int count = 0;
-    for (int i = 0; i < SpawnControls.Count(); i++)
-    {
-        if (SpawnControls[i]->Status != SpawnControlStatus::Dead)
-            count++;
-    }
-    return count;
+    return SpawnControls.Count() - Status_Count(SpawnControlStatus::Dead);
 }
 
 
@@ -905,14 +915,7 @@ int SpawnManagerClass::Active_Count()
  */
 int SpawnManagerClass::Docked_Count()
 {
-    int count = 0;
-    for (int i = 0; i < SpawnControls.Count(); i++)
-    {
-        if (SpawnControls[i]->Status == SpawnControlStatus::Reloading ||
-            SpawnControls[i]->Status == SpawnControlStatus::Idle)
-            count++;
-    }
-    return count;
+    return Status_Count(SpawnControlStatus::Reloading) + Status_Count(SpawnControlStatus::Idle);
 }
 
 
@@ -923,15 +926,24 @@ int SpawnManagerClass::Docked_Count()
  */
 int SpawnManagerClass::Preparing_Count()
 {
-    int count = 0;
-    for (int i = 0; i < SpawnControls.Count(); i++)
+    int count = Status_Count(SpawnControlStatus::Takeoff);
+
+    /**
+     *  Preparing spawns only count if they are missiles that have been
+     *  placed in the world. All spawns share the same type, so only missile
+     *  spawners need to check the individual spawns.
+     */
+    if (Status_Count(SpawnControlStatus::Preparing) == 0 || SpawnType == nullptr
+        || !Extension::Fetch<AircraftTypeClassExtension>(SpawnType)->IsMissileSpawn)
     {
-        if (SpawnControls[i]->Status == SpawnControlStatus::Takeoff)
-            count++;
+        return count;
+    }
 
-        if (SpawnControls[i]->Status == SpawnControlStatus::Preparing)
+    for (int i = 0; i < SpawnControls.Count(); i++)
+    {
+        if (SpawnControls[i].Status == SpawnControlStatus::Preparing)
         {
-            const AircraftClass* spawnee = SpawnControls[i]->Spawnee;
+            const AircraftClass* spawnee = SpawnControls[i].Spawnee;
             if (spawnee && !spawnee->IsInLimbo
                 && Extension::Fetch<AircraftTypeClassExtension>(spawnee->Techno_Type_Class())->IsMissileSpawn)
             {
@@ -942,6 +954,53 @@ int SpawnManagerClass::Preparing_Count()
     return count;
 }
 
+
+/**
+ *  Changes the status of a spawn, keeping the status counts up to date.
+ *
+ *  @author: ZivDero
+ */
+void SpawnManagerClass::Set_Status(SpawnControl* control, SpawnControlStatus status)
+{
+    --StatusCounts[static_cast<int>(control->Status)];
+    ++StatusCounts[static_cast<int>(status)];
+    control->Status = status;
+}
+
+
+/**
+ *  Recalculates the status counts from the spawn controls.
+ *
+ *  @author: ZivDero
+ */
+void SpawnManagerClass::Recount_Status()
+{
+    for (int i = 0; i < SPAWN_CONTROL_STATUS_COUNT; i++)
+        StatusCounts[i] = 0;
+
+    for (int i = 0; i < SpawnControls.Count(); i++)
+        ++StatusCounts[static_cast<int>(SpawnControls[i].Status)];
+}
+
+
+/**
+ *  Checks that the status counts match the spawn controls. This recounts
+ *  every control, so it is only called in debug builds in developer mode.
+ *
+ *  @author: ZivDero
+ */
+void SpawnManagerClass::Validate_Status() const
+{
+    int counts[SPAWN_CONTROL_STATUS_COUNT] = { 0 };
+
+    for (int i = 0; i < SpawnControls.Count(); i++)
+        ++counts[static_cast<int>(SpawnControls[i].Status)];
+
+    for (int i = 0; i < SPAWN_CONTROL_STATUS_COUNT; i++)
+        ASSERT_PRINT(counts[i] == StatusCounts[i], "SpawnManager status count mismatch for status %d (%d, expected %d)!", i, StatusCounts[i], counts[i]);
+}
+
+
 /**
  *  Removes all SpawnManagers from the game world.
  *
@@ -54,6 +54,8 @@ enum class SpawnControlStatus {
     Dead = 7		// respawning
 };
 
+#define SPAWN_CONTROL_STATUS_COUNT (static_cast<int>(SpawnControlStatus::Dead) + 1)
+
 
 class DECLSPEC_UUID(CLSID_SPAWN_MANAGER_CLASS)
     SpawnManagerClass : public AbstractClass
@@ -65,6 +67,9 @@ public:
         SpawnControlStatus Status;
         CDTimerClass<FrameTimerClass> ReloadTimer;
         bool IsSpawnedMissile;
+
+        bool operator==(const SpawnControl &that) const { return Spawnee == that.Spawnee && Status == that.Status; }
+        bool operator!=(const SpawnControl &that) const { return Spawnee != that.Spawnee || Status != that.Status; }
     };
 
     /**
@@ -101,11 +106,18 @@ public:
     int Docked_Count();
     int Preparing_Count();
 
+    int Status_Count(SpawnControlStatus status) const { return StatusCounts[static_cast<int>(status)]; }
+
     static void Clear_All();
 
     SpawnManagerClass(const SpawnManagerClass&) = delete;
     SpawnManagerClass& operator= (const SpawnManagerClass&) = delete;
 
+private:
+    void Set_Status(SpawnControl* control, SpawnControlStatus status);
+    void Recount_Status();
+    void Validate_Status() const;
+
 public:
     /**
      *  The Techno that owns this spawn manager.
@@ -143,9 +155,10 @@ public:
     int LogicRate;
 
     /**
-     *  This vector holds the spawn manager.
+     *  This vector holds the spawn controls. The controls are stored by value
+     *  and the vector is never resized once the manager has been created.
      */
-    DynamicVectorClass<SpawnControl*> SpawnControls;
+    DynamicVectorClass<SpawnControl> SpawnControls;
 
     /**
      *  The timer that controls how often the spawn manager should execute its AI function.
@@ -171,4 +184,11 @@ public:
      *  The current status of the spawn manager.
      */
     SpawnManagerStatus Status;
+
+    /**
+     *  The number of spawns in each status, maintained by Set_Status. This
+     *  must stay the last member. It is excluded from Size_Of, so it is not
+     *  saved and does not change the save version, and is rebuilt on load.
+     */
+    int StatusCounts[SPAWN_CONTROL_STATUS_COUNT];
 };
\ No newline at end of file
@@ -0,0 +1,252 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          TEXTLAYOUT.CPP
+ *
+ *  @brief         Word wrap line breaker and layout cache.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "textlayout.h"
+
+#include <cstdlib>
+#include <cstring>
+
+
+TextLayoutClass::LayoutEntryStruct TextLayoutClass::Cache[TEXT_LAYOUT_CACHE_SIZE];
+unsigned TextLayoutClass::Stamp = 0;
+int TextLayoutClass::Hits = 0;
+int TextLayoutClass::Misses = 0;
+
+
+/**
+ *  Divides the string up into lines that fit within the maximum line length,
+ *  replacing the character at each break with a carriage return.
+ *
+ *  This follows the original Format_Window_String exactly, including the width
+ *  it reports when it has to back up to a break. The only difference is a word
+ *  that is wider than the line; the original would back up past the start of
+ *  the line and never finish, this lets the word overflow the line instead.
+ */
+int TextLayoutClass::Format(char *string, const int *widths, int lineheight, int maxlinelen, int &width, int &height)
+{
+    int lines = 0;
+    width = 0;
+    height = 0;
+
+    if (!string || !widths) {
+        return 0;
+    }
+
+    while (*string) {
+        height += lineheight;
+        lines++;
+
+        /**
+         *  Look for special line break character and force a line break when it is
+         *  discovered.
+         */
+        if (*string == '@') {
+            *string = '\r';
+        }
+
+        char *line = string;
+        int linelen = 0;
+
+        while (linelen < maxlinelen && !Is_Line_End(*string)) {
+            linelen += widths[(unsigned char)*string];
+            string++;
+        }
+
+        /**
+         *  If the line is too long, back up to an appropriate location to break.
+         */
+        if (linelen >= maxlinelen) {
+
+            char *end = string;
+            int endlen = linelen;
+
+            while (linelen > maxlinelen || (*string != ' ' && !Is_Line_End(*string))) {
+
+                /**
+                 *  There is nowhere to break on this line, so break after the word.
+                 */
+                if (string == line) {
+                    string = end;
+                    linelen = endlen;
+                    while (*string != ' ' && !Is_Line_End(*string)) {
+                        linelen += widths[(unsigned char)*string];
+                        string++;
+                    }
+                    break;
+                }
+
+                linelen -= widths[(unsigned char)*string];
+                string--;
+            }
+        }
+
+        /**
+         *  Record the largest width of the worst case string.
+         */
+        if (linelen > width) {
+            width = linelen;
+        }
+
+        /**
+         *  Force a break at the end of the line.
+         */
+        if (*string) {
+            *string++ = '\r';
+        }
+    }
+
+    return lines;
+}
+
+
+/**
+ *  Formats the string, reusing the result of an earlier call with the same
+ *  string, font and line length if there is one.
+ */
+int TextLayoutClass::Format_Cached(const void *font, char *string, const int *widths, int lineheight, int maxlinelen, int &width, int &height)
+{
+    width = 0;
+    height = 0;
+
+    if (!string || !widths) {
+        return 0;
+    }
+
+    size_t length = 0;
+    uint32_t hash = Hash_String(string, length);
+
+    if (length > TEXT_LAYOUT_CACHE_MAX_LENGTH) {
+        return Format(string, widths, lineheight, maxlinelen, width, height);
+    }
+
+    ++Stamp;
+
+    LayoutEntryStruct *oldest = &Cache[0];
+
+    for (int i = 0; i < TEXT_LAYOUT_CACHE_SIZE; ++i) {
+        LayoutEntryStruct &entry = Cache[i];
+
+        if (entry.Input != nullptr
+            && entry.Hash == hash
+            && entry.Length == length
+            && entry.Font == font
+            && entry.MaxLineLen == maxlinelen
+            && std::memcmp(entry.Input, string, length) == 0) {
+
+            std::memcpy(string, entry.Output, length);
+            entry.Stamp = Stamp;
+
+            width = entry.Width;
+            height = entry.Lines * lineheight;
+
+            ++Hits;
+            return entry.Lines;
+        }
+
+        /**
+         *  Track the least recently used entry, preferring empty entries.
+         */
+        if (oldest->Input != nullptr && (entry.Input == nullptr || entry.Stamp < oldest->Stamp)) {
+            oldest = &entry;
+        }
+    }
+
+    ++Misses;
+
+    Free_Entry(*oldest);
+
+    char *input = (char *)std::malloc(length);
+    char *output = (char *)std::malloc(length);
+
+    if (input != nullptr) {
+        std::memcpy(input, string, length);
+    }
+
+    int lines = Format(string, widths, lineheight, maxlinelen, width, height);
+
+    if (input == nullptr || output == nullptr) {
+        std::free(input);
+        std::free(output);
+        return lines;
+    }
+
+    std::memcpy(output, string, length);
+
+    oldest->Font = font;
+    oldest->MaxLineLen = maxlinelen;
+    oldest->Hash = hash;
+    oldest->Length = length;
+    oldest->Input = input;
+    oldest->Output = output;
+    oldest->Lines = lines;
+    oldest->Width = width;
+    oldest->Stamp = Stamp;
+
+    return lines;
+}
+
+
+/**
+ *  Forget the cached layouts of the font, or of all fonts if none is given.
+ */
+void TextLayoutClass::Flush(const void *font)
+{
+    for (int i = 0; i < TEXT_LAYOUT_CACHE_SIZE; ++i) {
+        if (font == nullptr || Cache[i].Font == font) {
+            Free_Entry(Cache[i]);
+        }
+    }
+}
+
+
+/**
+ *  FNV-1a hash of the string, also returns the length of the string.
+ */
+uint32_t TextLayoutClass::Hash_String(const char *string, size_t &length)
+{
+    uint32_t hash = 2166136261U;
+
+    const char *ptr = string;
+    while (*ptr) {
+        hash ^= (unsigned char)*ptr++;
+        hash *= 16777619U;
+    }
+
+    length = ptr - string;
+
+    return hash;
+}
+
+
+/**
+ *  Release the strings held by the cache entry.
+ */
+void TextLayoutClass::Free_Entry(LayoutEntryStruct &entry)
+{
+    std::free(entry.Input);
+    std::free(entry.Output);
+
+    std::memset(&entry, 0, sizeof(entry));
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          TEXTLAYOUT.H
+ *
+ *  @brief         Word wrap line breaker and layout cache.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ *  This file has no dependency on Windows or the game so it can also be
+ *  built into the host tools (see tools/textwrap).
+ */
+
+/**
+ *  The number of glyphs in a font width table.
+ */
+#define TEXT_LAYOUT_GLYPH_COUNT         256
+
+/**
+ *  The number of formatted strings that are remembered.
+ */
+#define TEXT_LAYOUT_CACHE_SIZE          32
+
+/**
+ *  Strings longer than this are always formatted, never cached.
+ */
+#define TEXT_LAYOUT_CACHE_MAX_LENGTH    1024
+
+
+/**
+ *  Breaks strings into lines that fit a maximum pixel width, the same way
+ *  Format_Window_String does, but from a table of glyph widths rather than
+ *  asking the font for the width of each character.
+ *
+ *  Format_Window_String writes the line breaks into the string, so the cache
+ *  keeps both the original and the formatted string. A cache hit is checked
+ *  against the original string before the formatted copy is used.
+ */
+class TextLayoutClass
+{
+    private:
+        struct LayoutEntryStruct
+        {
+            const void *Font;
+            int MaxLineLen;
+            uint32_t Hash;
+            size_t Length;
+            char *Input;
+            char *Output;
+            int Lines;
+            int Width;
+            unsigned Stamp;
+        };
+
+    public:
+        static int Format(char *string, const int *widths, int lineheight, int maxlinelen, int &width, int &height);
+        static int Format_Cached(const void *font, char *string, const int *widths, int lineheight, int maxlinelen, int &width, int &height);
+
+        static void Flush(const void *font = nullptr);
+
+        static int Get_Hits() { return Hits; }
+        static int Get_Misses() { return Misses; }
+
+    private:
+        static bool Is_Line_End(char c) { return c == '\r' || c == '\0' || c == '@'; }
+        static uint32_t Hash_String(const char *string, size_t &length);
+        static void Free_Entry(LayoutEntryStruct &entry);
+
+    private:
+        static LayoutEntryStruct Cache[TEXT_LAYOUT_CACHE_SIZE];
+        static unsigned Stamp;
+
+        static int Hits;
+        static int Misses;
+};
@@ -0,0 +1,91 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          VOXELVARIANT.CPP
+ *
+ *  @brief         Condition matching for the unit voxel variants.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "voxelvariant.h"
+#include <cctype>
+#include <cstring>
+
+
+/**
+ *  The names of the voxel variant conditions, in VoxelConditionType bit order.
+ */
+static const char *VoxelConditionNames[] = {
+    "OnWater",
+    "OnBridge",
+    "Airborne",
+    "SpawnsDocked",
+    "Damaged",
+    "Deployed"
+};
+
+
+/**
+ *  Parses a comma separated list of condition names into the required and
+ *  excluded masks. A name prefixed with '!' is excluded. Returns false if
+ *  any of the names are unknown.
+ */
+bool Parse_Voxel_Conditions(char *string, unsigned &required, unsigned &excluded)
+{
+    bool ok = true;
+
+    required = VOXEL_CONDITION_NONE;
+    excluded = VOXEL_CONDITION_NONE;
+
+    for (char *token = std::strtok(string, ","); token != nullptr; token = std::strtok(nullptr, ",")) {
+
+        while (std::isspace((unsigned char)*token)) {
+            ++token;
+        }
+
+        char *end = token + std::strlen(token);
+        while (end > token && std::isspace((unsigned char)end[-1])) {
+            *--end = '\0';
+        }
+
+        bool negate = (*token == '!');
+        if (negate) {
+            ++token;
+        }
+
+        if (*token == '\0') {
+            continue;
+        }
+
+        bool found = false;
+        for (int bit = 0; bit < int(sizeof(VoxelConditionNames)/sizeof(VoxelConditionNames[0])); ++bit) {
+            if (!strcmpi(token, VoxelConditionNames[bit])) {
+                (negate ? excluded : required) |= (1U << bit);
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            ok = false;
+        }
+    }
+
+    return ok;
+}
@@ -0,0 +1,67 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          VOXELVARIANT.H
+ *
+ *  @brief         Condition matching for the unit voxel variants.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+
+
+/**
+ *  The conditions a unit voxel variant can be selected on.
+ */
+typedef enum VoxelConditionType
+{
+    VOXEL_CONDITION_NONE = 0,
+
+    VOXEL_CONDITION_ON_WATER = (1 << 0),        // The unit is on a water cell.
+    VOXEL_CONDITION_ON_BRIDGE = (1 << 1),       // The unit is on a bridge.
+    VOXEL_CONDITION_AIRBORNE = (1 << 2),        // The unit is at least one cell level above the ground.
+    VOXEL_CONDITION_SPAWNS_DOCKED = (1 << 3),   // The unit has a spawn docked (always set if it has no spawns).
+    VOXEL_CONDITION_DAMAGED = (1 << 4),         // The unit health is at or below the yellow condition.
+    VOXEL_CONDITION_DEPLOYED = (1 << 5),        // The unit is deployed (in the unload mission).
+} VoxelConditionType;
+
+
+bool Parse_Voxel_Conditions(char *string, unsigned &required, unsigned &excluded);
+
+
+/**
+ *  Returns the index of the first variant whose conditions are met, or -1 if
+ *  none are. All of the required conditions of a variant must be met and
+ *  none of the excluded ones. The variant type only needs Required and
+ *  Excluded masks, so this can be used without the voxel models.
+ */
+template<class T>
+int Select_Voxel_Variant(const T *variants, int count, unsigned conditions)
+{
+    for (int i = 0; i < count; ++i) {
+        const T &variant = variants[i];
+        if ((conditions & variant.Required) == variant.Required && (conditions & variant.Excluded) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
@@ -156,3 +156,14 @@ typedef enum ViniferaRTTIType
     VINIFERA_RTTI_COUNT
 };
 DEFINE_ENUMERATION_OPERATORS(ViniferaRTTIType);
+
+
+/**
+ *  Where the voxel model of a voxel variant comes from.
+ */
+typedef enum VoxelVariantSourceType
+{
+    VOXEL_VARIANT_IMAGE,    // The variant image loaded from its own VXL/HVA.
+    VOXEL_VARIANT_AUX,      // The unit type's auxiliary voxel (the APC water model).
+    VOXEL_VARIANT_ALT,      // The "no spawns" voxel loaded for NoSpawnAlt.
+} VoxelVariantSourceType;
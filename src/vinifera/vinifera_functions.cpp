@@ -47,6 +47,7 @@
 #include "tclassfactory.h"
 #include "testlocomotion.h"
 #include "kamikazetracker.h"
+#include "mainloopext_hooks.h"
 #include "spawnmanager.h"
 #include "extension.h"
 #include "theatertype.h"
@@ -658,6 +659,11 @@ bool Vinifera_Shutdown()
     ViniferaMapsMixes.Clear();
     ViniferaMoviesMixes.Clear();
 
+    /**
+     *  Cleanup the rules reload databases.
+     */
+    MainLoop_Free_Reload_Cache();
+
     /**
      *  Cleanup global heaps/vectors.
      */
@@ -685,6 +691,8 @@ bool Vinifera_Shutdown()
 
     DEV_DEBUG_INFO("Shutdown - New Count: %d, Delete Count: %d\n", Vinifera_New_Count, Vinifera_Delete_Count);
 
+    vinifera_memory_report();
+
     return true;
 }
 
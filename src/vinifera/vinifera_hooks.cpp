@@ -350,9 +350,10 @@ class FakeBlowfishClass
 static void _Remove_External_Blowfish_Dependency_Patch()
 {
     /**
-     *  The following two patches remove dependency on BLOWFISH.DLL being registered at startup.
+     *  The following patch removes dependency on BLOWFISH.DLL being registered at startup.
+     *  The BLOWFISH.DLL loading errors are skipped by the com object hook at 0x00600F6E,
+     *  see _WinMain_Register_Com_Objects.
      */
-    Patch_Jump(0x00600F6E, 0x00600FA3); // This forces the game init process to skip BLOWFISH.DLL loading errors.
     Patch_Jump(0x005FFE46, 0x005FFF2B); // This skips code registering BLOWFISH.DLL.
 
     /**
@@ -807,7 +808,7 @@ void Vinifera_Hooks()
      *  Add in Vinifera startup/shutdown hooks.
      */
     Patch_Jump(0x00601070, &_WinMain_Parse_Command_Line);
-    Patch_Jump(0x005FF81C, &_WinMain_Vinifera_Startup);
+    Patch_Jump(0x005FF81C, &_WinMain_Vinifera_Startup); // Continues at 0x005FFC41, which also skips the class size logging.
     Patch_Jump(0x00600F6E, &_WinMain_Register_Com_Objects);
     Patch_Jump(0x00602474, &_Game_Shutdown_Vinifera_Shutdown);
     Patch_Jump(0x00462927, &_Main_Game_Vinifera_Init_Game);
@@ -28,7 +28,10 @@
 #include "always.h"
 #include "debughandler.h"
 #include "newdel.h" // TS++ new and delete wrappers.
+#include "smallheap.h"
 #include <new>
+#include <cstring>
+#include <intrin.h>
 
 #include "asserthandler.h"
 #include "debughandler.h"
@@ -51,18 +54,123 @@ static unsigned Round_Up(unsigned number, int a)
 
 
 /**
- *  Implement wrappers for C memory functions.
+ *  The size of the address space reserved for the small block heap. Memory
+ *  is only committed as the heap grows.
  */
-void * __cdecl vinifera_allocate(unsigned int size)
+#define SMALL_HEAP_REGION_SIZE  (64 * 1024 * 1024)
+
+
+/**
+ *  Blocks up to SmallHeapClass::Max_Size() come from the small block heap,
+ *  larger blocks (and small blocks once the region is full) from the process heap.
+ */
+static SmallHeapClass SmallHeap;
+
+
+/**
+ *  Commit a run of the small block heap.
+ */
+static bool Small_Heap_Commit(void *ptr, size_t size)
+{
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+
+/**
+ *  Reserve the region of the small block heap. This is done on the first
+ *  allocation, which may come before the static constructors have run, and
+ *  may happen on several threads at once; the first thread to get here does
+ *  the work while the others wait for it to finish.
+ * 
+ *  Debug builds can tag each small block with the address it was allocated
+ *  from and surround it with guard bytes by passing "-MEMORY_TRACKING".
+ */
+static void Small_Heap_Init()
+{
+    enum { HEAP_UNINITIALISED, HEAP_INITIALISING, HEAP_INITIALISED };
+
+    static volatile LONG _state = HEAP_UNINITIALISED;
+
+    if (_state == HEAP_INITIALISED) {
+        return;
+    }
+
+    if (InterlockedCompareExchange(&_state, HEAP_INITIALISING, HEAP_UNINITIALISED) != HEAP_UNINITIALISED) {
+        while (_state != HEAP_INITIALISED) {
+            YieldProcessor();
+        }
+        return;
+    }
+
+    bool tracking = false;
+#ifndef NDEBUG
+    tracking = std::strstr(GetCommandLineA(), "-MEMORY_TRACKING") != nullptr;
+#endif
+
+    void *region = VirtualAlloc(nullptr, SMALL_HEAP_REGION_SIZE, MEM_RESERVE, PAGE_READWRITE);
+    if (region && !SmallHeap.Init(region, SMALL_HEAP_REGION_SIZE, Small_Heap_Commit, tracking)) {
+        VirtualFree(region, 0, MEM_RELEASE);
+    }
+
+    /**
+     *  Publish the heap; the interlocked exchange is a full barrier, so the
+     *  waiting threads see it fully initialised.
+     */
+    InterlockedExchange(&_state, HEAP_INITIALISED);
+}
+
+
+/**
+ *  Allocate a zero filled block.
+ */
+static void *Allocate_Block(unsigned int size, const void *caller)
 {
+    Small_Heap_Init();
+
+    void *block_ptr = SmallHeap.Allocate(size, caller);
+    if (block_ptr) {
+        return block_ptr;
+    }
+
     /**
      *  Round up input size to nearest multiple of 4 for alignment.
      */
     unsigned r_size = Round_Up(size, 4);
 
-    void *block_ptr = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, r_size);
+    block_ptr = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, r_size);
     ASSERT_STACKDUMP_PRINT(block_ptr != nullptr, "Failed to allocate memory!\n");
 
+    return block_ptr;
+}
+
+
+/**
+ *  Release a block to the heap it was allocated from.
+ */
+static void Free_Block(void *ptr)
+{
+    if (SmallHeap.Owns(ptr)) {
+        SmallHeapFreeResultType result = SmallHeap.Free(ptr);
+        ASSERT_STACKDUMP_PRINT(result != SMALL_HEAP_FREE_DOUBLE, "Memory block 0x%08X was already freed!\n", ptr);
+        ASSERT_STACKDUMP_PRINT(result != SMALL_HEAP_FREE_CORRUPT_HEAD, "Memory before block 0x%08X has been overwritten!\n", ptr);
+        ASSERT_STACKDUMP_PRINT(result != SMALL_HEAP_FREE_CORRUPT_TAIL, "Memory after block 0x%08X has been overwritten!\n", ptr);
+        return;
+    }
+
+    bool freed = HeapFree(GetProcessHeap(), HEAP_ZERO_MEMORY, ptr);
+    ASSERT_STACKDUMP_PRINT(freed, "Failed to free memory!\n");
+
+    ASSERT(freed);
+}
+
+
+/**
+ *  Implement wrappers for C memory functions.
+ */
+void * __cdecl vinifera_allocate(unsigned int size)
+{
+    void *block_ptr = Allocate_Block(size, _ReturnAddress());
+
     ++Vinifera_New_Count;
 
     return block_ptr;
@@ -75,33 +183,106 @@ void * __cdecl vinifera_count_allocate(unsigned int count, unsigned int size)
      */
     unsigned r_size = Round_Up(size, 4);
 
-    void *block_ptr = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, r_size * count);
-    ASSERT_STACKDUMP_PRINT(block_ptr != nullptr, "Failed to allocate memory!\n");
-
-    return block_ptr;
+    return Allocate_Block(r_size * count, _ReturnAddress());
 }
 
 void * __cdecl vinifera_reallocate(void *ptr, unsigned int size)
 {
+    if (!ptr) {
+        return Allocate_Block(size, _ReturnAddress());
+    }
+
     /**
-     *  Round up input size to nearest multiple of 4 for alignment.
+     *  Blocks that were allocated from the process heap stay there.
      */
-    unsigned r_size = Round_Up(size, 4);
+    if (!SmallHeap.Owns(ptr)) {
+
+        /**
+         *  Round up input size to nearest multiple of 4 for alignment.
+         */
+        unsigned r_size = Round_Up(size, 4);
+
+        void *block_ptr = HeapReAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, ptr, r_size);
+        ASSERT_STACKDUMP_PRINT(block_ptr != nullptr, "Failed to allocate memory!\n");
+
+        return block_ptr;
+    }
+
+    void *block_ptr = SmallHeap.Reallocate(ptr, size, _ReturnAddress());
+    if (block_ptr) {
+        return block_ptr;
+    }
 
-    void *block_ptr = HeapReAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, ptr, r_size);
+    /**
+     *  The block has outgrown the small block heap, move it to the process heap.
+     */
+    block_ptr = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, Round_Up(size, 4));
     ASSERT_STACKDUMP_PRINT(block_ptr != nullptr, "Failed to allocate memory!\n");
 
+    if (block_ptr) {
+        size_t old_size = SmallHeap.Size(ptr);
+        std::memcpy(block_ptr, ptr, old_size < size ? old_size : size);
+        Free_Block(ptr);
+    }
+
     return block_ptr;
 }
 
 void __cdecl vinifera_free(void *ptr)
 {
-    bool freed = HeapFree(GetProcessHeap(), HEAP_ZERO_MEMORY, ptr);
-    ASSERT_STACKDUMP_PRINT(freed, "Failed to free memory!\n");
+    if (!ptr) {
+        return;
+    }
+
+    Free_Block(ptr);
 
     ++Vinifera_Delete_Count;
+}
 
-    ASSERT(freed);
+unsigned int __cdecl vinifera_size(void *ptr)
+{
+    if (SmallHeap.Owns(ptr)) {
+        return SmallHeap.Size(ptr);
+    }
+
+    return HeapSize(GetProcessHeap(), 0, ptr);
+}
+
+
+/**
+ *  Print one call site of the live memory report.
+ */
+static void vinifera_memory_report_site(const void *caller, unsigned count, size_t bytes, void *data)
+{
+    DEBUG_INFO("  0x%08X  %8u blocks  %10u bytes\n", caller, count, bytes);
+}
+
+
+/**
+ *  Log the state of the small block heap, and when tracking is enabled the
+ *  live blocks grouped by the address they were allocated from.
+ */
+void vinifera_memory_report()
+{
+    if (!SmallHeap.Is_Initialised()) {
+        return;
+    }
+
+    DEBUG_INFO("Small heap: %u live blocks, %u bytes, %u of %u KB committed.\n",
+        SmallHeap.Live_Count(), SmallHeap.Live_Bytes(),
+        SmallHeap.Runs_Used() * (SMALL_HEAP_RUN_SIZE / 1024), SMALL_HEAP_REGION_SIZE / 1024);
+
+    if (!SmallHeap.Is_Tracking()) {
+        return;
+    }
+
+    int damaged = SmallHeap.Check_All();
+    if (damaged > 0) {
+        DEBUG_WARNING("Small heap: %d live blocks have been overrun!\n", damaged);
+    }
+
+    DEBUG_INFO("Small heap: Live blocks by call site (largest 32):\n");
+    SmallHeap.Report(vinifera_memory_report_site, nullptr, 32);
 }
 
 
@@ -158,7 +339,9 @@ void  __cdecl operator delete[](void *ptr, const std::nothrow_t &tag)
 
 void * __cdecl operator new(std::size_t size)
 {
-    return vinifera_allocate(size);
+    ++Vinifera_New_Count;
+
+    return Allocate_Block(size, _ReturnAddress());
 }
 
 void * __cdecl operator new(std::size_t size, const char *file, int line)
@@ -167,12 +350,16 @@ void * __cdecl operator new(std::size_t size, const char *file, int line)
     //DEV_DEBUG_INFO("operator new() called with size: %zd, from file: %s, line: %d.\n", size, file, line);
 #endif
 
-    return vinifera_allocate(size);
+    ++Vinifera_New_Count;
+
+    return Allocate_Block(size, _ReturnAddress());
 }
 
 void * __cdecl operator new(std::size_t size, const std::nothrow_t &tag)
 {
-    return vinifera_allocate(size);
+    ++Vinifera_New_Count;
+
+    return Allocate_Block(size, _ReturnAddress());
 }
 
 //void * __cdecl operator new(std::size_t size, void *place) noexcept
@@ -182,7 +369,9 @@ void * __cdecl operator new(std::size_t size, const std::nothrow_t &tag)
 
 void * __cdecl operator new[](std::size_t size)
 {
-    return vinifera_allocate(size);
+    ++Vinifera_New_Count;
+
+    return Allocate_Block(size, _ReturnAddress());
 }
 
 void * __cdecl operator new[](std::size_t size, const char *file, int line)
@@ -191,12 +380,16 @@ void * __cdecl operator new[](std::size_t size, const char *file, int line)
     //DEV_DEBUG_INFO("operator new[]() called with size: %zd, from file: %s, line: %d.\n", size, file, line);
 #endif
 
-    return vinifera_allocate(size);
+    ++Vinifera_New_Count;
+
+    return Allocate_Block(size, _ReturnAddress());
 }
 
 void * __cdecl operator new[](std::size_t size, const std::nothrow_t &tag)
 {
-    return vinifera_allocate(size);
+    ++Vinifera_New_Count;
+
+    return Allocate_Block(size, _ReturnAddress());
 }
 
 
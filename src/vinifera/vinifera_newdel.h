@@ -104,6 +104,9 @@ void * __cdecl vinifera_allocate(unsigned int size);
 void * __cdecl vinifera_count_allocate(unsigned int count, unsigned int size);
 void * __cdecl vinifera_reallocate(void *ptr, unsigned int size);
 void __cdecl vinifera_free(void *ptr);
+unsigned int __cdecl vinifera_size(void *ptr);
+
+void vinifera_memory_report();
 
 void vinifera_init_memory();
 
@@ -39,12 +39,19 @@
 #include "filepng.h"
 #include "filepcx.h"
 #include "cncnet4_globals.h"
+#include "cncnet4.h"
 #include "wwfont.h"
 #include "msgbox.h"
 #include "minidump.h"
 #include "winutil.h"
 #include "xzip.h"
+#include "ccfile.h"
+#include "crcbuffer.h"
+#include "debughandler.h"
 #include <cstdio>
+#include <cstdarg>
+#include <climits>
+#include <algorithm>
 
 
 extern char Execute_Time_Buffer[256];
@@ -230,6 +237,7 @@ void Vinifera_Draw_Version_Text(XSurface *surface, bool pre_init)
     static Point2D vinifera_pos;
 #endif
     static Point2D version_pos;
+    static Point2D cncnet_pos;
 
     Rect surfrect = surface->Get_Rect();
 
@@ -277,6 +285,16 @@ void Vinifera_Draw_Version_Text(XSurface *surface, bool pre_init)
     version_pos.Y = surfrect.Height-offset-(print_rect.Height*1);
 #endif
 
+    /**
+     *  The CnCNet4 connection status is drawn above the version text.
+     */
+    cncnet_pos.X = surfrect.Width-offset;
+#ifndef RELEASE
+    cncnet_pos.Y = surfrect.Height-offset-(print_rect.Height*4)-space;
+#else
+    cncnet_pos.Y = surfrect.Height-offset-(print_rect.Height*2);
+#endif
+
     /**
      *  So, we need to draw the strings slightly differently if this is being drawn
      *  before the games initialisation process has finished. This is because the
@@ -316,6 +334,15 @@ void Vinifera_Draw_Version_Text(XSurface *surface, bool pre_init)
 
     } else {
 
+        /**
+         *  Draw the CnCNet4 connection status. The menus do not run the main
+         *  loop, so the connection is also advanced here while it is shown.
+         */
+        if (CnCNet4::Get_State() != CnCNet4::STATE_IDLE) {
+            CnCNet4::Process();
+            Fancy_Text_Print(CnCNet4::Get_State_String(), surface, &surfrect, &cncnet_pos, color_white, back_color, style);
+        }
+
 #ifndef RELEASE
 
         /**
@@ -476,10 +503,115 @@ const char *Vinifera_Get_Window_Title(DWORD dwPid)
 }
 
 
+/**
+ *  The upper limit of the uncompressed data added to a debug bundle. Files that
+ *  would take the bundle over this limit are skipped and listed in the manifest.
+ */
+#define DEBUG_BUNDLE_SIZE_LIMIT     (64 * 1024 * 1024)
+
+/**
+ *  The maximum number of files on disk collected into a debug bundle.
+ */
+#define DEBUG_BUNDLE_FILES_MAX      8
+
+
+/**
+ *  Adds the file to the zip archive. The file is read through a handle so the
+ *  archive streams it in chunks rather than loading it whole, and is opened
+ *  with full sharing so files still held open by the crash handlers can be read.
+ * 
+ *  @author: CCHyper
+ */
+static ZRESULT Zip_Add_File(HZIP hZip, const char *name, const char *filename)
+{
+    HANDLE handle = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return ZR_NOFILE;
+    }
+
+    ZRESULT zresult = ZipAdd(hZip, name, handle, 0, ZIP_HANDLE);
+
+    CloseHandle(handle);
+
+    return zresult;
+}
+
+
+/**
+ *  Fetches the size of the file on disk, returns -1 if the file does not exist.
+ * 
+ *  @author: CCHyper
+ */
+static long Get_Disk_File_Size(const char *filename)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesEx(filename, GetFileExInfoStandard, &data)) {
+        return -1;
+    }
+    if (data.nFileSizeHigh != 0 || data.nFileSizeLow > LONG_MAX) {
+        return LONG_MAX;
+    }
+    return (long)data.nFileSizeLow;
+}
+
+
+/**
+ *  Calculates the CRC of the file contents, reading it in fixed size chunks.
+ * 
+ *  @author: CCHyper
+ */
+static bool Get_File_CRC(const char *filename, uint32_t &crc, long &size)
+{
+    CCFileClass file(filename);
+    if (!file.Is_Available()) {
+        return false;
+    }
+
+    char buffer[4096];
+    crc = 0;
+    size = 0;
+
+    file.Open(FILE_ACCESS_READ);
+
+    long read;
+    while ((read = file.Read(buffer, sizeof(buffer))) > 0) {
+        crc = CRC32_Buffer(buffer, read, crc);
+        size += read;
+    }
+
+    file.Close();
+
+    return true;
+}
+
+
+/**
+ *  Appends formatted text to the buffer, clamping at the end of the buffer.
+ * 
+ *  @author: CCHyper
+ */
+static void Manifest_Printf(char *buffer, int size, int &length, const char *fmt, ...)
+{
+    if (length >= size-1) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    int written = std::vsnprintf(buffer + length, size - length, fmt, args);
+    va_end(args);
+
+    if (written > 0) {
+        length = std::min(length + written, size-1);
+    }
+}
+
+
 /**
  *  Creates a zip file is the specified files.
  * 
- *  @note: If the zip file already exists, it will be updated.
+ *  @note: If the zip file already exists, it will be overwritten.
  * 
  *  @author: CCHyper
  */
@@ -499,100 +631,229 @@ bool Vinifera_Create_Zip(const char *filename, DynamicVectorClass<const char *>
         return false;
     }
 
-    /**
-     *  
-     */
     for (int i = 0; i < filelist.Count(); ++i) {
         if (path) {
             std::snprintf(buffer, sizeof(buffer), "%s\\%s", path, filelist[i]);
         } else {
             std::snprintf(buffer, sizeof(buffer), ".\\%s", filelist[i]);
         }
-        ZRESULT zresult = ZipAdd(hZip, filelist[i], buffer, 0, ZIP_FILENAME);
+        ZRESULT zresult = Zip_Add_File(hZip, filelist[i], buffer);
         if (zresult != ZR_OK) {
             DEBUG_ERROR("Failed to add file \"%s\" to zip archive \"%s\"!\n", buffer, filename);
+            CloseZip(hZip);
             return false;
         }
     }
+
+    if (CloseZip(hZip) != ZR_OK) {
+        DEBUG_ERROR("Failed to write zip archive \"%s\"!\n", filename);
+        return false;
+    }
     
     DEBUG_INFO("Zip archive \"%s\" created sucessfully.\n", filename);
 
-    return CloseZip(hZip) == ZR_OK;
+    return true;
 }
 
 
 /**
  *  Collects the debug files from this session and creates a zip file.
  * 
- *  @note: If the zip file already exists, it will be updated.
+ *  The bundle contains the crash reports, stack traces and crash dump of this
+ *  session, the most recent log output, the CRC of the rule files in use and
+ *  the most recent save game. The total size of the bundle is capped, with the
+ *  crash reports taking priority over the larger, less essential files.
+ * 
+ *  @note: A bundle is only created if this session produced a crash report.
  * 
  *  @author: CCHyper
  */
 bool Vinifera_Collect_Debug_Files()
 {
-#if 0
-    char buffer[PATH_MAX];
+    static const char *INIFilenames[] = {
+        "RULES.INI", "FIRESTRM.INI", "ART.INI", "ARTFS.INI", "AI.INI", "AIFS.INI",
+        "SOUND.INI", "SOUND01.INI", "EVA.INI", "EVA01.INI", "THEME.INI", "BATTLE.INI"
+    };
+
+    struct BundleFileStruct
+    {
+        char Name[PATH_MAX];
+        char Path[PATH_MAX];
+        bool IsSessionFile;
+    };
 
-    char debug_buffer[PATH_MAX];
-    char except_buffer[PATH_MAX];
-    char stack_buffer[PATH_MAX];
-    char crashdump_buffer[PATH_MAX];
+    static BundleFileStruct files[DEBUG_BUNDLE_FILES_MAX];
+    static char manifest[8192];
 
-    RawFileClass tmpfile;
-    DynamicVectorClass<const char *> files;
+    int file_count = 0;
+    bool has_crash_report = false;
 
-    std::snprintf(debug_buffer, sizeof(debug_buffer), "%s\\DEBUG_%s.LOG", Vinifera_DebugDirectory, Execute_Time_Buffer);
-    tmpfile.Set_Name(debug_buffer);
-    if (tmpfile.Is_Available()) {
-        std::snprintf(buffer, sizeof(buffer), "DEBUG_%s.LOG", Execute_Time_Buffer);
-        files.Add(strdup(buffer));
+    /**
+     *  Gather the session files, in order of importance.
+     */
+    const char *session_formats[] = {
+        "EXCEPT_%s.TXT",
+        "STACK_%s.LOG",
+        "DEBUG_%s.LOG"
+    };
+
+    for (int i = 0; i < int(sizeof(session_formats)/sizeof(session_formats[0])); ++i) {
+        BundleFileStruct &file = files[file_count];
+        std::snprintf(file.Name, sizeof(file.Name), session_formats[i], Execute_Time_Buffer);
+        std::snprintf(file.Path, sizeof(file.Path), "%s\\%s", Vinifera_DebugDirectory, file.Name);
+        file.IsSessionFile = true;
+        if (Get_Disk_File_Size(file.Path) >= 0) {
+            has_crash_report |= (i < 2);
+            ++file_count;
+        }
     }
 
-    std::snprintf(except_buffer, sizeof(except_buffer), "%s\\EXCEPT_%s.TXT", Vinifera_DebugDirectory, Execute_Time_Buffer);
-    tmpfile.Set_Name(except_buffer);
-    if (tmpfile.Is_Available()) {
-        std::snprintf(buffer, sizeof(buffer), "EXCEPT_%s.TXT", Execute_Time_Buffer);
-        files.Add(strdup(buffer));
+    /**
+     *  The raw stack records are numbered per dump, only the most recent
+     *  one is added as it belongs to the crash.
+     */
+    {
+        char stack_pattern[PATH_MAX];
+        std::snprintf(stack_pattern, sizeof(stack_pattern), "%s\\STACK_%s_*.BIN", Vinifera_DebugDirectory, Execute_Time_Buffer);
+
+        WIN32_FIND_DATA stack_data;
+        HANDLE stack_find = FindFirstFile(stack_pattern, &stack_data);
+        if (stack_find != INVALID_HANDLE_VALUE) {
+            BundleFileStruct &file = files[file_count];
+            file.Name[0] = '\0';
+            do {
+                if (std::strcmp(stack_data.cFileName, file.Name) > 0) {
+                    std::snprintf(file.Name, sizeof(file.Name), "%s", stack_data.cFileName);
+                }
+            } while (FindNextFile(stack_find, &stack_data));
+            FindClose(stack_find);
+            std::snprintf(file.Path, sizeof(file.Path), "%s\\%s", Vinifera_DebugDirectory, file.Name);
+            file.IsSessionFile = true;
+            has_crash_report = true;
+            ++file_count;
+        }
     }
 
-    std::snprintf(stack_buffer, sizeof(stack_buffer), "%s\\STACK_%s.LOG", Vinifera_DebugDirectory, Execute_Time_Buffer);
-    tmpfile.Set_Name(stack_buffer);
-    if (tmpfile.Is_Available()) {
-        std::snprintf(buffer, sizeof(buffer), "STACK_%s.LOG", Execute_Time_Buffer);
-        files.Add(strdup(buffer));
+    if (MinidumpFilename[0] != '\0' && Get_Disk_File_Size(MinidumpFilename) >= 0) {
+        BundleFileStruct &file = files[file_count++];
+        const char *name = std::strrchr(MinidumpFilename, '\\');
+        std::snprintf(file.Name, sizeof(file.Name), "%s", name ? name+1 : MinidumpFilename);
+        std::snprintf(file.Path, sizeof(file.Path), "%s", MinidumpFilename);
+        file.IsSessionFile = true;
+        has_crash_report = true;
     }
 
-    const char *module_name = strupr((char *)Get_Module_File_Name());
-    std::snprintf(crashdump_buffer, sizeof(crashdump_buffer), "%s\\CRASHDUMP_%s_%s.DMP", Vinifera_DebugDirectory, module_name, Execute_Time_Buffer);
-    tmpfile.Set_Name(crashdump_buffer);
-    if (tmpfile.Is_Available()) {
-        std::snprintf(buffer, sizeof(buffer), "CRASHDUMP_%s_%s.DMP", module_name, Execute_Time_Buffer);
-        files.Add(strdup(buffer));
+    if (!has_crash_report) {
+        return true;
     }
 
-    std::snprintf(buffer, sizeof(buffer), "%s_%s.ZIP", "DEBUG", Execute_Time_Buffer);
-    bool result = Vinifera_Create_Zip(buffer, files, Vinifera_DebugDirectory);
+    /**
+     *  The most recent save game, to help reproduce the crash.
+     */
+    WIN32_FIND_DATA find_data;
+    FILETIME newest_time = { 0, 0 };
+    HANDLE find = FindFirstFile("*.SAV", &find_data);
+    if (find != INVALID_HANDLE_VALUE) {
+        BundleFileStruct &file = files[file_count];
+        do {
+            if ((find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0
+             && CompareFileTime(&find_data.ftLastWriteTime, &newest_time) > 0) {
+                newest_time = find_data.ftLastWriteTime;
+                std::snprintf(file.Name, sizeof(file.Name), "%s", find_data.cFileName);
+                std::snprintf(file.Path, sizeof(file.Path), ".\\%s", find_data.cFileName);
+                file.IsSessionFile = false;
+            }
+        } while (FindNextFile(find, &find_data));
+        FindClose(find);
+        if (newest_time.dwLowDateTime || newest_time.dwHighDateTime) {
+            ++file_count;
+        }
+    }
 
     /**
-     *  Cleanup files.
+     *  Each bundle gets its own name, so a second crash in the same session
+     *  does not replace the bundle of the first.
      */
-    if (result) {
-        RawFileClass(debug_buffer).Delete();
-        RawFileClass(except_buffer).Delete();
-        RawFileClass(stack_buffer).Delete();
-        RawFileClass(crashdump_buffer).Delete();
+    char zip_filename[PATH_MAX];
+    std::snprintf(zip_filename, sizeof(zip_filename), "%s\\DEBUG_%s.ZIP", Vinifera_DebugDirectory, Execute_Time_Buffer);
+
+    for (int i = 1; Get_Disk_File_Size(zip_filename) >= 0 && i < 1000; ++i) {
+        std::snprintf(zip_filename, sizeof(zip_filename), "%s\\DEBUG_%s_%03d.ZIP", Vinifera_DebugDirectory, Execute_Time_Buffer, i);
+    }
+
+    HZIP hZip = CreateZip((void *)zip_filename, 0, ZIP_FILENAME);
+    if (!hZip) {
+        DEBUG_ERROR("Failed to create zip archive \"%s\"!\n", zip_filename);
+        return false;
     }
 
+    int manifest_len = 0;
+    Manifest_Printf(manifest, sizeof(manifest), manifest_len, "%s\r\n%s\r\n\r\n", Vinifera_Name_String(), TSpp_Version_String());
+
+    long bundle_size = 0;
+    bool added[DEBUG_BUNDLE_FILES_MAX] = { false };
+
     /**
-     *  Cleanup memory.
+     *  The tail of the log is always added, the log file itself may be too large.
      */
-    for (int i = 0; i < files.Count(); ++i) {
-        std::free((void *)files[i]);
+    char *log_tail = (char *)VirtualAlloc(nullptr, DEBUG_LOG_RING_SIZE, MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+    if (log_tail) {
+        int log_size = Vinifera_Debug_Log_Tail(log_tail, DEBUG_LOG_RING_SIZE);
+        if (log_size > 0 && ZipAdd(hZip, "LOG_TAIL.TXT", log_tail, log_size, ZIP_MEMORY) == ZR_OK) {
+            bundle_size += log_size;
+        }
+        VirtualFree(log_tail, 0, MEM_RELEASE);
+    }
+
+    for (int i = 0; i < file_count; ++i) {
+        long size = Get_Disk_File_Size(files[i].Path);
+        if (size < 0) {
+            continue;
+        }
+        if (size > DEBUG_BUNDLE_SIZE_LIMIT - bundle_size) {
+            Manifest_Printf(manifest, sizeof(manifest), manifest_len, "Skipped %s (%ld bytes, over size limit)\r\n", files[i].Name, size);
+            continue;
+        }
+        if (Zip_Add_File(hZip, files[i].Name, files[i].Path) != ZR_OK) {
+            DEBUG_ERROR("Failed to add file \"%s\" to zip archive \"%s\"!\n", files[i].Path, zip_filename);
+            Manifest_Printf(manifest, sizeof(manifest), manifest_len, "Failed %s\r\n", files[i].Name);
+            continue;
+        }
+        Manifest_Printf(manifest, sizeof(manifest), manifest_len, "Added %s (%ld bytes)\r\n", files[i].Name, size);
+        bundle_size += size;
+        added[i] = true;
+    }
+
+    /**
+     *  The CRC table of the rule files in use.
+     */
+    Manifest_Printf(manifest, sizeof(manifest), manifest_len, "\r\n");
+    for (int i = 0; i < int(sizeof(INIFilenames)/sizeof(INIFilenames[0])); ++i) {
+        uint32_t crc = 0;
+        long size = 0;
+        if (Get_File_CRC(INIFilenames[i], crc, size)) {
+            Manifest_Printf(manifest, sizeof(manifest), manifest_len, "%-16s %08X (%ld bytes)\r\n", INIFilenames[i], crc, size);
+        }
+    }
+
+    ZipAdd(hZip, "MANIFEST.TXT", manifest, manifest_len, ZIP_MEMORY);
+
+    if (CloseZip(hZip) != ZR_OK) {
+        DEBUG_ERROR("Failed to write zip archive \"%s\"!\n", zip_filename);
+        return false;
+    }
+
+    DEBUG_INFO("Zip archive \"%s\" created sucessfully.\n", zip_filename);
+
+    /**
+     *  Cleanup the session files that made it into the bundle.
+     */
+    for (int i = 0; i < file_count; ++i) {
+        if (added[i] && files[i].IsSessionFile) {
+            DeleteFile(files[i].Path);
+        }
     }
-    files.Delete_All();
 
-    return result;
-#endif
     return true;
 }
 
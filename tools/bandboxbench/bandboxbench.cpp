@@ -0,0 +1,324 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          BANDBOXBENCH.CPP
+ *
+ *  @brief         Measures band box selection with and without a screen-space grid.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: BandBoxBench [-n <releases>]
+ *
+ *  Tactical::Select_These tests every object drawn this frame against the
+ *  band box when it is released. This tool compares that scan with the
+ *  screen-space bucket grid that was tried and reverted, in the two ways
+ *  it could be fed:
+ *
+ *    - Rebuilt on every frame the band box is drawn, as the reverted
+ *      change did from Draw_Band_Box, then queried once on release.
+ *    - Built once on release from the same object list, then queried.
+ *
+ *  The objects are scattered over the heap and the scan reads IsActive
+ *  before the position test, as Select_These does, so the scan pays the
+ *  same cache misses it pays in game. Every query is checked to return
+ *  the same objects, in list order, as the scan. Any failed check aborts
+ *  the tool.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "point.h"
+#include "rect.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+#define BANDBOX_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "BandBoxBench: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+/**
+ *  Stands in for an ObjectClass. The size is about that of a unit, so the
+ *  objects spread over as many cache lines as they do in game.
+ */
+struct FakeObject
+{
+    bool IsActive;
+    char Padding[0x6E0];
+};
+
+
+/**
+ *  Matches the layout of the Tactical dirty object list entries.
+ */
+struct DirtyObjectStruct
+{
+    FakeObject *Object;
+    Point2D Position;
+    int Flags;
+};
+
+
+/**
+ *  The grid from the reverted change: 64 pixel buckets filled by a counting
+ *  sort, so each bucket keeps its objects in list order.
+ */
+#define GRID_BUCKET_SIZE    64
+#define GRID_COLUMNS        40
+#define GRID_ROWS           32
+#define GRID_BUCKETS        (GRID_COLUMNS * GRID_ROWS)
+
+struct GridEntryStruct
+{
+    int Index;
+    Point2D Position;
+};
+
+static std::vector<GridEntryStruct> GridEntries;
+static int GridBucketStart[GRID_BUCKETS+1];
+
+static int Grid_Column(int x)
+{
+    int column = (x >= 0) ? (x / GRID_BUCKET_SIZE) : 0;
+    return (column < GRID_COLUMNS) ? column : (GRID_COLUMNS - 1);
+}
+
+static int Grid_Row(int y)
+{
+    int row = (y >= 0) ? (y / GRID_BUCKET_SIZE) : 0;
+    return (row < GRID_ROWS) ? row : (GRID_ROWS - 1);
+}
+
+static void Grid_Build(const DirtyObjectStruct *dirty, int count, const Point2D &offset)
+{
+    std::memset(GridBucketStart, 0, sizeof(GridBucketStart));
+    GridEntries.resize(count);
+
+    for (int i = 0; i < count; ++i) {
+        Point2D position = dirty[i].Position - offset;
+        ++GridBucketStart[Grid_Row(position.Y) * GRID_COLUMNS + Grid_Column(position.X) + 1];
+    }
+
+    for (int i = 0; i < GRID_BUCKETS; ++i) {
+        GridBucketStart[i+1] += GridBucketStart[i];
+    }
+
+    int fill[GRID_BUCKETS];
+    std::memcpy(fill, GridBucketStart, sizeof(fill));
+
+    for (int i = 0; i < count; ++i) {
+        Point2D position = dirty[i].Position - offset;
+        GridEntryStruct &entry = GridEntries[fill[Grid_Row(position.Y) * GRID_COLUMNS + Grid_Column(position.X)]++];
+        entry.Index = i;
+        entry.Position = position;
+    }
+}
+
+static void Grid_Query(const DirtyObjectStruct *dirty, const Rect &rect, std::vector<int> &selected)
+{
+    selected.clear();
+
+    int column_end = Grid_Column(rect.X + rect.Width - 1);
+    int row_end = Grid_Row(rect.Y + rect.Height - 1);
+
+    for (int row = Grid_Row(rect.Y); row <= row_end; ++row) {
+        for (int column = Grid_Column(rect.X); column <= column_end; ++column) {
+            int bucket = row * GRID_COLUMNS + column;
+            for (int i = GridBucketStart[bucket]; i < GridBucketStart[bucket+1]; ++i) {
+                if (rect.Is_Within(GridEntries[i].Position)) {
+                    selected.push_back(GridEntries[i].Index);
+                }
+            }
+        }
+    }
+
+    /**
+     *  Back into list order, so the selection order matches the scan.
+     */
+    std::sort(selected.begin(), selected.end());
+
+    size_t out = 0;
+    for (size_t i = 0; i < selected.size(); ++i) {
+        if (dirty[selected[i]].Object->IsActive) {
+            selected[out++] = selected[i];
+        }
+    }
+    selected.resize(out);
+}
+
+
+/**
+ *  The scan Select_These does today.
+ */
+static void Linear_Query(const DirtyObjectStruct *dirty, int count, const Point2D &offset, const Rect &rect, std::vector<int> &selected)
+{
+    selected.clear();
+
+    for (int i = 0; i < count; ++i) {
+        if (dirty[i].Object && dirty[i].Object->IsActive) {
+            if (rect.Is_Within(dirty[i].Position - offset)) {
+                selected.push_back(i);
+            }
+        }
+    }
+}
+
+
+static unsigned Random_Seed = 1;
+
+static unsigned Random()
+{
+    Random_Seed ^= Random_Seed << 13;
+    Random_Seed ^= Random_Seed >> 17;
+    Random_Seed ^= Random_Seed << 5;
+    return Random_Seed;
+}
+
+
+static double Now()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/**
+ *  Frames the band box is drawn for before it is released, about half a
+ *  second of dragging at the default game speed.
+ */
+#define DRAG_FRAMES     30
+
+
+static void Run(int object_count, int box_size, int releases)
+{
+    /**
+     *  Allocate more objects than are on screen and use a shuffled subset,
+     *  so neighbours in the dirty list are not neighbours in memory.
+     */
+    std::vector<std::unique_ptr<FakeObject>> pool(object_count * 4);
+    for (auto &object : pool) {
+        object.reset(new FakeObject());
+        object->IsActive = true;
+    }
+    for (size_t i = pool.size() - 1; i > 0; --i) {
+        std::swap(pool[i], pool[Random() % (i + 1)]);
+    }
+
+    const Point2D offset(1200, 800);
+    std::vector<DirtyObjectStruct> dirty(object_count);
+    for (int i = 0; i < object_count; ++i) {
+        dirty[i].Object = pool[i].get();
+        dirty[i].Object->IsActive = (Random() % 50) != 0;
+        dirty[i].Position = Point2D(offset.X + int(Random() % 1024), offset.Y + int(Random() % 768));
+        dirty[i].Flags = 0;
+    }
+
+    std::vector<Rect> boxes(releases);
+    for (auto &box : boxes) {
+        box = Rect(int(Random() % (1024 - box_size)), int(Random() % (768 - box_size)), box_size, box_size);
+    }
+
+    std::vector<int> expected;
+    std::vector<int> selected;
+    size_t total = 0;
+
+    /**
+     *  Correctness first, on the same boxes that are timed.
+     */
+    for (const Rect &box : boxes) {
+        Linear_Query(dirty.data(), object_count, offset, box, expected);
+        Grid_Build(dirty.data(), object_count, offset);
+        Grid_Query(dirty.data(), box, selected);
+        BANDBOX_CHECK(selected == expected);
+    }
+
+    double start = Now();
+    for (const Rect &box : boxes) {
+        Linear_Query(dirty.data(), object_count, offset, box, selected);
+        total += selected.size();
+    }
+    double linear = (Now() - start) / releases;
+
+    start = Now();
+    for (const Rect &box : boxes) {
+        for (int frame = 0; frame < DRAG_FRAMES; ++frame) {
+            Grid_Build(dirty.data(), object_count, offset);
+        }
+        Grid_Query(dirty.data(), box, selected);
+        total += selected.size();
+    }
+    double per_frame = (Now() - start) / releases;
+
+    start = Now();
+    for (const Rect &box : boxes) {
+        Grid_Build(dirty.data(), object_count, offset);
+        Grid_Query(dirty.data(), box, selected);
+        total += selected.size();
+    }
+    double on_release = (Now() - start) / releases;
+
+    std::printf("%7d %7d %12.2f %12.2f %12.2f   (%zu)\n",
+        object_count, box_size, linear, per_frame, on_release, total);
+}
+
+
+int main(int argc, char **argv)
+{
+    int releases = 2000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i+1 < argc) {
+            releases = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: BandBoxBench [-n <releases>]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (releases <= 0) {
+        releases = 1;
+    }
+
+    std::printf("BandBoxBench: Microseconds per band box release.\n");
+    std::printf("%7s %7s %12s %12s %12s\n", "objects", "box", "scan", "grid/frame", "grid/release");
+
+    static const int object_counts[] = { 100, 500, 2000 };
+    static const int box_sizes[] = { 32, 200, 600 };
+
+    for (int objects : object_counts) {
+        for (int box : box_sizes) {
+            Run(objects, box, releases);
+        }
+    }
+
+    std::printf("BandBoxBench: All tests passed.\n");
+
+    return EXIT_SUCCESS;
+}
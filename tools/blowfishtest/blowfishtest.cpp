@@ -0,0 +1,328 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          BLOWFISHTEST.CPP
+ *
+ *  @brief         Known answer and batch tests for the Blowfish engine.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: BlowfishTest [-n <iterations>]
+ *
+ *  Checks the Blowfish engine against the published known answer vectors,
+ *  then checks that batched processing (Encrypt/Decrypt on many blocks,
+ *  BlowPipe and BlowStraw with random chunk sizes) gives the same output as
+ *  processing one block at a time. Also times single block and batched
+ *  processing. Any failed check aborts the tool.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "blowfish.h"
+#include "blowpipe.h"
+#include "blowstraw.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+#define BF_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "BlowfishTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+/**
+ *  Known answer vectors from Eric Young's Blowfish test set, and the
+ *  vector from Bruce Schneier's reference implementation.
+ */
+static const struct {
+    const char *Key;
+    const char *Plain;
+    const char *Cypher;
+} KnownAnswers[] = {
+    { "0000000000000000", "0000000000000000", "4EF997456198DD78" },
+    { "FFFFFFFFFFFFFFFF", "FFFFFFFFFFFFFFFF", "51866FD5B85ECB8A" },
+    { "3000000000000000", "1000000000000001", "7D856F9A613063F2" },
+    { "1111111111111111", "1111111111111111", "2466DD878B963C9D" },
+    { "0123456789ABCDEF", "1111111111111111", "61F9C3802281B096" },
+    { "FEDCBA9876543210", "0123456789ABCDEF", "0ACEAB0FC6A0A28D" },
+    { "7CA110454A1A6E57", "01A1D6D039776742", "59C68245EB05282B" },
+};
+
+
+static int From_Hex(const char *hex, unsigned char *out)
+{
+    int len = 0;
+    for (; hex[0] && hex[1]; hex += 2) {
+        unsigned value = 0;
+        std::sscanf(hex, "%2x", &value);
+        out[len++] = (unsigned char)value;
+    }
+    return len;
+}
+
+
+static void Test_Known_Answers()
+{
+    for (const auto &kat : KnownAnswers) {
+        unsigned char key[8];
+        unsigned char plain[8];
+        unsigned char cypher[8];
+        unsigned char buffer[8];
+
+        int keylen = From_Hex(kat.Key, key);
+        From_Hex(kat.Plain, plain);
+        From_Hex(kat.Cypher, cypher);
+
+        BlowfishEngine bf;
+        bf.Submit_Key(key, keylen);
+
+        BF_CHECK(bf.Encrypt(plain, 8, buffer) == 8);
+        BF_CHECK(std::memcmp(buffer, cypher, 8) == 0);
+
+        BF_CHECK(bf.Decrypt(buffer, 8, buffer) == 8);
+        BF_CHECK(std::memcmp(buffer, plain, 8) == 0);
+    }
+
+    /**
+     *  Schneier's reference vector.
+     */
+    const char *key = "abcdefghijklmnopqrstuvwxyz";
+    unsigned char cypher[8];
+    unsigned char expected[8];
+    From_Hex("324ED0FEF413A203", expected);
+
+    BlowfishEngine bf;
+    bf.Submit_Key(key, (int)std::strlen(key));
+    bf.Encrypt("BLOWFISH", 8, cypher);
+    BF_CHECK(std::memcmp(cypher, expected, 8) == 0);
+}
+
+
+static unsigned Random_Seed = 1;
+
+static unsigned Random()
+{
+    Random_Seed ^= Random_Seed << 13;
+    Random_Seed ^= Random_Seed >> 17;
+    Random_Seed ^= Random_Seed << 5;
+    return Random_Seed;
+}
+
+
+static std::vector<unsigned char> Random_Bytes(int length)
+{
+    std::vector<unsigned char> bytes(length);
+    for (int i = 0; i < length; ++i) {
+        bytes[i] = (unsigned char)Random();
+    }
+    return bytes;
+}
+
+
+/**
+ *  Process the data one block per engine call, passing a trailing partial
+ *  block through, the way the engine did before batching.
+ */
+static std::vector<unsigned char> Single_Blocks(BlowfishEngine &bf, const std::vector<unsigned char> &input, bool decrypt)
+{
+    std::vector<unsigned char> output(input);
+    for (size_t i = 0; i + 8 <= output.size(); i += 8) {
+        if (decrypt) {
+            bf.Decrypt(&output[i], 8, &output[i]);
+        } else {
+            bf.Encrypt(&output[i], 8, &output[i]);
+        }
+    }
+    return output;
+}
+
+
+/**
+ *  Collects everything put into it.
+ */
+class CollectPipeClass : public Pipe
+{
+    public:
+        virtual int Put(const void *source, int slen) override
+        {
+            Data.insert(Data.end(), (const unsigned char *)source, (const unsigned char *)source + slen);
+            return slen;
+        }
+
+        std::vector<unsigned char> Data;
+};
+
+
+/**
+ *  Hands out a buffer.
+ */
+class BufferStrawClass : public Straw
+{
+    public:
+        BufferStrawClass(const std::vector<unsigned char> &data) : Data(data), Position(0) {}
+
+        virtual int Get(void *source, int slen) override
+        {
+            int count = (int)Data.size() - Position;
+            if (count > slen) {
+                count = slen;
+            }
+            std::memcpy(source, &Data[0] + Position, count);
+            Position += count;
+            return count;
+        }
+
+    private:
+        const std::vector<unsigned char> &Data;
+        int Position;
+};
+
+
+static void Test_Batches(long iterations)
+{
+    for (long i = 0; i < iterations; ++i) {
+
+        std::vector<unsigned char> key = Random_Bytes(4 + Random() % 52);
+        std::vector<unsigned char> input = Random_Bytes(Random() % 2000);
+        bool decrypt = (Random() & 1) != 0;
+
+        BlowfishEngine bf;
+        bf.Submit_Key(&key[0], (int)key.size());
+
+        std::vector<unsigned char> expected = Single_Blocks(bf, input, decrypt);
+
+        /**
+         *  Whole buffer through the engine.
+         */
+        std::vector<unsigned char> output(input.size());
+        int processed = decrypt
+            ? bf.Decrypt(input.data(), (int)input.size(), output.data())
+            : bf.Encrypt(input.data(), (int)input.size(), output.data());
+        BF_CHECK(processed == int(input.size() / 8) * 8);
+        BF_CHECK(output == expected);
+
+        /**
+         *  In place.
+         */
+        output = input;
+        if (decrypt) {
+            bf.Decrypt(output.data(), (int)output.size(), output.data());
+        } else {
+            bf.Encrypt(output.data(), (int)output.size(), output.data());
+        }
+        BF_CHECK(output == expected);
+
+        /**
+         *  Through a BlowPipe in random chunks.
+         */
+        CollectPipeClass collect;
+        BlowPipe pipe(decrypt ? BlowPipe::DECRYPT : BlowPipe::ENCRYPT);
+        pipe.Key(&key[0], (int)key.size());
+        pipe.Put_To(collect);
+
+        for (size_t pos = 0; pos < input.size(); ) {
+            size_t chunk = 1 + Random() % 700;
+            if (chunk > input.size() - pos) {
+                chunk = input.size() - pos;
+            }
+            pipe.Put(&input[pos], (int)chunk);
+            pos += chunk;
+        }
+        pipe.Flush();
+        BF_CHECK(collect.Data == expected);
+
+        /**
+         *  Through a BlowStraw in random chunks.
+         */
+        BufferStrawClass source(input);
+        BlowStraw straw(decrypt ? BlowStraw::DECRYPT : BlowStraw::ENCRYPT);
+        straw.Key(&key[0], (int)key.size());
+        straw.Get_From(source);
+
+        std::vector<unsigned char> drawn;
+        for (;;) {
+            unsigned char chunk[700];
+            int count = straw.Get(chunk, 1 + Random() % sizeof(chunk));
+            if (count == 0) {
+                break;
+            }
+            drawn.insert(drawn.end(), chunk, chunk + count);
+        }
+        BF_CHECK(drawn == expected);
+    }
+}
+
+
+static void Benchmark()
+{
+    std::vector<unsigned char> key = Random_Bytes(56);
+    std::vector<unsigned char> data = Random_Bytes(1024 * 1024);
+
+    BlowfishEngine bf;
+    bf.Submit_Key(&key[0], (int)key.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < 16; ++pass) {
+        for (size_t i = 0; i < data.size(); i += 8) {
+            bf.Encrypt(&data[i], 8, &data[i]);
+        }
+    }
+    double single = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < 16; ++pass) {
+        bf.Encrypt(data.data(), (int)data.size(), data.data());
+    }
+    double batched = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("BlowfishTest: Single blocks %.1f MB/s, batched %.1f MB/s.\n", 16.0 / single, 16.0 / batched);
+}
+
+
+int main(int argc, char **argv)
+{
+    long iterations = 2000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i+1 < argc) {
+            iterations = std::strtol(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "Usage: BlowfishTest [-n <iterations>]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    Test_Known_Answers();
+    Test_Batches(iterations);
+
+    std::printf("BlowfishTest: All tests passed.\n");
+
+    Benchmark();
+
+    return EXIT_SUCCESS;
+}
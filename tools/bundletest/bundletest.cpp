@@ -0,0 +1,381 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          BUNDLETEST.CPP
+ *
+ *  @brief         Build and unzip test for the debug bundle archive.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: BundleTest [-k]
+ *
+ *  Builds a bundle the same way Vinifera_Collect_Debug_Files() does. Files
+ *  on disk are streamed in through a shared read handle, and the log tail
+ *  and manifest are added from memory. The archive is then checked twice:
+ *
+ *    - The central directory is parsed by hand, and the name, size and CRC
+ *      of each entry are compared against the source data.
+ *    - Each entry is inflated with XUnzip and compared byte for byte.
+ *
+ *  The source files include one larger than the zip stream buffers, one
+ *  that does not compress and an empty one. Any failed check aborts the
+ *  tool. Pass -k to keep the archive for inspection with other tools.
+ *
+ *  This tool uses the Win32 file API through XZip, so it is only built for
+ *  Windows.
+ */
+#include <windows.h>
+#include "XZip.h"
+#include "XUnzip.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+#define BT_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "BundleTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+#define BUNDLE_TEST_ARCHIVE     "BUNDLETEST.ZIP"
+
+
+struct BundleItemStruct
+{
+    std::string Name;
+    std::vector<unsigned char> Data;
+    bool IsDiskFile;
+};
+
+
+static uint32_t RandomSeed = 0x2545F491;
+
+
+static uint32_t Random()
+{
+    RandomSeed ^= RandomSeed << 13;
+    RandomSeed ^= RandomSeed >> 17;
+    RandomSeed ^= RandomSeed << 5;
+    return RandomSeed;
+}
+
+
+/**
+ *  The standard zip CRC-32, calculated independently of the zip library.
+ */
+static uint32_t Zip_CRC32(const unsigned char *data, size_t size)
+{
+    static uint32_t table[256];
+    static bool table_built = false;
+
+    if (!table_built) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        table_built = true;
+    }
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+
+static uint16_t Read_U16(const unsigned char *p)
+{
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+
+static uint32_t Read_U32(const unsigned char *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+
+/**
+ *  Text that looks like log output, so it compresses well.
+ */
+static std::vector<unsigned char> Make_Log_Data(int size)
+{
+    std::vector<unsigned char> data;
+    char line[128];
+
+    while (int(data.size()) < size) {
+        int len = std::snprintf(line, sizeof(line), "[%08u] Processed frame %u, %u objects, %u ms.\r\n",
+            Random() % 100000, Random() % 100000, Random() % 4096, Random() % 100);
+        data.insert(data.end(), line, line + len);
+    }
+
+    data.resize(size);
+    return data;
+}
+
+
+/**
+ *  Random bytes, like a crash dump or save game, which do not compress.
+ */
+static std::vector<unsigned char> Make_Binary_Data(int size)
+{
+    std::vector<unsigned char> data(size);
+    for (int i = 0; i < size; ++i) {
+        data[i] = (unsigned char)Random();
+    }
+    return data;
+}
+
+
+static void Write_Disk_File(const char *filename, const std::vector<unsigned char> &data)
+{
+    FILE *fp = std::fopen(filename, "wb");
+    BT_CHECK(fp != nullptr);
+    if (!data.empty()) {
+        BT_CHECK(std::fwrite(&data[0], 1, data.size(), fp) == data.size());
+    }
+    std::fclose(fp);
+}
+
+
+static std::vector<unsigned char> Read_Disk_File(const char *filename)
+{
+    std::vector<unsigned char> data;
+
+    FILE *fp = std::fopen(filename, "rb");
+    BT_CHECK(fp != nullptr);
+
+    unsigned char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+
+    std::fclose(fp);
+    return data;
+}
+
+
+/**
+ *  Adds the file to the archive through a shared read handle, as the bundle does.
+ */
+static ZRESULT Zip_Add_File(HZIP hZip, const char *name, const char *filename)
+{
+    HANDLE handle = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return ZR_NOFILE;
+    }
+
+    ZRESULT zresult = ZipAdd(hZip, name, handle, 0, ZIP_HANDLE);
+
+    CloseHandle(handle);
+
+    return zresult;
+}
+
+
+static void Build_Bundle(std::vector<BundleItemStruct> &items)
+{
+    HZIP hZip = CreateZip((void *)BUNDLE_TEST_ARCHIVE, 0, ZIP_FILENAME);
+    BT_CHECK(hZip != nullptr);
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        BundleItemStruct &item = items[i];
+        if (item.IsDiskFile) {
+            Write_Disk_File(item.Name.c_str(), item.Data);
+            BT_CHECK(Zip_Add_File(hZip, item.Name.c_str(), item.Name.c_str()) == ZR_OK);
+        } else {
+            BT_CHECK(ZipAdd(hZip, item.Name.c_str(), item.Data.empty() ? nullptr : &item.Data[0], (unsigned)item.Data.size(), ZIP_MEMORY) == ZR_OK);
+        }
+    }
+
+    BT_CHECK(CloseZip(hZip) == ZR_OK);
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (items[i].IsDiskFile) {
+            DeleteFile(items[i].Name.c_str());
+        }
+    }
+}
+
+
+/**
+ *  Walks the central directory of the archive and checks each entry.
+ */
+static void Check_Central_Directory(const std::vector<BundleItemStruct> &items)
+{
+    std::vector<unsigned char> zip = Read_Disk_File(BUNDLE_TEST_ARCHIVE);
+    BT_CHECK(zip.size() >= 22);
+
+    /**
+     *  Find the end of central directory record, there is no archive comment.
+     */
+    size_t eocd = zip.size() - 22;
+    BT_CHECK(Read_U32(&zip[eocd]) == 0x06054B50);
+
+    int entry_count = Read_U16(&zip[eocd + 10]);
+    uint32_t cd_size = Read_U32(&zip[eocd + 12]);
+    uint32_t cd_offset = Read_U32(&zip[eocd + 16]);
+
+    BT_CHECK(entry_count == int(items.size()));
+    BT_CHECK(cd_offset + cd_size == eocd);
+
+    size_t pos = cd_offset;
+    for (int i = 0; i < entry_count; ++i) {
+        BT_CHECK(pos + 46 <= eocd);
+        BT_CHECK(Read_U32(&zip[pos]) == 0x02014B50);
+
+        uint32_t crc = Read_U32(&zip[pos + 16]);
+        uint32_t comp_size = Read_U32(&zip[pos + 20]);
+        uint32_t unc_size = Read_U32(&zip[pos + 24]);
+        int name_len = Read_U16(&zip[pos + 28]);
+        int extra_len = Read_U16(&zip[pos + 30]);
+        int comment_len = Read_U16(&zip[pos + 32]);
+        uint32_t local_offset = Read_U32(&zip[pos + 42]);
+
+        BT_CHECK(pos + 46 + name_len <= eocd);
+        std::string name((const char *)&zip[pos + 46], name_len);
+
+        const BundleItemStruct &item = items[i];
+        const unsigned char *data = item.Data.empty() ? nullptr : &item.Data[0];
+
+        BT_CHECK(name == item.Name);
+        BT_CHECK(unc_size == item.Data.size());
+        BT_CHECK(crc == Zip_CRC32(data, item.Data.size()));
+
+        /**
+         *  The local header and the compressed data must lie before the central directory.
+         */
+        BT_CHECK(local_offset + 30 <= cd_offset);
+        BT_CHECK(Read_U32(&zip[local_offset]) == 0x04034B50);
+        int local_name_len = Read_U16(&zip[local_offset + 26]);
+        int local_extra_len = Read_U16(&zip[local_offset + 28]);
+        BT_CHECK(local_offset + 30 + local_name_len + local_extra_len + comp_size <= cd_offset);
+
+        std::printf("  %-24s %9u -> %9u bytes, CRC %08X\n", name.c_str(), unc_size, comp_size, crc);
+
+        pos += 46 + name_len + extra_len + comment_len;
+    }
+
+    BT_CHECK(pos == eocd);
+}
+
+
+/**
+ *  Inflates each entry with XUnzip and compares it with the source data.
+ */
+static void Check_Unzip(const std::vector<BundleItemStruct> &items)
+{
+    HZIP hZip = OpenZip((void *)BUNDLE_TEST_ARCHIVE, 0, ZIP_FILENAME);
+    BT_CHECK(hZip != nullptr);
+
+    ZIPENTRY entry;
+    BT_CHECK(GetZipItem(hZip, -1, &entry) == ZR_OK);
+    BT_CHECK(entry.index == int(items.size()));
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        const BundleItemStruct &item = items[i];
+
+        int index = -1;
+        BT_CHECK(FindZipItem(hZip, item.Name.c_str(), false, &index, &entry) == ZR_OK);
+        BT_CHECK(index == int(i));
+        BT_CHECK(entry.unc_size == long(item.Data.size()));
+
+        /**
+         *  One spare byte, so an entry that inflates to more than its stated size fails.
+         */
+        std::vector<unsigned char> data(item.Data.size() + 1);
+        BT_CHECK(UnzipItem(hZip, index, &data[0], (unsigned)data.size(), ZIP_MEMORY) == ZR_OK);
+        BT_CHECK(std::memcmp(&data[0], item.Data.empty() ? "" : (const char *)&item.Data[0], item.Data.size()) == 0);
+    }
+
+    BT_CHECK(CloseZip(hZip) == ZR_OK);
+}
+
+
+int main(int argc, char **argv)
+{
+    bool keep = (argc > 1 && std::strcmp(argv[1], "-k") == 0);
+
+    std::vector<BundleItemStruct> items;
+
+    BundleItemStruct item;
+
+    item.Name = "LOG_TAIL.TXT";
+    item.Data = Make_Log_Data(256 * 1024);
+    item.IsDiskFile = false;
+    items.push_back(item);
+
+    item.Name = "EXCEPT_TEST.TXT";
+    item.Data = Make_Log_Data(3000);
+    item.IsDiskFile = true;
+    items.push_back(item);
+
+    item.Name = "DEBUG_TEST.LOG";
+    item.Data = Make_Log_Data(6 * 1024 * 1024 + 123);
+    item.IsDiskFile = true;
+    items.push_back(item);
+
+    item.Name = "CRASHDUMP_TEST.DMP";
+    item.Data = Make_Binary_Data(2 * 1024 * 1024 + 7);
+    item.IsDiskFile = true;
+    items.push_back(item);
+
+    item.Name = "STACK_TEST_000.BIN";
+    item.Data.clear();
+    item.IsDiskFile = true;
+    items.push_back(item);
+
+    item.Name = "MANIFEST.TXT";
+    item.Data = Make_Log_Data(700);
+    item.IsDiskFile = false;
+    items.push_back(item);
+
+    std::printf("Building bundle \"%s\".\n", BUNDLE_TEST_ARCHIVE);
+    Build_Bundle(items);
+
+    std::printf("Checking central directory.\n");
+    Check_Central_Directory(items);
+
+    std::printf("Checking unzip.\n");
+    Check_Unzip(items);
+
+    if (!keep) {
+        DeleteFile(BUNDLE_TEST_ARCHIVE);
+    }
+
+    std::printf("All checks passed.\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,247 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          EXTLISTTEST.CPP
+ *
+ *  @brief         Consistency tests and lookup benchmark for the extension list.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: ExtListTest [-n <operations>] [-s <seed>]
+ *
+ *  Creates and destroys extensions at random in an ExtensionListClass, and
+ *  after every operation checks the list and its lookup table against a
+ *  simple reference. It also moves every base object and rebuilds the table,
+ *  as a load game does, then checks lookups only find the new pointers.
+ *  Finally it compares the lookup time with a linear search of the list, as
+ *  Extension::List::Fetch did before. Any failed check aborts the tool.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "extension_list.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+
+#define LIST_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "ExtListTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+/**
+ *  The number of base objects the random operations pick from.
+ */
+#define BASE_POOL_SIZE  512
+
+
+struct TestBaseStruct
+{
+    int Value;
+};
+
+
+/**
+ *  Stands in for a list based extension, which only needs This().
+ */
+class TestExtension
+{
+    public:
+        TestExtension(const TestBaseStruct *base) : Base(base) {}
+
+        const TestBaseStruct *This() const { return Base; }
+        void Assign_This(const TestBaseStruct *base) { Base = base; }
+
+    private:
+        const TestBaseStruct *Base;
+};
+
+
+/**
+ *  Checks the list against the reference, where Reference[i] is the
+ *  extension of Pool[i] or null.
+ */
+static void Check_List(const ExtensionListClass<TestExtension> &list, const TestBaseStruct *pool,
+    const std::vector<TestExtension *> &reference)
+{
+    int live = 0;
+
+    for (int i = 0; i < BASE_POOL_SIZE; ++i) {
+        LIST_CHECK(list.Find(&pool[i]) == reference[i]);
+        if (reference[i]) {
+            LIST_CHECK(list.Is_Present(reference[i]));
+            ++live;
+        }
+    }
+
+    LIST_CHECK(list.Count() == live);
+    LIST_CHECK(list.Find(nullptr) == nullptr);
+}
+
+
+static void Test_Random(int operations, unsigned seed)
+{
+    static TestBaseStruct pool[BASE_POOL_SIZE];
+    static TestBaseStruct moved_pool[BASE_POOL_SIZE];
+
+    ExtensionListClass<TestExtension> list;
+    std::vector<TestExtension *> reference(BASE_POOL_SIZE, nullptr);
+    std::mt19937 rng(seed);
+
+    Check_List(list, pool, reference);
+
+    for (int op = 0; op < operations; ++op) {
+        int index = int(rng() % BASE_POOL_SIZE);
+
+        /**
+         *  Bias towards creating while the list is small and destroying
+         *  while it is large, so the table grows and shrinks more than once.
+         */
+        int target = (op / 4096) % 2 ? BASE_POOL_SIZE / 8 : BASE_POOL_SIZE - BASE_POOL_SIZE / 8;
+        bool create = int(rng() % BASE_POOL_SIZE) >= (list.Count() * BASE_POOL_SIZE / (target * 2));
+
+        if (create && !reference[index]) {
+            TestExtension *ext = new TestExtension(&pool[index]);
+            LIST_CHECK(list.Add(ext));
+            reference[index] = ext;
+
+        } else if (!create && reference[index]) {
+            LIST_CHECK(list.Remove(reference[index]));
+            LIST_CHECK(!list.Remove(reference[index]));
+            delete reference[index];
+            reference[index] = nullptr;
+        }
+
+        /**
+         *  The full check is slow, check one lookup each time and the whole
+         *  list now and again.
+         */
+        LIST_CHECK(list.Find(&pool[index]) == reference[index]);
+        if ((op % 256) == 0) {
+            Check_List(list, pool, reference);
+        }
+    }
+
+    Check_List(list, pool, reference);
+
+    /**
+     *  Move every base object, as the load of a saved game does, then rebuild.
+     */
+    for (int i = 0; i < list.Count(); ++i) {
+        TestExtension *ext = list[i];
+        int index = int(ext->This() - pool);
+        ext->Assign_This(&moved_pool[index]);
+    }
+
+    list.Rebuild();
+
+    for (int i = 0; i < BASE_POOL_SIZE; ++i) {
+        LIST_CHECK(list.Find(&pool[i]) == nullptr);
+    }
+    Check_List(list, moved_pool, reference);
+
+    for (int i = 0; i < BASE_POOL_SIZE; ++i) {
+        delete reference[i];
+    }
+    list.Clear();
+
+    LIST_CHECK(list.Count() == 0);
+    LIST_CHECK(list.Find(&moved_pool[0]) == nullptr);
+
+    std::printf("ExtListTest: %d random operations passed.\n", operations);
+}
+
+
+static void Benchmark(int count)
+{
+    std::vector<TestBaseStruct> bases(count);
+    ExtensionListClass<TestExtension> list;
+
+    for (int i = 0; i < count; ++i) {
+        list.Add(new TestExtension(&bases[i]));
+    }
+
+    const int lookups = 2000000;
+    std::mt19937 rng(1234);
+    std::vector<int> order(4096);
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = int(rng() % count);
+    }
+
+    uintptr_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        sink += uintptr_t(list.Find(&bases[order[i & 4095]]));
+    }
+    double table_time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        const TestBaseStruct *base = &bases[order[i & 4095]];
+        for (int index = 0; index < list.Count(); ++index) {
+            if (list[index]->This() == base) {
+                sink += uintptr_t(list[index]);
+                break;
+            }
+        }
+    }
+    double linear_time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+
+    std::printf("ExtListTest: %5d entries: table %6.1f ns, linear %8.1f ns per lookup (%u).\n",
+        count, table_time, linear_time, unsigned(sink & 1));
+
+    for (int i = 0; i < list.Count(); ++i) {
+        delete list[i];
+    }
+    list.Clear();
+}
+
+
+int main(int argc, char **argv)
+{
+    int operations = 200000;
+    unsigned seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i+1 < argc) {
+            operations = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-s") && i+1 < argc) {
+            seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+
+    Test_Random(operations, seed);
+
+    Benchmark(16);
+    Benchmark(100);
+    Benchmark(1000);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          FRAMEPACERTEST.CPP
+ *
+ *  @brief         Simulated clock tests for the frame pacer.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: FramePacerTest
+ *
+ *  Runs FramePacerClass against a simulated clock, so the results do not
+ *  depend on the load of the machine running the tests. Each read of the
+ *  clock advances it by one tick, which stands in for the time spent
+ *  spinning on the deadline. The tests check that:
+ *
+ *    - A loop that keeps up wakes on every deadline, with no drift and no
+ *      missed deadlines, and the statistics report the frame period.
+ *    - The first frame is never counted as a missed deadline.
+ *    - A frame that overruns by less than a period counts one missed
+ *      deadline, and the loop then returns to its original schedule.
+ *    - A stall of several periods counts one missed deadline, and the
+ *      schedule restarts from the end of the stall.
+ *
+ *  Any failed check aborts the tool.
+ *
+ *  The frame pacer uses the Win32 waitable timer, so this tool is only
+ *  built for Windows. The timer is not used with a simulated clock.
+ */
+#include "framepacer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+#define FP_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "FramePacerTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+#define CLOCK_FREQUENCY     1000000
+#define FRAME_RATE          60
+#define FRAME_PERIOD        (CLOCK_FREQUENCY / FRAME_RATE)
+
+
+static LONGLONG ClockTime = 0;
+
+
+static LONGLONG Simulated_Clock()
+{
+    return ClockTime++;
+}
+
+
+/**
+ *  Waits for the next frame, then spends the work time on the frame. Returns
+ *  the time the pacer released the frame.
+ */
+static LONGLONG Run_Frame(LONGLONG work)
+{
+    FramePacerClass::Wait_For_Frame(FRAME_RATE);
+    LONGLONG released = ClockTime;
+
+    FramePacerClass::Record_Frame();
+
+    ClockTime += work;
+    return released;
+}
+
+
+/**
+ *  Checks the frame was released on its deadline, allowing for the ticks
+ *  taken by the reads of the clock.
+ */
+static bool Is_On_Deadline(LONGLONG released, LONGLONG deadline)
+{
+    return released >= deadline && released <= deadline + 4;
+}
+
+
+static void Reset_Clock()
+{
+    ClockTime = 0;
+    FramePacerClass::Set_Clock(Simulated_Clock, CLOCK_FREQUENCY);
+}
+
+
+static void Test_Steady()
+{
+    Reset_Clock();
+
+    for (int frame = 1; frame <= 600; ++frame) {
+        LONGLONG released = Run_Frame(4000);
+        FP_CHECK(Is_On_Deadline(released, LONGLONG(frame) * FRAME_PERIOD));
+    }
+
+    FramePacerClass::StatisticsStruct stats = FramePacerClass::Get_Statistics();
+    double period_ms = double(FRAME_PERIOD) * 1000.0 / double(CLOCK_FREQUENCY);
+
+    FP_CHECK(stats.MissedDeadlines == 0);
+    FP_CHECK(stats.Samples > 0);
+    FP_CHECK(stats.Median > period_ms - 0.01 && stats.Median < period_ms + 0.01);
+    FP_CHECK(stats.Percentile99 < period_ms + 0.01);
+
+    std::printf("FramePacerTest: Steady, median %.3f ms, 99th percentile %.3f ms.\n", stats.Median, stats.Percentile99);
+}
+
+
+static void Test_First_Frame()
+{
+    Reset_Clock();
+
+    /**
+     *  Start well past the first deadline, as the game does.
+     */
+    ClockTime = 50 * FRAME_PERIOD;
+    Run_Frame(1000);
+
+    FP_CHECK(FramePacerClass::Get_Statistics().MissedDeadlines == 0);
+
+    std::printf("FramePacerTest: First frame not counted as missed.\n");
+}
+
+
+static void Test_Overrun()
+{
+    Reset_Clock();
+
+    int frame = 1;
+    for (; frame <= 100; ++frame) {
+        Run_Frame(4000);
+    }
+
+    /**
+     *  This frame takes one and a half periods.
+     */
+    Run_Frame(FRAME_PERIOD + FRAME_PERIOD / 2);
+    ++frame;
+
+    /**
+     *  The next deadline has passed, so the frame is released at once.
+     */
+    LONGLONG released = Run_Frame(1000);
+    FP_CHECK(released > LONGLONG(frame) * FRAME_PERIOD);
+    FP_CHECK(FramePacerClass::Get_Statistics().MissedDeadlines == 1);
+    ++frame;
+
+    /**
+     *  Then the loop is back on its original schedule.
+     */
+    for (; frame <= 200; ++frame) {
+        released = Run_Frame(4000);
+        FP_CHECK(Is_On_Deadline(released, LONGLONG(frame) * FRAME_PERIOD));
+    }
+
+    FP_CHECK(FramePacerClass::Get_Statistics().MissedDeadlines == 1);
+
+    std::printf("FramePacerTest: Overrun counted once and schedule kept.\n");
+}
+
+
+static void Test_Stall()
+{
+    Reset_Clock();
+
+    for (int frame = 1; frame <= 100; ++frame) {
+        Run_Frame(4000);
+    }
+
+    /**
+     *  This frame stalls for five periods.
+     */
+    Run_Frame(5 * FRAME_PERIOD);
+    LONGLONG stall_end = ClockTime;
+
+    LONGLONG released = Run_Frame(1000);
+    FP_CHECK(released <= stall_end + 4);
+    FP_CHECK(FramePacerClass::Get_Statistics().MissedDeadlines == 1);
+
+    /**
+     *  The schedule restarts from the end of the stall, without a burst of frames.
+     */
+    LONGLONG restart = released - 1;
+    for (int frame = 1; frame <= 100; ++frame) {
+        released = Run_Frame(4000);
+        FP_CHECK(Is_On_Deadline(released, restart + LONGLONG(frame) * FRAME_PERIOD));
+    }
+
+    FP_CHECK(FramePacerClass::Get_Statistics().MissedDeadlines == 1);
+
+    std::printf("FramePacerTest: Stall counted once and schedule restarted.\n");
+}
+
+
+int main()
+{
+    Test_Steady();
+    Test_First_Frame();
+    Test_Overrun();
+    Test_Stall();
+
+    FramePacerClass::Set_Clock(nullptr, 0);
+
+    std::printf("FramePacerTest: All tests passed.\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,426 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          HEAPTEST.CPP
+ *
+ *  @brief         Unit tests and allocation churn benchmark for the small heap.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: HeapTest [-n <iterations>] [-t <threads>]
+ *
+ *  Runs the small heap unit tests, then an allocation churn benchmark that
+ *  compares the small heap against the C runtime heap. Any failed check
+ *  aborts the tool.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "smallheap.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+#define HEAP_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "HeapTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+/**
+ *  The size of the test region.
+ */
+#define TEST_REGION_SIZE    (16 * 1024 * 1024)
+
+
+/**
+ *  A small heap with its own zero filled region.
+ */
+class TestHeapClass
+{
+    public:
+        TestHeapClass(bool tracking, size_t size = TEST_REGION_SIZE) :
+            Region(std::calloc(1, size)),
+            Heap(new SmallHeapClass())
+        {
+            HEAP_CHECK(Region != nullptr);
+            HEAP_CHECK(Heap->Init(Region, size, nullptr, tracking));
+        }
+
+        ~TestHeapClass()
+        {
+            delete Heap;
+            std::free(Region);
+        }
+
+        SmallHeapClass *operator->() { return Heap; }
+
+    private:
+        void *Region;
+        SmallHeapClass *Heap;
+};
+
+
+static bool Is_Zero(const void *ptr, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)ptr;
+    for (size_t i = 0; i < size; ++i) {
+        if (p[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ *  Every size is allocated zero filled, aligned, owned by the heap and does
+ *  not overlap any other block; sizes above the limit are refused.
+ */
+static void Test_Allocate(bool tracking)
+{
+    TestHeapClass heap(tracking);
+
+    std::vector<unsigned char *> blocks;
+    std::vector<size_t> sizes;
+
+    for (size_t size = 0; size <= SmallHeapClass::Max_Size(); ++size) {
+        unsigned char *ptr = (unsigned char *)heap->Allocate(size);
+        if (tracking && size + SMALL_HEAP_HEADER_SIZE + SMALL_HEAP_GUARD_SIZE > SmallHeapClass::Max_Size()) {
+            HEAP_CHECK(ptr == nullptr);
+            continue;
+        }
+        HEAP_CHECK(ptr != nullptr);
+        HEAP_CHECK(((uintptr_t)ptr % SMALL_HEAP_GRANULE) == 0);
+        HEAP_CHECK(heap->Owns(ptr));
+        HEAP_CHECK(heap->Size(ptr) >= size);
+        HEAP_CHECK(Is_Zero(ptr, heap->Size(ptr)));
+        std::memset(ptr, (int)(size & 0xFF) | 1, size);
+        blocks.push_back(ptr);
+        sizes.push_back(size);
+    }
+
+    HEAP_CHECK(heap->Allocate(SmallHeapClass::Max_Size() + 1) == nullptr);
+    HEAP_CHECK(heap->Live_Count() == blocks.size());
+
+    /**
+     *  Nothing overwrote another block.
+     */
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        for (size_t i = 0; i < sizes[b]; ++i) {
+            HEAP_CHECK(blocks[b][i] == ((sizes[b] & 0xFF) | 1));
+        }
+    }
+
+    for (unsigned char *ptr : blocks) {
+        HEAP_CHECK(heap->Free(ptr) == SMALL_HEAP_FREE_OK);
+    }
+
+    HEAP_CHECK(heap->Live_Count() == 0);
+    HEAP_CHECK(heap->Live_Bytes() == 0);
+
+    int local = 0;
+    HEAP_CHECK(!heap->Owns(&local));
+    HEAP_CHECK(heap->Free(&local) == SMALL_HEAP_FREE_NOT_OWNED);
+}
+
+
+/**
+ *  Freed blocks are reused, and come back zero filled.
+ */
+static void Test_Reuse()
+{
+    TestHeapClass heap(false);
+
+    void *ptr = heap->Allocate(40);
+    std::memset(ptr, 0xAA, 40);
+    HEAP_CHECK(heap->Free(ptr) == SMALL_HEAP_FREE_OK);
+
+    void *again = heap->Allocate(33);
+    HEAP_CHECK(again == ptr);
+    HEAP_CHECK(Is_Zero(again, heap->Size(again)));
+}
+
+
+/**
+ *  Reallocation keeps the contents and zero fills what it adds, both in
+ *  place and when the block moves to another size class.
+ */
+static void Test_Reallocate(bool tracking)
+{
+    TestHeapClass heap(tracking);
+
+    unsigned char *ptr = (unsigned char *)heap->Reallocate(nullptr, 10);
+    HEAP_CHECK(ptr != nullptr);
+    std::memset(ptr, 0x11, 10);
+
+    ptr = (unsigned char *)heap->Reallocate(ptr, 4);
+    HEAP_CHECK(ptr != nullptr);
+    ptr = (unsigned char *)heap->Reallocate(ptr, 12);
+    HEAP_CHECK(ptr != nullptr);
+    for (int i = 0; i < 4; ++i) HEAP_CHECK(ptr[i] == 0x11);
+    HEAP_CHECK(Is_Zero(ptr + 4, 8));
+
+    ptr = (unsigned char *)heap->Reallocate(ptr, 500);
+    HEAP_CHECK(ptr != nullptr);
+    for (int i = 0; i < 4; ++i) HEAP_CHECK(ptr[i] == 0x11);
+    HEAP_CHECK(Is_Zero(ptr + 4, 496));
+
+    HEAP_CHECK(heap->Reallocate(ptr, SmallHeapClass::Max_Size() + 1) == nullptr);
+    HEAP_CHECK(heap->Live_Count() == 1);
+
+    HEAP_CHECK(heap->Free(ptr) == SMALL_HEAP_FREE_OK);
+    HEAP_CHECK(heap->Live_Count() == 0);
+}
+
+
+/**
+ *  A full region refuses further blocks rather than failing.
+ */
+static void Test_Exhaust()
+{
+    TestHeapClass heap(false, SMALL_HEAP_RUN_SIZE * 3);
+
+    int count = 0;
+    while (heap->Allocate(1024) != nullptr) {
+        ++count;
+    }
+
+    HEAP_CHECK(count >= SMALL_HEAP_RUN_SIZE / 1024);
+    HEAP_CHECK(heap->Allocate(1000) == nullptr);
+}
+
+
+/**
+ *  Tracking detects overruns, damaged headers and double frees.
+ */
+static void Test_Guards()
+{
+    TestHeapClass heap(true);
+
+    char *ptr = (char *)heap->Allocate(20);
+    ptr[20] = 'x';
+    HEAP_CHECK(heap->Check_All() == 1);
+    HEAP_CHECK(heap->Free(ptr) == SMALL_HEAP_FREE_CORRUPT_TAIL);
+
+    ptr = (char *)heap->Allocate(20);
+    std::memset(ptr - 4, 0, 4);
+    HEAP_CHECK(heap->Free(ptr) == SMALL_HEAP_FREE_CORRUPT_HEAD);
+
+    ptr = (char *)heap->Allocate(20);
+    HEAP_CHECK(heap->Free(ptr) == SMALL_HEAP_FREE_OK);
+    HEAP_CHECK(heap->Free(ptr) == SMALL_HEAP_FREE_DOUBLE);
+}
+
+
+/**
+ *  A block may hold any contents, including the magic values the heap writes
+ *  into its headers and freed blocks, and still be reallocated and freed.
+ */
+static void Test_Any_Contents()
+{
+    const uint32_t patterns[] = { 0x46524545, 0x4C495645, 0xFFFFFFFF, 0xDDDDDDDD, 0 };
+
+    for (bool tracking : { false, true }) {
+        TestHeapClass heap(tracking);
+
+        for (uint32_t pattern : patterns) {
+            for (size_t size : { size_t(8), size_t(24), size_t(64) }) {
+                uint32_t *ptr = (uint32_t *)heap->Allocate(size);
+                for (size_t i = 0; i < size / sizeof(uint32_t); ++i) {
+                    ptr[i] = pattern;
+                }
+
+                uint32_t *grown = (uint32_t *)heap->Reallocate(ptr, size + 8);
+                HEAP_CHECK(grown != nullptr);
+                for (size_t i = 0; i < size / sizeof(uint32_t); ++i) {
+                    HEAP_CHECK(grown[i] == pattern);
+                }
+
+                HEAP_CHECK(heap->Free(grown) == SMALL_HEAP_FREE_OK);
+                HEAP_CHECK(heap->Live_Count() == 0);
+            }
+        }
+    }
+}
+
+
+struct ReportStruct
+{
+    const void *Caller;
+    unsigned Count;
+    size_t Bytes;
+};
+
+static void Report_Callback(const void *caller, unsigned count, size_t bytes, void *data)
+{
+    std::vector<ReportStruct> &report = *(std::vector<ReportStruct> *)data;
+    report.push_back(ReportStruct { caller, count, bytes });
+}
+
+
+/**
+ *  The live block report groups blocks by call site, largest first.
+ */
+static void Test_Report()
+{
+    TestHeapClass heap(true);
+
+    const void *site_a = (const void *)0x1000;
+    const void *site_b = (const void *)0x2000;
+
+    std::vector<void *> blocks;
+    for (int i = 0; i < 10; ++i) blocks.push_back(heap->Allocate(10, site_a));
+    for (int i = 0; i < 3; ++i) blocks.push_back(heap->Allocate(200, site_b));
+
+    heap->Free(blocks[0]);
+
+    std::vector<ReportStruct> report;
+    HEAP_CHECK(heap->Report(Report_Callback, &report) == 2);
+    HEAP_CHECK(report.size() == 2);
+    HEAP_CHECK(report[0].Caller == site_b && report[0].Count == 3 && report[0].Bytes == 600);
+    HEAP_CHECK(report[1].Caller == site_a && report[1].Count == 9 && report[1].Bytes == 90);
+
+    TestHeapClass untracked(false);
+    HEAP_CHECK(untracked->Report(Report_Callback, &report) == -1);
+}
+
+
+/**
+ *  Random allocations, reallocations and frees from several threads, each
+ *  block filled with a pattern that is checked before it is released.
+ */
+static void Churn(SmallHeapClass *heap, unsigned seed, long iterations, bool check)
+{
+    struct Slot { unsigned char *Ptr; size_t Size; unsigned char Fill; };
+    std::vector<Slot> slots(512, Slot { nullptr, 0, 0 });
+
+    for (long i = 0; i < iterations; ++i) {
+        seed = seed * 1103515245U + 12345U;
+        Slot &slot = slots[(seed >> 8) % slots.size()];
+        size_t size = 1 + (seed >> 20) % 256;
+
+        if (slot.Ptr != nullptr) {
+            if (check) {
+                for (size_t j = 0; j < slot.Size; ++j) {
+                    HEAP_CHECK(slot.Ptr[j] == slot.Fill);
+                }
+            }
+            if (heap != nullptr) {
+                HEAP_CHECK(heap->Free(slot.Ptr) == SMALL_HEAP_FREE_OK);
+            } else {
+                std::free(slot.Ptr);
+            }
+            slot.Ptr = nullptr;
+            continue;
+        }
+
+        slot.Ptr = (unsigned char *)(heap != nullptr ? heap->Allocate(size) : std::calloc(1, size));
+        HEAP_CHECK(slot.Ptr != nullptr);
+        slot.Size = size;
+        slot.Fill = (unsigned char)(seed >> 24);
+        if (check) {
+            std::memset(slot.Ptr, slot.Fill, size);
+        }
+    }
+
+    for (Slot &slot : slots) {
+        if (heap != nullptr) {
+            heap->Free(slot.Ptr);
+        } else {
+            std::free(slot.Ptr);
+        }
+    }
+}
+
+
+static double Run_Churn(SmallHeapClass *heap, int threads, long iterations, bool check)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.push_back(std::thread(Churn, heap, 1234U + i, iterations, check));
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char **argv)
+{
+    long iterations = 2000000;
+    int threads = 4;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i+1 < argc) {
+            iterations = std::strtol(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-t") && i+1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: HeapTest [-n <iterations>] [-t <threads>]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    Test_Allocate(false);
+    Test_Allocate(true);
+    Test_Reuse();
+    Test_Reallocate(false);
+    Test_Reallocate(true);
+    Test_Exhaust();
+    Test_Guards();
+    Test_Any_Contents();
+    Test_Report();
+
+    /**
+     *  Check the heap under contention before timing it.
+     */
+    {
+        TestHeapClass heap(true);
+        Run_Churn(heap.operator->(), threads, iterations / 10, true);
+        HEAP_CHECK(heap->Live_Count() == 0);
+        HEAP_CHECK(heap->Check_All() == 0);
+    }
+
+    std::printf("HeapTest: All tests passed.\n");
+
+    for (int t = 1; t <= threads; t *= 2) {
+        TestHeapClass heap(false, 64 * 1024 * 1024);
+        double small_time = Run_Churn(heap.operator->(), t, iterations, false);
+        double crt_time = Run_Churn(nullptr, t, iterations, false);
+
+        std::printf("HeapTest: %d thread(s), %ld operations each: small heap %.1f ns, C runtime %.1f ns per operation.\n",
+            t, iterations, small_time * 1e9 / iterations, crt_time * 1e9 / iterations);
+    }
+
+    return EXIT_SUCCESS;
+}
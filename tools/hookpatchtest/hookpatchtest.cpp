@@ -0,0 +1,409 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          HOOKPATCHTEST.CPP
+ *
+ *  @brief         Fake memory tests for the patch transaction table.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: HookPatchTest
+ *
+ *  Applies patch transactions to a fake memory image with fake per page
+ *  protection, so the staging table can be tested without a game process.
+ *  Any write to a page that was not made writable shows up as a difference
+ *  from a shadow of the image that is only updated when pages are protected
+ *  again. The tests check that:
+ *
+ *    - Each run of contiguous pages is unprotected once, and the protection
+ *      of every page is restored after the transaction.
+ *    - Overlapping patches are counted and abort the transaction before
+ *      anything is unprotected, while patches that only touch are applied.
+ *    - Writes larger than a table entry are split and applied whole.
+ *    - A page that can not be unprotected aborts the transaction with
+ *      nothing written and the pages changed so far restored.
+ *    - Rolling back an applied transaction restores the exact image, and
+ *      rolling back a staged one writes nothing.
+ *    - The instruction cache flush covers every written byte.
+ *    - Staging more than the table holds fails.
+ *
+ *  Any failed check aborts the tool.
+ */
+#include "hookpatch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+#define HP_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "HookPatchTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+#define PAGE_SIZE       4096
+#define PAGE_COUNT      16
+
+#define PROTECT_READ    1
+#define PROTECT_WRITE   2
+
+
+alignas(PAGE_SIZE) static uint8_t Image[PAGE_SIZE * PAGE_COUNT];
+static uint8_t Shadow[PAGE_SIZE * PAGE_COUNT];
+static uint8_t Baseline[PAGE_SIZE * PAGE_COUNT];
+static unsigned long PageProtect[PAGE_COUNT];
+
+static int UnprotectCalls = 0;
+static int UnprotectFailAt = -1;
+static uintptr_t FlushLow = 0;
+static uintptr_t FlushHigh = 0;
+static int FlushCalls = 0;
+
+static HookPatchTableClass PatchTable;
+
+
+static uintptr_t Address(int offset)
+{
+    return reinterpret_cast<uintptr_t>(Image) + offset;
+}
+
+
+static int Page_Of(uintptr_t address)
+{
+    return int((address - reinterpret_cast<uintptr_t>(Image)) / PAGE_SIZE);
+}
+
+
+static bool Fake_Unprotect(uintptr_t address, size_t size, unsigned long &old_protect)
+{
+    HP_CHECK((address % PAGE_SIZE) == 0 && (size % PAGE_SIZE) == 0);
+
+    if (UnprotectCalls++ == UnprotectFailAt) {
+        return false;
+    }
+
+    old_protect = PageProtect[Page_Of(address)];
+    for (int page = Page_Of(address); page < Page_Of(address + size); ++page) {
+        HP_CHECK(PageProtect[page] == PROTECT_READ);
+        PageProtect[page] = PROTECT_WRITE;
+    }
+    return true;
+}
+
+
+static void Fake_Protect(uintptr_t address, size_t size, unsigned long protect)
+{
+    HP_CHECK((address % PAGE_SIZE) == 0 && (size % PAGE_SIZE) == 0);
+
+    /**
+     *  Writes to these pages were allowed, so take them into the shadow.
+     */
+    for (int page = Page_Of(address); page < Page_Of(address + size); ++page) {
+        HP_CHECK(PageProtect[page] == PROTECT_WRITE);
+        PageProtect[page] = protect;
+        std::memcpy(&Shadow[page * PAGE_SIZE], &Image[page * PAGE_SIZE], PAGE_SIZE);
+    }
+}
+
+
+static void Fake_Flush(uintptr_t address, size_t size)
+{
+    ++FlushCalls;
+    FlushLow = address;
+    FlushHigh = address + size;
+}
+
+
+/**
+ *  Checks every page is protected and nothing was written behind the protection.
+ */
+static void Check_Protection()
+{
+    for (int page = 0; page < PAGE_COUNT; ++page) {
+        HP_CHECK(PageProtect[page] == PROTECT_READ);
+    }
+    HP_CHECK(std::memcmp(Image, Shadow, sizeof(Image)) == 0);
+}
+
+
+/**
+ *  Checks the flush covers every byte that differs from the baseline.
+ */
+static void Check_Flush_Covers_Changes()
+{
+    for (int i = 0; i < int(sizeof(Image)); ++i) {
+        if (Image[i] != Baseline[i]) {
+            HP_CHECK(FlushCalls > 0);
+            HP_CHECK(Address(i) >= FlushLow && Address(i) < FlushHigh);
+        }
+    }
+}
+
+
+static void Reset()
+{
+    for (int i = 0; i < int(sizeof(Image)); ++i) {
+        Image[i] = uint8_t(i * 7 + (i >> 8));
+    }
+    std::memcpy(Shadow, Image, sizeof(Image));
+    std::memcpy(Baseline, Image, sizeof(Image));
+
+    for (int page = 0; page < PAGE_COUNT; ++page) {
+        PageProtect[page] = PROTECT_READ;
+    }
+
+    UnprotectCalls = 0;
+    UnprotectFailAt = -1;
+    FlushLow = 0;
+    FlushHigh = 0;
+    FlushCalls = 0;
+
+    PatchTable.Clear();
+    PatchTable.Set_Memory_Functions(PAGE_SIZE, Fake_Unprotect, Fake_Protect, Fake_Flush);
+}
+
+
+static const uint8_t Jump[5] = { 0xE9, 0x11, 0x22, 0x33, 0x44 };
+static const uint8_t Nops[5] = { 0x90, 0x90, 0x90, 0x90, 0x90 };
+
+
+static void Test_Page_Runs()
+{
+    Reset();
+
+    /**
+     *  Pages 1 and 2 are one run, the patch at the end of page 3 crosses into
+     *  page 4 and joins them, page 9 is a run of its own.
+     */
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*2 + 100), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*1 + 10), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*4 - 2), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*9 + 50), Nops, sizeof(Nops)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*1 + 2000), Nops, sizeof(Nops)));
+
+    HP_CHECK(PatchTable.Apply());
+    HP_CHECK(PatchTable.Is_Applied());
+
+    HP_CHECK(UnprotectCalls == 2);
+    HP_CHECK(PatchTable.Overlap_Count() == 0);
+
+    HP_CHECK(std::memcmp(&Image[PAGE_SIZE*2 + 100], Jump, sizeof(Jump)) == 0);
+    HP_CHECK(std::memcmp(&Image[PAGE_SIZE*1 + 10], Jump, sizeof(Jump)) == 0);
+    HP_CHECK(std::memcmp(&Image[PAGE_SIZE*4 - 2], Jump, sizeof(Jump)) == 0);
+    HP_CHECK(std::memcmp(&Image[PAGE_SIZE*9 + 50], Nops, sizeof(Nops)) == 0);
+    HP_CHECK(std::memcmp(&Image[PAGE_SIZE*1 + 2000], Nops, sizeof(Nops)) == 0);
+
+    Check_Protection();
+    Check_Flush_Covers_Changes();
+
+    std::printf("HookPatchTest: Page runs passed.\n");
+}
+
+
+static void Test_Overlaps()
+{
+    Reset();
+
+    /**
+     *  The jump overlaps the nops and the byte overlaps the jump. The result
+     *  would depend on the staging order, so nothing may be written.
+     */
+    uint8_t int3 = 0xCC;
+
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*1), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*3 + 2), Nops, sizeof(Nops)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*3), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*3 + 1), &int3, sizeof(int3)));
+
+    HP_CHECK(!PatchTable.Apply());
+    HP_CHECK(!PatchTable.Is_Applied());
+    HP_CHECK(PatchTable.Overlap_Count() == 2);
+
+    HP_CHECK(UnprotectCalls == 0);
+    HP_CHECK(FlushCalls == 0);
+    HP_CHECK(std::memcmp(Image, Baseline, sizeof(Image)) == 0);
+
+    Check_Protection();
+
+    /**
+     *  The same patch staged twice is also an overlap.
+     */
+    Reset();
+
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*5), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*5), Jump, sizeof(Jump)));
+    HP_CHECK(!PatchTable.Apply());
+    HP_CHECK(PatchTable.Overlap_Count() == 1);
+    HP_CHECK(std::memcmp(Image, Baseline, sizeof(Image)) == 0);
+
+    /**
+     *  Patches that only touch are not an overlap.
+     */
+    Reset();
+
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*3 + 5), Nops, sizeof(Nops)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*3), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Apply());
+    HP_CHECK(PatchTable.Overlap_Count() == 0);
+
+    const uint8_t expected[10] = { 0xE9, 0x11, 0x22, 0x33, 0x44, 0x90, 0x90, 0x90, 0x90, 0x90 };
+    HP_CHECK(std::memcmp(&Image[PAGE_SIZE*3], expected, sizeof(expected)) == 0);
+
+    Check_Protection();
+
+    HP_CHECK(PatchTable.Rollback());
+    HP_CHECK(std::memcmp(Image, Baseline, sizeof(Image)) == 0);
+
+    Check_Protection();
+
+    std::printf("HookPatchTest: Overlaps passed.\n");
+}
+
+
+static void Test_Large_Write()
+{
+    Reset();
+
+    uint8_t data[HOOK_PATCH_CHUNK_SIZE * 3 + 5];
+    for (int i = 0; i < int(sizeof(data)); ++i) {
+        data[i] = uint8_t(0xA0 + i);
+    }
+
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*6 - 20), data, sizeof(data)));
+    HP_CHECK(PatchTable.Count() == 4);
+    HP_CHECK(PatchTable.Apply());
+
+    HP_CHECK(std::memcmp(&Image[PAGE_SIZE*6 - 20], data, sizeof(data)) == 0);
+    HP_CHECK(UnprotectCalls == 1);
+
+    Check_Protection();
+    Check_Flush_Covers_Changes();
+
+    std::printf("HookPatchTest: Large write passed.\n");
+}
+
+
+static void Test_Unprotect_Failure()
+{
+    Reset();
+
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*1), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*4), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*8), Jump, sizeof(Jump)));
+
+    /**
+     *  The third run fails, the first two must be protected again.
+     */
+    UnprotectFailAt = 2;
+
+    HP_CHECK(!PatchTable.Apply());
+    HP_CHECK(!PatchTable.Is_Applied());
+
+    HP_CHECK(UnprotectCalls == 3);
+    HP_CHECK(FlushCalls == 0);
+    HP_CHECK(std::memcmp(Image, Baseline, sizeof(Image)) == 0);
+
+    Check_Protection();
+
+    std::printf("HookPatchTest: Unprotect failure passed.\n");
+}
+
+
+static void Test_Rollback()
+{
+    Reset();
+
+    /**
+     *  A staged transaction is discarded without touching memory.
+     */
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*2), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Rollback());
+    HP_CHECK(PatchTable.Count() == 0);
+    HP_CHECK(UnprotectCalls == 0);
+    HP_CHECK(std::memcmp(Image, Baseline, sizeof(Image)) == 0);
+
+    /**
+     *  An applied transaction is restored exactly.
+     */
+    for (int i = 0; i < 200; ++i) {
+        int offset = (i * 977) % (PAGE_SIZE * PAGE_COUNT - 8);
+        HP_CHECK(PatchTable.Stage(Address(offset), (i & 1) ? Jump : Nops, 5));
+    }
+
+    HP_CHECK(PatchTable.Apply());
+    HP_CHECK(std::memcmp(Image, Baseline, sizeof(Image)) != 0);
+    Check_Protection();
+    Check_Flush_Covers_Changes();
+
+    FlushCalls = 0;
+
+    HP_CHECK(PatchTable.Rollback());
+    HP_CHECK(!PatchTable.Is_Applied());
+    HP_CHECK(FlushCalls == 1);
+    HP_CHECK(std::memcmp(Image, Baseline, sizeof(Image)) == 0);
+
+    Check_Protection();
+
+    /**
+     *  The table can not take new patches until it is cleared.
+     */
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*2), Jump, sizeof(Jump)));
+    HP_CHECK(PatchTable.Apply());
+    HP_CHECK(!PatchTable.Stage(Address(PAGE_SIZE*3), Jump, sizeof(Jump)));
+    PatchTable.Clear();
+    HP_CHECK(PatchTable.Stage(Address(PAGE_SIZE*3), Jump, sizeof(Jump)));
+
+    std::printf("HookPatchTest: Rollback passed.\n");
+}
+
+
+static void Test_Table_Full()
+{
+    Reset();
+
+    for (int i = 0; i < HOOK_PATCH_TABLE_SIZE; ++i) {
+        HP_CHECK(PatchTable.Stage(Address(i % (PAGE_SIZE * PAGE_COUNT - 8)), Nops, 1));
+    }
+
+    HP_CHECK(PatchTable.Count() == HOOK_PATCH_TABLE_SIZE);
+    HP_CHECK(!PatchTable.Stage(Address(0), Nops, 1));
+
+    std::printf("HookPatchTest: Table full passed.\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    Test_Page_Runs();
+    Test_Overlaps();
+    Test_Large_Write();
+    Test_Unprotect_Failure();
+    Test_Rollback();
+    Test_Table_Full();
+
+    std::printf("HookPatchTest: All tests passed.\n");
+
+    return EXIT_SUCCESS;
+}
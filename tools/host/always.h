@@ -0,0 +1,47 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          ALWAYS.H
+ *
+ *  @brief         Host stand-in for always.h, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+/**
+ *  The host tools build some of the DLL sources outside of Windows. This
+ *  directory is only on the include path of those tools, and provides the
+ *  few parts of the Windows and TS++ headers those sources need.
+ */
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#define strcmpi _stricmp
+#else
+#include <strings.h>
+#define __cdecl
+#define strcmpi strcasecmp
+
+inline uint32_t _byteswap_ulong(uint32_t value) { return __builtin_bswap32(value); }
+inline uint32_t _rotl(uint32_t value, int shift) { return (value << (shift & 31)) | (value >> ((32 - shift) & 31)); }
+#endif
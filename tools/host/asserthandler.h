@@ -0,0 +1,36 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          ASSERTHANDLER.H
+ *
+ *  @brief         Host stand-in for asserthandler.h, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+#include <cassert>
+
+
+#define ASSERT(exp) assert(exp)
+#define ASSERT_PRINT(exp, msg, ...) assert(exp)
+#define ASSERT_FATAL(exp) assert(exp)
+#define ASSERT_FATAL_PRINT(exp, msg, ...) assert(exp)
+#define ASSERT_STACKDUMP_PRINT(exp, msg, ...) assert(exp)
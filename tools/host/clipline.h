@@ -0,0 +1,81 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          CLIPLINE.H
+ *
+ *  @brief         Host stand-in for clipline.h, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "point.h"
+#include "rect.h"
+
+
+/**
+ *  Clips the line to the rectangle (Cohen-Sutherland). Returns false if no
+ *  part of the line is inside the rectangle.
+ */
+inline bool Clip_Line(Point2D *start, Point2D *end, const Rect *rect)
+{
+    const int left = rect->X;
+    const int top = rect->Y;
+    const int right = rect->X + rect->Width - 1;
+    const int bottom = rect->Y + rect->Height - 1;
+
+    auto outcode = [&](const Point2D &p) {
+        return (p.X < left ? 1 : 0) | (p.X > right ? 2 : 0) | (p.Y < top ? 4 : 0) | (p.Y > bottom ? 8 : 0);
+    };
+
+    int code1 = outcode(*start);
+    int code2 = outcode(*end);
+
+    for (;;) {
+        if (!(code1 | code2)) {
+            return true;
+        }
+        if (code1 & code2) {
+            return false;
+        }
+
+        int code = code1 ? code1 : code2;
+        long long dx = end->X - start->X;
+        long long dy = end->Y - start->Y;
+        Point2D p;
+
+        if (code & 8) {
+            p = Point2D(int(start->X + dx * (bottom - start->Y) / dy), bottom);
+        } else if (code & 4) {
+            p = Point2D(int(start->X + dx * (top - start->Y) / dy), top);
+        } else if (code & 2) {
+            p = Point2D(right, int(start->Y + dy * (right - start->X) / dx));
+        } else {
+            p = Point2D(left, int(start->Y + dy * (left - start->X) / dx));
+        }
+
+        if (code == code1) {
+            *start = p;
+            code1 = outcode(*start);
+        } else {
+            *end = p;
+            code2 = outcode(*end);
+        }
+    }
+}
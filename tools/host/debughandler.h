@@ -0,0 +1,47 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          DEBUGHANDLER.H
+ *
+ *  @brief         Host stand-in for debughandler.h, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <cstdio>
+
+
+/**
+ *  The host tools only report their own results, so the debug output of the
+ *  DLL sources is printed as is, or dropped for the developer only output.
+ */
+#define DEBUG_SAY(x, ...) std::printf(x, ##__VA_ARGS__)
+#define DEBUG_INFO(x, ...) std::printf(x, ##__VA_ARGS__)
+#define DEBUG_WARNING(x, ...) std::fprintf(stderr, x, ##__VA_ARGS__)
+#define DEBUG_ERROR(x, ...) std::fprintf(stderr, x, ##__VA_ARGS__)
+#define DEBUG_FATAL(x, ...) std::fprintf(stderr, x, ##__VA_ARGS__)
+#define DEBUG_TRACE(x, ...) ((void)0)
+
+#define DEV_DEBUG_SAY(x, ...) ((void)0)
+#define DEV_DEBUG_INFO(x, ...) ((void)0)
+#define DEV_DEBUG_WARNING(x, ...) ((void)0)
+#define DEV_DEBUG_ERROR(x, ...) ((void)0)
+#define DEV_DEBUG_FATAL(x, ...) ((void)0)
+#define DEV_DEBUG_TRACE(x, ...) ((void)0)
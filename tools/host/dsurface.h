@@ -0,0 +1,150 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          DSURFACE.H
+ *
+ *  @brief         Host stand-in for dsurface.h, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "point.h"
+#include "rect.h"
+#include <algorithm>
+#include <vector>
+
+
+/**
+ *  A surface held in memory, with simple versions of the drawing primitives
+ *  used by the DLL sources built for the host. The host tools compare what
+ *  two ways of drawing the same thing leave on the surface, so the exact
+ *  rasterisation only has to be consistent, not match the game.
+ *
+ *  Each primitive counts the calls made while the surface is not locked.
+ */
+class XSurface
+{
+    public:
+        XSurface(int width, int height) : Width(width), Height(height), Pixels(width * height, 0), LockCount(0), UnlockedDraws(0) {}
+
+        void *Lock() { ++LockCount; return Pixels.data(); }
+        bool Unlock() { if (LockCount > 0) { --LockCount; } return true; }
+        bool Is_Locked() const { return LockCount > 0; }
+
+        void Clear() { std::fill(Pixels.begin(), Pixels.end(), 0); }
+
+        void Put_Pixel(int x, int y, unsigned color)
+        {
+            if (x >= 0 && y >= 0 && x < Width && y < Height) {
+                Pixels[y * Width + x] = color;
+            }
+        }
+
+        bool Draw_Line(Point2D &start, Point2D &end, unsigned color)
+        {
+            Count_Draw();
+            Rasterise(start, end, color, nullptr, 0);
+            return true;
+        }
+
+        bool Draw_Dashed_Line(Point2D &start, Point2D &end, unsigned color, bool *pattern, int offset)
+        {
+            Count_Draw();
+            Rasterise(start, end, color, pattern, offset);
+            return true;
+        }
+
+        /**
+         *  The game's patterned line and plain line entries used by the
+         *  waypoint and rally point lines.
+         */
+        bool entry_48(Point2D &start, Point2D &end, unsigned color, bool *pattern, int offset, bool blit)
+        {
+            Count_Draw();
+            Rasterise(start, end, blit ? (color | 0x80000000) : color, pattern, offset);
+            return true;
+        }
+
+        bool entry_4C(Point2D &start, Point2D &end, unsigned color)
+        {
+            Count_Draw();
+            Rasterise(start, end, color, nullptr, 0);
+            return true;
+        }
+
+        bool Fill_Rect(Rect &rect, unsigned color)
+        {
+            Count_Draw();
+            for (int y = rect.Y; y < rect.Y + rect.Height; ++y) {
+                for (int x = rect.X; x < rect.X + rect.Width; ++x) {
+                    Put_Pixel(x, y, color);
+                }
+            }
+            return true;
+        }
+
+    private:
+        void Count_Draw() { if (LockCount == 0) { ++UnlockedDraws; } }
+
+        void Rasterise(const Point2D &start, const Point2D &end, unsigned color, const bool *pattern, int offset)
+        {
+            int x = start.X;
+            int y = start.Y;
+            int dx = end.X > x ? end.X - x : x - end.X;
+            int dy = end.Y > y ? y - end.Y : end.Y - y;
+            int sx = x < end.X ? 1 : -1;
+            int sy = y < end.Y ? 1 : -1;
+            int error = dx + dy;
+
+            for (int step = 0; ; ++step) {
+                if (!pattern || pattern[(offset + step) & 15]) {
+                    Put_Pixel(x, y, color);
+                }
+                if (x == end.X && y == end.Y) {
+                    break;
+                }
+                int e2 = 2 * error;
+                if (e2 >= dy) {
+                    error += dy;
+                    x += sx;
+                }
+                if (e2 <= dx) {
+                    error += dx;
+                    y += sy;
+                }
+            }
+        }
+
+    public:
+        int Width;
+        int Height;
+        std::vector<unsigned> Pixels;
+        int LockCount;
+        int UnlockedDraws;
+};
+
+
+class DSurface : public XSurface
+{
+    public:
+        DSurface(int width, int height) : XSurface(width, height) {}
+
+        static unsigned RGB_To_Pixel(int r, int g, int b) { return (unsigned(r) << 16) | (unsigned(g) << 8) | unsigned(b); }
+};
@@ -0,0 +1,49 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          PIPE.H
+ *
+ *  @brief         Host stand-in for the TS++ Pipe class, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+
+
+/**
+ *  The chaining behaviour of the TS++ Pipe class.
+ */
+class Pipe
+{
+    public:
+        Pipe() : ChainTo(nullptr), ChainFrom(nullptr) {}
+        virtual ~Pipe() {}
+
+        virtual int Flush() { return ChainTo != nullptr ? ChainTo->Flush() : 0; }
+        virtual int End() { return Flush(); }
+        virtual void Put_To(Pipe *pipe) { ChainTo = pipe; if (pipe != nullptr) pipe->ChainFrom = this; }
+        void Put_To(Pipe &pipe) { Put_To(&pipe); }
+        virtual int Put(const void *source, int slen) { return ChainTo != nullptr ? ChainTo->Put(source, slen) : slen; }
+
+    protected:
+        Pipe *ChainTo;
+        Pipe *ChainFrom;
+};
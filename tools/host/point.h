@@ -0,0 +1,48 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          POINT.H
+ *
+ *  @brief         Host stand-in for point.h, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+
+/**
+ *  Only the parts of Point2D used by the DLL sources built for the host.
+ */
+class Point2D
+{
+    public:
+        Point2D() : X(0), Y(0) {}
+        Point2D(int x, int y) : X(x), Y(y) {}
+
+        bool operator==(const Point2D &that) const { return X == that.X && Y == that.Y; }
+        bool operator!=(const Point2D &that) const { return !(*this == that); }
+
+        Point2D operator+(const Point2D &that) const { return Point2D(X + that.X, Y + that.Y); }
+        Point2D &operator+=(const Point2D &that) { X += that.X; Y += that.Y; return *this; }
+        Point2D operator-(const Point2D &that) const { return Point2D(X - that.X, Y - that.Y); }
+
+    public:
+        int X;
+        int Y;
+};
@@ -0,0 +1,65 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          RECT.H
+ *
+ *  @brief         Host stand-in for rect.h, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "point.h"
+
+
+/**
+ *  Only the parts of Rect used by the DLL sources built for the host.
+ */
+class Rect
+{
+    public:
+        Rect() : X(0), Y(0), Width(0), Height(0) {}
+        Rect(int x, int y, int w, int h) : X(x), Y(y), Width(w), Height(h) {}
+        Rect(const Point2D &point, int w, int h) : X(point.X), Y(point.Y), Width(w), Height(h) {}
+
+        bool Is_Valid() const { return Width > 0 && Height > 0; }
+
+        bool Is_Within(const Point2D &point) const
+        {
+            return point.X >= X && point.X < (X + Width) && point.Y >= Y && point.Y < (Y + Height);
+        }
+
+        Rect Intersect_With(const Rect &that) const
+        {
+            int x1 = X > that.X ? X : that.X;
+            int y1 = Y > that.Y ? Y : that.Y;
+            int x2 = (X + Width) < (that.X + that.Width) ? (X + Width) : (that.X + that.Width);
+            int y2 = (Y + Height) < (that.Y + that.Height) ? (Y + Height) : (that.Y + that.Height);
+            if (x2 <= x1 || y2 <= y1) {
+                return Rect();
+            }
+            return Rect(x1, y1, x2 - x1, y2 - y1);
+        }
+
+    public:
+        int X;
+        int Y;
+        int Width;
+        int Height;
+};
@@ -0,0 +1,47 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          STRAW.H
+ *
+ *  @brief         Host stand-in for the TS++ Straw class, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+
+
+/**
+ *  The chaining behaviour of the TS++ Straw class.
+ */
+class Straw
+{
+    public:
+        Straw() : ChainTo(nullptr), ChainFrom(nullptr) {}
+        virtual ~Straw() {}
+
+        virtual void Get_From(Straw *straw) { ChainTo = straw; if (straw != nullptr) straw->ChainFrom = this; }
+        void Get_From(Straw &straw) { Get_From(&straw); }
+        virtual int Get(void *source, int slen) { return ChainTo != nullptr ? ChainTo->Get(source, slen) : 0; }
+
+    protected:
+        Straw *ChainTo;
+        Straw *ChainFrom;
+};
@@ -0,0 +1,115 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          VECTOR.H
+ *
+ *  @brief         Host stand-in for vector.h, used by the host tools.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "always.h"
+#include <cassert>
+
+
+/**
+ *  A minimal DynamicVectorClass for the host tools. It keeps the behaviour
+ *  the DLL sources depend on: Add appends, Delete keeps the order of the
+ *  remaining elements and ID returns -1 when the element is not present.
+ */
+template<class T>
+class DynamicVectorClass
+{
+    public:
+        DynamicVectorClass() : Vector(nullptr), VectorMax(0), ActiveCount(0), GrowthStep(10) {}
+        virtual ~DynamicVectorClass() { delete [] Vector; }
+
+        T &operator[](int index) { assert(index >= 0 && index < ActiveCount); return Vector[index]; }
+        const T &operator[](int index) const { assert(index >= 0 && index < ActiveCount); return Vector[index]; }
+
+        int Count() const { return ActiveCount; }
+        int Length() const { return VectorMax; }
+
+        void Set_Growth_Step(int step) { GrowthStep = step > 0 ? step : 1; }
+
+        bool Add(const T &object)
+        {
+            if (ActiveCount >= VectorMax) {
+                Resize(VectorMax + GrowthStep);
+            }
+            Vector[ActiveCount++] = object;
+            return true;
+        }
+
+        bool Delete(int index)
+        {
+            if (index < 0 || index >= ActiveCount) {
+                return false;
+            }
+            --ActiveCount;
+            for (int i = index; i < ActiveCount; ++i) {
+                Vector[i] = Vector[i+1];
+            }
+            return true;
+        }
+
+        bool Delete(const T &object) { return Delete(ID(object)); }
+
+        int ID(const T &object) const
+        {
+            for (int i = 0; i < ActiveCount; ++i) {
+                if (Vector[i] == object) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        bool Is_Present(const T &object) const { return ID(object) != -1; }
+
+        void Clear()
+        {
+            delete [] Vector;
+            Vector = nullptr;
+            VectorMax = 0;
+            ActiveCount = 0;
+        }
+
+    private:
+        DynamicVectorClass(const DynamicVectorClass &) = delete;
+        DynamicVectorClass &operator=(const DynamicVectorClass &) = delete;
+
+        void Resize(int size)
+        {
+            T *vector = new T[size];
+            for (int i = 0; i < ActiveCount; ++i) {
+                vector[i] = Vector[i];
+            }
+            delete [] Vector;
+            Vector = vector;
+            VectorMax = size;
+        }
+
+    private:
+        T *Vector;
+        int VectorMax;
+        int ActiveCount;
+        int GrowthStep;
+};
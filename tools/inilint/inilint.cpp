@@ -0,0 +1,336 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          INILINT.CPP
+ *
+ *  @brief         Reports unknown keys and unreferenced sections in INI files.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: IniLint -b <binary> [-b <binary> ...] <ini file or directory> [...]
+ *
+ *  A heuristic check for keys in the INI files that are probably never read,
+ *  usually a sign of a misspelled key, and sections that are probably not
+ *  referenced. It runs offline on the files and binaries and does not see
+ *  the lookups the game makes, so its results are hints to be checked by
+ *  hand, not a list of errors.
+ *
+ *  The game and Vinifera look up keys by name, so the names every module
+ *  could read are guessed from the strings embedded in the binaries (pass
+ *  both GAME.EXE and Vinifera.dll). Strings containing %d or %s, such as
+ *  "Weapon%d", are used as patterns. A section is treated as referenced if
+ *  its name appears in a value in any of the INI files, or in a binary.
+ *
+ *  The guess is wrong in both directions:
+ *
+ *    - A key is accepted in every section if any module reads it anywhere,
+ *      and any string in a binary that happens to match a key name counts,
+ *      so misspellings that match another key are missed.
+ *    - Keys or sections whose names are built at runtime in any other way
+ *      than a %d or %s pattern are reported even though they are read.
+ *    - Keys that are read but missing from the files can not be reported
+ *      at all. That needs every INIClass entry lookup to be traced in the
+ *      running game, which no part of Vinifera does.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+
+struct IniKeyStruct
+{
+    std::string Section;
+    std::string Key;
+    std::string File;
+    int Line;
+};
+
+
+struct IniSectionStruct
+{
+    std::string Name;
+    std::string File;
+    int Line;
+};
+
+
+static std::set<std::string> KnownStrings;
+static std::vector<std::string> KnownPatterns;
+
+
+static std::string To_Upper(std::string str)
+{
+    for (size_t i = 0; i < str.size(); ++i) {
+        str[i] = (char)std::toupper((unsigned char)str[i]);
+    }
+    return str;
+}
+
+
+static std::string Trim(const std::string &str)
+{
+    size_t start = str.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return std::string();
+    }
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(start, end - start + 1);
+}
+
+
+/**
+ *  Collects the printable strings from a binary.
+ */
+static bool Load_Binary_Strings(const char *filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "Failed to open binary \"%s\"!\n", filename);
+        return false;
+    }
+
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::string current;
+    for (size_t i = 0; i <= data.size(); ++i) {
+        unsigned char c = (i < data.size()) ? (unsigned char)data[i] : 0;
+        if (c >= 0x20 && c < 0x7F) {
+            current += (char)c;
+            continue;
+        }
+        if (current.size() >= 2) {
+            std::string upper = To_Upper(current);
+            if (upper.find("%D") != std::string::npos || upper.find("%S") != std::string::npos) {
+                KnownPatterns.push_back(upper);
+            } else {
+                KnownStrings.insert(upper);
+            }
+        }
+        current.clear();
+    }
+
+    return true;
+}
+
+
+/**
+ *  Matches the name against a printf style pattern, where %d matches one or
+ *  more digits and %s matches any text.
+ */
+static bool Match_Pattern(const char *pattern, const char *name)
+{
+    while (*pattern) {
+        if (pattern[0] == '%' && pattern[1] == 'D') {
+            if (!std::isdigit((unsigned char)*name)) {
+                return false;
+            }
+            while (std::isdigit((unsigned char)*name)) {
+                ++name;
+            }
+            pattern += 2;
+            continue;
+        }
+        if (pattern[0] == '%' && pattern[1] == 'S') {
+            for (const char *rest = name; ; ++rest) {
+                if (Match_Pattern(pattern + 2, rest)) {
+                    return true;
+                }
+                if (!*rest) {
+                    return false;
+                }
+            }
+        }
+        if (*pattern != *name) {
+            return false;
+        }
+        ++pattern;
+        ++name;
+    }
+    return *name == '\0';
+}
+
+
+static bool Is_Known(const std::string &upper)
+{
+    if (KnownStrings.count(upper)) {
+        return true;
+    }
+    for (const std::string &pattern : KnownPatterns) {
+        if (Match_Pattern(pattern.c_str(), upper.c_str())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ *  Reads the sections, keys and value tokens of an INI file.
+ */
+static void Read_Ini_File(const std::filesystem::path &path, std::vector<IniSectionStruct> &sections,
+    std::vector<IniKeyStruct> &keys, std::set<std::string> &values)
+{
+    std::ifstream in(path);
+    std::string file = path.filename().string();
+    std::string section;
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(in, line)) {
+        ++line_number;
+
+        size_t comment = line.find(';');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        line = Trim(line);
+        if (line.empty()) {
+            continue;
+        }
+
+        if (line[0] == '[') {
+            size_t end = line.find(']');
+            section = Trim(line.substr(1, end == std::string::npos ? std::string::npos : end - 1));
+            sections.push_back(IniSectionStruct { section, file, line_number });
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos || section.empty()) {
+            continue;
+        }
+
+        std::string key = Trim(line.substr(0, equals));
+        std::string value = line.substr(equals + 1);
+
+        keys.push_back(IniKeyStruct { section, key, file, line_number });
+
+        size_t start = 0;
+        while (start <= value.size()) {
+            size_t comma = value.find(',', start);
+            if (comma == std::string::npos) {
+                comma = value.size();
+            }
+            std::string token = Trim(value.substr(start, comma - start));
+            if (!token.empty()) {
+                values.insert(To_Upper(token));
+            }
+            start = comma + 1;
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    std::vector<std::filesystem::path> files;
+    bool have_binary = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            if (!Load_Binary_Strings(argv[++i])) {
+                return EXIT_FAILURE;
+            }
+            have_binary = true;
+            continue;
+        }
+
+        std::filesystem::path path(argv[i]);
+        if (std::filesystem::is_directory(path)) {
+            for (const auto &item : std::filesystem::directory_iterator(path)) {
+                if (item.is_regular_file() && To_Upper(item.path().extension().string()) == ".INI") {
+                    files.push_back(item.path());
+                }
+            }
+        } else {
+            files.push_back(path);
+        }
+    }
+
+    if (!have_binary || files.empty()) {
+        std::fprintf(stderr, "Usage: %s -b <binary> [-b <binary> ...] <ini file or directory> [...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::sort(files.begin(), files.end());
+
+    std::vector<IniSectionStruct> sections;
+    std::vector<IniKeyStruct> keys;
+    std::set<std::string> values;
+
+    for (const std::filesystem::path &path : files) {
+        Read_Ini_File(path, sections, keys, values);
+    }
+
+    /**
+     *  Keys that do not match any name a module could ask for.
+     */
+    int unknown_keys = 0;
+    std::set<std::string> reported;
+    for (const IniKeyStruct &key : keys) {
+        std::string upper = To_Upper(key.Key);
+
+        /**
+         *  Entries of type lists are numbered, not named.
+         */
+        if (!upper.empty() && std::all_of(upper.begin(), upper.end(), [](char c) { return std::isdigit((unsigned char)c); })) {
+            continue;
+        }
+
+        if (Is_Known(upper)) {
+            continue;
+        }
+
+        if (!reported.insert(To_Upper(key.Section) + "/" + upper).second) {
+            continue;
+        }
+
+        std::printf("%s:%d: Key \"%s\" in section [%s] is possibly never read.\n", key.File.c_str(), key.Line, key.Key.c_str(), key.Section.c_str());
+        ++unknown_keys;
+    }
+
+    /**
+     *  Sections whose name is not found in any value or binary.
+     */
+    int unreferenced_sections = 0;
+    for (const IniSectionStruct &section : sections) {
+        std::string upper = To_Upper(section.Name);
+        if (values.count(upper) || Is_Known(upper)) {
+            continue;
+        }
+        std::printf("%s:%d: Section [%s] is possibly not referenced.\n", section.File.c_str(), section.Line, section.Name.c_str());
+        ++unreferenced_sections;
+    }
+
+    std::printf("%u files, %u sections, %u keys; %d possibly unread keys, %d possibly unreferenced sections.\n",
+        (unsigned)files.size(), (unsigned)sections.size(), (unsigned)keys.size(), unknown_keys, unreferenced_sections);
+
+    return EXIT_SUCCESS;
+}
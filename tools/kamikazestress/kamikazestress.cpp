@@ -0,0 +1,358 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          KAMIKAZESTRESS.CPP
+ *
+ *  @brief         Stress test and benchmark for the kamikaze tracker index.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: KamikazeStress [-n <rounds>] [-m <missiles>]
+ *
+ *  Drives KamikazeIndexClass the way KamikazeTrackerClass does: Add appends a
+ *  control and indexes it, Detach moves the last control into the freed slot
+ *  and updates both entries. Each round spawns the missiles (2000 by default),
+ *  kills them in a random order while new ones keep spawning, and frees and
+ *  reallocates the aircraft, so addresses get reused as they do in game.
+ *  After every operation the index must agree with the controls. Every few
+ *  rounds the index is thrown away and rebuilt, as after a load.
+ *
+ *  Also times the same spawn and kill sequence against a search of the
+ *  controls, which is what Detach did before the index. Any failed check
+ *  aborts the tool.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "kamikazeindex.h"
+#include "vector.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+#define KAMIKAZE_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "KamikazeStress: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+/**
+ *  Stands in for an AircraftClass, about the same size.
+ */
+class AircraftClass
+{
+    public:
+        bool IsKamikaze;
+        char Padding[0x700];
+};
+
+
+struct KamikazeControl
+{
+    AircraftClass *Aircraft;
+    int Cell;
+
+    bool operator==(const KamikazeControl &that) const { return Aircraft == that.Aircraft && Cell == that.Cell; }
+};
+
+
+static unsigned Random_Seed = 1;
+
+static unsigned Random()
+{
+    Random_Seed ^= Random_Seed << 13;
+    Random_Seed ^= Random_Seed >> 17;
+    Random_Seed ^= Random_Seed << 5;
+    return Random_Seed;
+}
+
+
+/**
+ *  The parts of KamikazeTrackerClass that touch the index.
+ */
+class Tracker
+{
+    public:
+        Tracker(bool use_index) : UseIndex(use_index) { Controls.Set_Growth_Step(256); }
+
+        int Index_Of(AircraftClass const *aircraft) const
+        {
+            if (!aircraft || !aircraft->IsKamikaze) {
+                return -1;
+            }
+
+            if (UseIndex) {
+                return Index.Find(aircraft);
+            }
+
+            for (int i = 0; i < Controls.Count(); ++i) {
+                if (Controls[i].Aircraft == aircraft) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        void Add(AircraftClass *aircraft, int cell)
+        {
+            aircraft->IsKamikaze = true;
+
+            int index = Index_Of(aircraft);
+            if (index != -1) {
+                Controls[index].Cell = cell;
+                return;
+            }
+
+            KamikazeControl control;
+            control.Aircraft = aircraft;
+            control.Cell = cell;
+            Controls.Add(control);
+
+            if (UseIndex) {
+                Index.Set(aircraft, Controls.Count() - 1);
+            }
+        }
+
+        void Detach(AircraftClass const *aircraft)
+        {
+            int index = Index_Of(aircraft);
+            if (index == -1) {
+                return;
+            }
+
+            int last = Controls.Count() - 1;
+            if (index != last) {
+                Controls[index] = Controls[last];
+                if (UseIndex) {
+                    Index.Set(Controls[index].Aircraft, index);
+                }
+            }
+
+            Controls.Delete(last);
+
+            if (UseIndex) {
+                Index.Remove(aircraft);
+            }
+        }
+
+        void Rebuild()
+        {
+            Index.Clear();
+            for (int i = 0; i < Controls.Count(); ++i) {
+                Index.Set(Controls[i].Aircraft, i);
+            }
+        }
+
+        void Verify() const
+        {
+            KAMIKAZE_CHECK(Index.Count() == Controls.Count());
+            for (int i = 0; i < Controls.Count(); ++i) {
+                KAMIKAZE_CHECK(Index.Find(Controls[i].Aircraft) == i);
+            }
+        }
+
+    public:
+        bool UseIndex;
+        DynamicVectorClass<KamikazeControl> Controls;
+        KamikazeIndexClass Index;
+};
+
+
+/**
+ *  Spawns the missiles, then kills them in a random order while new ones
+ *  spawn in, as a carrier or launcher group does.
+ */
+static void Round(Tracker &tracker, std::vector<AircraftClass *> &aircraft, bool verify)
+{
+    const int count = int(aircraft.size());
+
+    for (int i = 0; i < count; ++i) {
+        tracker.Add(aircraft[i], int(Random()));
+        if (verify) {
+            tracker.Verify();
+        }
+    }
+
+    /**
+     *  Retarget some of them, this must not add a second control.
+     */
+    for (int i = 0; i < count / 4; ++i) {
+        tracker.Add(aircraft[Random() % count], int(Random()));
+    }
+    KAMIKAZE_CHECK(tracker.Controls.Count() == count);
+
+    std::vector<int> order(count);
+    for (int i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    for (int i = count - 1; i > 0; --i) {
+        std::swap(order[i], order[Random() % (i + 1)]);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        AircraftClass *dead = aircraft[order[i]];
+        tracker.Detach(dead);
+
+        if (verify) {
+            KAMIKAZE_CHECK(tracker.Index.Find(dead) == -1);
+            KAMIKAZE_CHECK(tracker.Controls.Count() == count - 1);
+        }
+
+        /**
+         *  The missile is deleted and a new one takes its place, often at
+         *  the same address.
+         */
+        delete dead;
+        AircraftClass *spawn = new AircraftClass();
+        spawn->IsKamikaze = false;
+        aircraft[order[i]] = spawn;
+        tracker.Add(spawn, int(Random()));
+
+        if (verify) {
+            tracker.Verify();
+        }
+
+        /**
+         *  Detaching an aircraft that is not tracked does nothing.
+         */
+        if (verify && (i & 63) == 0) {
+            AircraftClass other;
+            other.IsKamikaze = true;
+            tracker.Detach(&other);
+            KAMIKAZE_CHECK(tracker.Controls.Count() == count);
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        tracker.Detach(aircraft[i]);
+    }
+    KAMIKAZE_CHECK(tracker.Controls.Count() == 0);
+    if (tracker.UseIndex) {
+        KAMIKAZE_CHECK(tracker.Index.Count() == 0);
+    }
+}
+
+
+static void Allocate(std::vector<AircraftClass *> &aircraft, int count)
+{
+    aircraft.resize(count);
+    for (auto &a : aircraft) {
+        a = new AircraftClass();
+        a->IsKamikaze = false;
+    }
+}
+
+
+static void Release(std::vector<AircraftClass *> &aircraft)
+{
+    for (auto a : aircraft) {
+        delete a;
+    }
+    aircraft.clear();
+}
+
+
+static void Test_Stress(int rounds, int missiles)
+{
+    Tracker tracker(true);
+    std::vector<AircraftClass *> aircraft;
+    Allocate(aircraft, missiles);
+
+    for (int round = 0; round < rounds; ++round) {
+        Round(tracker, aircraft, true);
+
+        /**
+         *  Half way through a round, throw the index away and rebuild it,
+         *  as the tracker does after a load.
+         */
+        for (int i = 0; i < missiles; ++i) {
+            tracker.Add(aircraft[i], i);
+        }
+        tracker.Rebuild();
+        tracker.Verify();
+        for (int i = missiles - 1; i >= 0; --i) {
+            tracker.Detach(aircraft[i]);
+        }
+        tracker.Verify();
+        KAMIKAZE_CHECK(tracker.Controls.Count() == 0);
+    }
+
+    Release(aircraft);
+}
+
+
+static double Time_Rounds(bool use_index, int rounds, int missiles)
+{
+    Tracker tracker(use_index);
+    std::vector<AircraftClass *> aircraft;
+    Allocate(aircraft, missiles);
+
+    Random_Seed = 1;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        Round(tracker, aircraft, false);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Release(aircraft);
+    return seconds;
+}
+
+
+int main(int argc, char **argv)
+{
+    int rounds = 20;
+    int missiles = 2000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i+1 < argc) {
+            rounds = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-m") && i+1 < argc) {
+            missiles = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: KamikazeStress [-n <rounds>] [-m <missiles>]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (rounds <= 0 || missiles <= 0) {
+        std::fprintf(stderr, "KamikazeStress: The rounds and missiles must be positive.\n");
+        return EXIT_FAILURE;
+    }
+
+    Test_Stress(rounds, missiles);
+
+    std::printf("KamikazeStress: All tests passed.\n");
+
+    double search = Time_Rounds(false, rounds, missiles);
+    double index = Time_Rounds(true, rounds, missiles);
+
+    std::printf("KamikazeStress: %d rounds of %d missiles, search %.2f ms, index %.2f ms.\n",
+        rounds, missiles, search * 1000.0, index * 1000.0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,276 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          NETFUZZ.CPP
+ *
+ *  @brief         Fuzz harness for the CnCNet4 packet decoder.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: NetFuzz [-n <iterations>] [-s <seed>] [<file> ...]
+ *
+ *  Feeds random and mutated packets to the CnCNet4 packet decoder and the
+ *  packet reader, and aborts if a read goes outside the packet or a decoded
+ *  packet does not survive being encoded again. Files given on the command
+ *  line are run as inputs before the random iterations.
+ *
+ *  Define NETFUZZ_LIBFUZZER to build the harness for libFuzzer instead.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "cncnet4_packet.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+#define FUZZ_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "NetFuzz: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+/**
+ *  Decodes the packet and checks the result against the input.
+ */
+static void Fuzz_Decode(const uint8_t *data, size_t size)
+{
+    NetServerPacketStruct packet;
+    if (!Net_Decode_Server_Packet(data, int(size), packet)) {
+        return;
+    }
+
+    FUZZ_CHECK(size >= 1);
+    FUZZ_CHECK(packet.Command == data[0]);
+
+    if (packet.Command == CMD_PING || packet.Command == CMD_TESTP2P) {
+        FUZZ_CHECK(size >= 5);
+        FUZZ_CHECK(packet.Payload == nullptr && packet.PayloadLength == 0);
+        return;
+    }
+
+    FUZZ_CHECK(size >= 7);
+    FUZZ_CHECK(packet.Payload == data + 7);
+    FUZZ_CHECK(packet.Payload + packet.PayloadLength == data + size);
+
+    /**
+     *  Encode the packet again, it must decode to the same thing.
+     */
+    std::vector<uint8_t> buffer(NET_BUF_SIZE);
+    NetWriterClass writer(buffer.data(), uint32_t(buffer.size()));
+    writer.Write_Int8(int8_t(packet.Command));
+    writer.Write_Int32(int32_t(packet.Address));
+    writer.Write_Int16(int16_t(packet.Port));
+    writer.Write_Data(packet.Payload, packet.PayloadLength);
+
+    if (size > NET_BUF_SIZE) {
+        FUZZ_CHECK(writer.Is_Error());
+        return;
+    }
+
+    FUZZ_CHECK(!writer.Is_Error());
+    FUZZ_CHECK(writer.Get_Length() == size);
+    FUZZ_CHECK(std::memcmp(writer.Get_Buffer(), data, size) == 0);
+
+    NetServerPacketStruct again;
+    FUZZ_CHECK(Net_Decode_Server_Packet(writer.Get_Buffer(), int(writer.Get_Length()), again));
+    FUZZ_CHECK(again.Command == packet.Command);
+    FUZZ_CHECK(again.Address == packet.Address);
+    FUZZ_CHECK(again.Port == packet.Port);
+    FUZZ_CHECK(again.PayloadLength == packet.PayloadLength);
+}
+
+
+/**
+ *  Runs a sequence of reads over the packet, the first byte selects the reads
+ *  and the rest is the packet. Checks the reader never leaves the packet and
+ *  stays failed after a failed read.
+ */
+static void Fuzz_Reader(const uint8_t *data, size_t size)
+{
+    if (size < 1) {
+        return;
+    }
+
+    uint8_t ops = data[0];
+    const uint8_t *packet = data + 1;
+    uint32_t length = uint32_t(size - 1);
+
+    NetReaderClass reader(packet, length);
+
+    for (int i = 0; i < 32; ++i) {
+
+        uint32_t before = reader.Get_Position();
+        bool was_error = reader.Is_Error();
+
+        int op = (ops + i * 7) % 5;
+        switch (op) {
+            case 0:
+            {
+                int8_t value;
+                bool ok = reader.Read_Int8(value);
+                FUZZ_CHECK(ok == (!was_error && length - before >= 1));
+                break;
+            }
+            case 1:
+            {
+                int16_t value;
+                bool ok = reader.Read_Int16(value);
+                FUZZ_CHECK(ok == (!was_error && length - before >= 2));
+                break;
+            }
+            case 2:
+            {
+                int32_t value;
+                bool ok = reader.Read_Int32(value);
+                FUZZ_CHECK(ok == (!was_error && length - before >= 4));
+                break;
+            }
+            case 3:
+            {
+                char str[8];
+                if (reader.Read_String(str, sizeof(str))) {
+                    FUZZ_CHECK(std::memchr(str, '\0', sizeof(str)) != nullptr);
+                    FUZZ_CHECK(packet[reader.Get_Position()-1] == '\0');
+                }
+                break;
+            }
+            case 4:
+            {
+                uint8_t buffer[16];
+                uint32_t read = reader.Read_Data(buffer, ((ops >> 3) + i) % (sizeof(buffer)+1));
+                FUZZ_CHECK(read <= sizeof(buffer));
+                FUZZ_CHECK(read == 0 || std::memcmp(buffer, packet + before, read) == 0);
+                break;
+            }
+        };
+
+        FUZZ_CHECK(reader.Get_Position() >= before);
+        FUZZ_CHECK(reader.Get_Position() <= length);
+        FUZZ_CHECK(reader.Remaining() == length - reader.Get_Position());
+        FUZZ_CHECK(!was_error || reader.Is_Error());
+        FUZZ_CHECK(!was_error || reader.Get_Position() == before);
+    }
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    Fuzz_Decode(data, size);
+    Fuzz_Reader(data, size);
+    return 0;
+}
+
+
+#if !defined(NETFUZZ_LIBFUZZER)
+
+/**
+ *  Builds a random packet, most of them based on a valid packet so the
+ *  deeper paths of the decoder are reached.
+ */
+static std::vector<uint8_t> Random_Packet()
+{
+    static const uint8_t commands[] = { CMD_TUNNEL, CMD_P2P, CMD_PING, CMD_TESTP2P };
+
+    std::vector<uint8_t> packet;
+
+    int kind = std::rand() % 4;
+    if (kind == 0) {
+        packet.resize(std::rand() % 16);
+    } else if (kind == 1) {
+        packet.resize(std::rand() % (NET_BUF_SIZE + 64));
+    } else {
+        packet.resize(7 + std::rand() % 64);
+    }
+
+    for (size_t i = 0; i < packet.size(); ++i) {
+        packet[i] = uint8_t(std::rand());
+    }
+
+    if (kind >= 2 && !packet.empty()) {
+        packet[0] = commands[std::rand() % sizeof(commands)];
+    }
+
+    /**
+     *  Truncate some of the packets to hit the length checks.
+     */
+    if (kind == 3) {
+        packet.resize(std::rand() % (packet.size() + 1));
+    }
+
+    return packet;
+}
+
+
+static bool Run_File(const char *filename)
+{
+    FILE *fp = std::fopen(filename, "rb");
+    if (!fp) {
+        std::fprintf(stderr, "NetFuzz: Failed to open \"%s\"!\n", filename);
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    std::fclose(fp);
+
+    LLVMFuzzerTestOneInput(data.empty() ? nullptr : data.data(), data.size());
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned iterations = 100000;
+    unsigned seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i+1 < argc) {
+            iterations = unsigned(std::strtoul(argv[++i], nullptr, 0));
+        } else if (std::strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            seed = unsigned(std::strtoul(argv[++i], nullptr, 0));
+        } else if (!Run_File(argv[i])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::srand(seed);
+
+    for (unsigned i = 0; i < iterations; ++i) {
+        std::vector<uint8_t> packet = Random_Packet();
+        LLVMFuzzerTestOneInput(packet.empty() ? nullptr : packet.data(), packet.size());
+    }
+
+    std::printf("NetFuzz: %u iterations passed (seed %u).\n", iterations, seed);
+
+    return EXIT_SUCCESS;
+}
+
+#endif
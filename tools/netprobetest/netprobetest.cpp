@@ -0,0 +1,384 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          NETPROBETEST.CPP
+ *
+ *  @brief         Local UDP echo tests for the CnCNet4 peer-to-peer test.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: NetProbeTest
+ *
+ *  Runs the CnCNet4 peer-to-peer test against a local UDP echo server that
+ *  stands in for the CnCNet4 server. The echo server replies to CMD_TESTP2P
+ *  packets with the same token, like the real server. The tests check that:
+ *
+ *    - The resend schedule starts at the interval, doubles for each resend
+ *      and stops at the timeout (on a simulated clock).
+ *    - The test passes on the first packet when the server replies.
+ *    - The test passes after resending when the first packets are lost.
+ *    - The test times out when the server never replies, or only replies
+ *      with the wrong token.
+ *
+ *  Any failed check aborts the tool.
+ *
+ *  This tool is built for the host and only needs the sockets of the host.
+ */
+#include "cncnet4_packet.h"
+#include "cncnet4_probe.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SOCKET;
+#define INVALID_SOCKET  (-1)
+#define closesocket     close
+#endif
+
+
+#define NP_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "NetProbeTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+#define PROBE_INTERVAL  20
+#define PROBE_TIMEOUT   400
+
+
+typedef enum EchoModeType
+{
+    ECHO_REPLY,         // Reply to every test packet.
+    ECHO_DROP_FIRST,    // Drop the first few test packets, then reply.
+    ECHO_SILENT,        // Never reply.
+    ECHO_WRONG_TOKEN,   // Reply with a different token.
+} EchoModeType;
+
+
+static SOCKET Open_Socket(struct sockaddr_in &addr)
+{
+    SOCKET s = ::socket(AF_INET, SOCK_DGRAM, 0);
+    NP_CHECK(s != INVALID_SOCKET);
+
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    NP_CHECK(::bind(s, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+
+    socklen_t len = sizeof(addr);
+    NP_CHECK(::getsockname(s, (struct sockaddr *)&addr, &len) == 0);
+
+    return s;
+}
+
+
+/**
+ *  Waits up to the timeout for a packet, returns its length or zero.
+ */
+static int Receive(SOCKET s, uint8_t *buffer, int size, struct sockaddr_in &from, int timeout_ms)
+{
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    FD_SET(s, &rfds);
+
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = timeout_ms * 1000;
+
+    if (::select(int(s + 1), &rfds, nullptr, nullptr, &tv) <= 0) {
+        return 0;
+    }
+
+    socklen_t len = sizeof(from);
+    int result = ::recvfrom(s, (char *)buffer, size, 0, (struct sockaddr *)&from, &len);
+    return result > 0 ? result : 0;
+}
+
+
+static void Send_Test_Packet(SOCKET s, int32_t token, const struct sockaddr_in &to)
+{
+    uint8_t obuf[16];
+    NetWriterClass writer(obuf, sizeof(obuf));
+
+    writer.Write_Int8(CMD_TESTP2P);
+    writer.Write_Int32(token);
+    NP_CHECK(!writer.Is_Error());
+
+    ::sendto(s, (const char *)writer.Get_Buffer(), writer.Get_Length(), 0, (const struct sockaddr *)&to, sizeof(to));
+}
+
+
+/**
+ *  The stand-in for the CnCNet4 server.
+ */
+class EchoServerClass
+{
+    public:
+        EchoServerClass(EchoModeType mode, int drop_count = 0) :
+            Mode(mode),
+            DropCount(drop_count),
+            Received(0),
+            IsRunning(true)
+        {
+            Socket = Open_Socket(Address);
+            Thread = std::thread(&EchoServerClass::Run, this);
+        }
+
+        ~EchoServerClass()
+        {
+            IsRunning = false;
+            Thread.join();
+            closesocket(Socket);
+        }
+
+        const struct sockaddr_in &Get_Address() const { return Address; }
+        int Get_Received() const { return Received; }
+
+    private:
+        void Run()
+        {
+            uint8_t ibuf[NET_BUF_SIZE];
+            struct sockaddr_in from;
+
+            while (IsRunning) {
+                int len = Receive(Socket, ibuf, sizeof(ibuf), from, 5);
+                if (len <= 0) {
+                    continue;
+                }
+
+                NetServerPacketStruct packet;
+                if (!Net_Decode_Server_Packet(ibuf, len, packet) || packet.Command != CMD_TESTP2P) {
+                    continue;
+                }
+
+                int count = ++Received;
+
+                switch (Mode) {
+                    case ECHO_REPLY:
+                        Send_Test_Packet(Socket, packet.Token, from);
+                        break;
+                    case ECHO_DROP_FIRST:
+                        if (count > DropCount) {
+                            Send_Test_Packet(Socket, packet.Token, from);
+                        }
+                        break;
+                    case ECHO_WRONG_TOKEN:
+                        Send_Test_Packet(Socket, packet.Token + 1, from);
+                        break;
+                    default:
+                        break;
+                };
+            }
+        }
+
+    private:
+        EchoModeType Mode;
+        int DropCount;
+        std::atomic<int> Received;
+        std::atomic<bool> IsRunning;
+        SOCKET Socket;
+        struct sockaddr_in Address;
+        std::thread Thread;
+};
+
+
+static uint32_t Now()
+{
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+/**
+ *  Runs the test against the server the same way CnCNet4::Process does,
+ *  polling the socket without blocking the caller for long.
+ */
+static NetProbeClass::ProbeResultType Run_Probe(const struct sockaddr_in &server, NetProbeClass &probe)
+{
+    struct sockaddr_in local;
+    SOCKET s = Open_Socket(local);
+
+    uint8_t ibuf[NET_BUF_SIZE];
+    struct sockaddr_in from;
+
+    probe.Start(Now(), 0x5EED1234, PROBE_INTERVAL, PROBE_TIMEOUT);
+
+    NetProbeClass::ProbeResultType result;
+
+    while ((result = probe.Result(Now())) == NetProbeClass::PROBE_WAITING) {
+
+        if (probe.Is_Send_Due(Now())) {
+            Send_Test_Packet(s, probe.Get_Token(), server);
+        }
+
+        int len = Receive(s, ibuf, sizeof(ibuf), from, 1);
+        if (len <= 0) {
+            continue;
+        }
+
+        if (from.sin_addr.s_addr != server.sin_addr.s_addr || from.sin_port != server.sin_port) {
+            continue;
+        }
+
+        NetServerPacketStruct packet;
+        if (Net_Decode_Server_Packet(ibuf, len, packet) && packet.Command == CMD_TESTP2P) {
+            probe.Reply(packet.Token);
+        }
+    }
+
+    closesocket(s);
+
+    return result;
+}
+
+
+static void Test_Schedule()
+{
+    NetProbeClass probe;
+
+    NP_CHECK(probe.Result(0) == NetProbeClass::PROBE_IDLE);
+    NP_CHECK(!probe.Is_Send_Due(0));
+
+    /**
+     *  Start near the wrap of the clock, the schedule must not care.
+     */
+    const uint32_t start = 0xFFFFFF00;
+    probe.Start(start, 1, PROBE_INTERVAL, PROBE_TIMEOUT);
+
+    const unsigned expected[] = { 0, 20, 60, 140, 300 };
+    unsigned sends = 0;
+
+    for (unsigned t = 0; t < PROBE_TIMEOUT + 100; ++t) {
+        if (probe.Is_Send_Due(start + t)) {
+            NP_CHECK(sends < sizeof(expected)/sizeof(expected[0]));
+            NP_CHECK(t == expected[sends]);
+            ++sends;
+        }
+        NP_CHECK(probe.Result(start + t) == ((t < PROBE_TIMEOUT) ? NetProbeClass::PROBE_WAITING : NetProbeClass::PROBE_TIMED_OUT));
+    }
+
+    NP_CHECK(sends == sizeof(expected)/sizeof(expected[0]));
+    NP_CHECK(probe.Get_Send_Count() == sends);
+
+    /**
+     *  A late reply does not pass a test that timed out, and a stale token
+     *  does not pass a test in progress.
+     */
+    NP_CHECK(!probe.Reply(1));
+    NP_CHECK(probe.Result(start + PROBE_TIMEOUT) == NetProbeClass::PROBE_TIMED_OUT);
+
+    probe.Start(0, 2, PROBE_INTERVAL, PROBE_TIMEOUT);
+    NP_CHECK(!probe.Reply(1));
+    NP_CHECK(probe.Result(10) == NetProbeClass::PROBE_WAITING);
+    NP_CHECK(probe.Reply(2));
+    NP_CHECK(probe.Result(10) == NetProbeClass::PROBE_PASSED);
+    NP_CHECK(!probe.Is_Send_Due(50));
+
+    std::printf("NetProbeTest: Schedule passed.\n");
+}
+
+
+static void Test_Pass()
+{
+    EchoServerClass server(ECHO_REPLY);
+    NetProbeClass probe;
+
+    NP_CHECK(Run_Probe(server.Get_Address(), probe) == NetProbeClass::PROBE_PASSED);
+    NP_CHECK(probe.Get_Send_Count() >= 1);
+
+    std::printf("NetProbeTest: Pass passed (%u sent).\n", probe.Get_Send_Count());
+}
+
+
+static void Test_Packet_Loss()
+{
+    EchoServerClass server(ECHO_DROP_FIRST, 2);
+    NetProbeClass probe;
+
+    NP_CHECK(Run_Probe(server.Get_Address(), probe) == NetProbeClass::PROBE_PASSED);
+    NP_CHECK(probe.Get_Send_Count() >= 3);
+    NP_CHECK(server.Get_Received() >= 3);
+
+    std::printf("NetProbeTest: Packet loss passed (%u sent).\n", probe.Get_Send_Count());
+}
+
+
+static void Test_Timeout()
+{
+    {
+        EchoServerClass server(ECHO_SILENT);
+        NetProbeClass probe;
+
+        uint32_t start = Now();
+        NP_CHECK(Run_Probe(server.Get_Address(), probe) == NetProbeClass::PROBE_TIMED_OUT);
+        NP_CHECK(Now() - start >= PROBE_TIMEOUT);
+        NP_CHECK(probe.Get_Send_Count() >= 1 && probe.Get_Send_Count() <= 5);
+    }
+
+    {
+        EchoServerClass server(ECHO_WRONG_TOKEN);
+        NetProbeClass probe;
+
+        NP_CHECK(Run_Probe(server.Get_Address(), probe) == NetProbeClass::PROBE_TIMED_OUT);
+        NP_CHECK(server.Get_Received() >= 1);
+    }
+
+    std::printf("NetProbeTest: Timeout passed.\n");
+}
+
+
+int main(int argc, char **argv)
+{
+#ifdef _WIN32
+    WSADATA wsadata;
+    NP_CHECK(WSAStartup(MAKEWORD(2, 2), &wsadata) == 0);
+#endif
+
+    Test_Schedule();
+    Test_Pass();
+    Test_Packet_Loss();
+    Test_Timeout();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    std::printf("NetProbeTest: All tests passed.\n");
+
+    return EXIT_SUCCESS;
+}
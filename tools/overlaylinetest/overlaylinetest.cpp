@@ -0,0 +1,427 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          OVERLAYLINETEST.CPP
+ *
+ *  @brief         Pixel comparison of the overlay line batch against the
+ *                 line drawing it replaced.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: OverlayLineTest [-n <frames>]
+ *
+ *  Draws random frames twice onto in-memory surfaces:
+ *  - The reference draws the way the game did before the lines were
+ *    batched. Each unit body is followed by its action and NavCom lines,
+ *    drawn at once. Each waypoint number is followed by its path line.
+ *  - The other draw goes through OverlayLineClass, flushed at the same call
+ *    sites as the hooks: once per unit, and after each path line.
+ *
+ *  Both surfaces must end up identical, and every line primitive of the
+ *  batch must run while the surface it draws to is locked. As a check that
+ *  the test can see a change in draw order, drawing all lines at the end of
+ *  the frame must give different pixels in at least one frame.
+ *
+ *  The drawing primitives are simple in-memory stand-ins (see
+ *  tools/host/dsurface.h), used the same way by both draws.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "overlayline.h"
+#include "tibsun_globals.h"
+#include "dsurface.h"
+#include "clipline.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+
+#define LINE_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "OverlayLineTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+DSurface *CompositeSurface = nullptr;
+DSurface *LogicSurface = nullptr;
+Rect TacticalRect(0, 16, 640, 400);
+
+static unsigned long FakeTime = 0;
+
+unsigned long timeGetTime()
+{
+    return FakeTime;
+}
+
+
+static unsigned Random_Seed = 1;
+
+static unsigned Random()
+{
+    Random_Seed ^= Random_Seed << 13;
+    Random_Seed ^= Random_Seed >> 17;
+    Random_Seed ^= Random_Seed << 5;
+    return Random_Seed;
+}
+
+static Point2D Random_Point()
+{
+    /**
+     *  Some points fall outside the tactical view so lines get clipped.
+     */
+    return Point2D(int(Random() % 720) - 40, int(Random() % 480) - 20);
+}
+
+
+/**
+ *  FootClassExt::_Draw_Line before batching, from the screen points on.
+ */
+static void Reference_Action_Line(Point2D start_point, Point2D end_point, bool is_dashed, bool is_thick, bool is_dropshadow, unsigned line_color, unsigned drop_color, int rate)
+{
+    int point_size = 3;
+    Point2D point_offset(-1, -1);
+
+    if (is_thick) {
+        point_size = 4;
+        point_offset = Point2D(-2, -2);
+    }
+
+    if (Clip_Line(&start_point, &end_point, &TacticalRect)) {
+
+        Point2D drop_start_point = start_point;
+        Point2D drop_end_point = end_point;
+
+        drop_start_point.Y += 1;
+        drop_end_point.Y += 1;
+
+        if (is_dashed) {
+
+            static bool _pattern[] = { true, true, true, true, false, false, false, false, true, true, true, true, false, false, false, false };
+
+            int time = timeGetTime();
+            int offset = (-time / rate) & (std::size(_pattern) - 1);
+
+            if (is_dropshadow) {
+                if (is_thick) {
+                    drop_start_point.Y += 1;
+                    drop_end_point.Y += 1;
+                }
+                CompositeSurface->Draw_Dashed_Line(drop_start_point, drop_end_point, drop_color, _pattern, offset);
+                if (is_thick) {
+                    drop_start_point.Y += 1;
+                    drop_end_point.Y += 1;
+                    CompositeSurface->Draw_Dashed_Line(drop_start_point, drop_end_point, drop_color, _pattern, offset);
+                }
+            }
+
+            CompositeSurface->Draw_Dashed_Line(start_point, end_point, line_color, _pattern, offset);
+            if (is_thick) {
+                start_point.Y += 1;
+                end_point.Y += 1;
+                CompositeSurface->Draw_Dashed_Line(start_point, end_point, line_color, _pattern, offset);
+            }
+
+        } else {
+
+            if (is_dropshadow) {
+                if (is_thick) {
+                    drop_start_point.Y += 1;
+                    drop_end_point.Y += 1;
+                }
+                CompositeSurface->Draw_Line(drop_start_point, drop_end_point, drop_color);
+                if (is_thick) {
+                    drop_start_point.Y += 1;
+                    drop_end_point.Y += 1;
+                    CompositeSurface->Draw_Line(drop_start_point, drop_end_point, drop_color);
+                }
+            }
+
+            CompositeSurface->Draw_Line(start_point, end_point, line_color);
+            if (is_thick) {
+                start_point.Y += 1;
+                end_point.Y += 1;
+                CompositeSurface->Draw_Line(start_point, end_point, line_color);
+            }
+        }
+    }
+
+    if (is_dropshadow) {
+
+        const int drop_point_size = is_thick ? (point_size + 3) : (point_size + 2);
+        const Point2D drop_point_offset = is_thick ? (point_offset + Point2D(-2, -2)) : (point_offset + Point2D(-1, -1));
+
+        if (is_thick) {
+            point_size -= 1;
+        }
+
+        Rect drop_start_point_rect = TacticalRect.Intersect_With(Rect(start_point + drop_point_offset, drop_point_size, drop_point_size));
+        CompositeSurface->Fill_Rect(drop_start_point_rect, drop_color);
+
+        Rect drop_end_point_rect = TacticalRect.Intersect_With(Rect(end_point + drop_point_offset, drop_point_size, drop_point_size));
+        CompositeSurface->Fill_Rect(drop_end_point_rect, drop_color);
+    }
+
+    Rect start_point_rect = TacticalRect.Intersect_With(Rect(start_point + point_offset, point_size, point_size));
+    CompositeSurface->Fill_Rect(start_point_rect, line_color);
+
+    Rect end_point_rect = TacticalRect.Intersect_With(Rect(end_point + point_offset, point_size, point_size));
+    CompositeSurface->Fill_Rect(end_point_rect, line_color);
+}
+
+
+/**
+ *  The rally point and waypoint path line patches before batching.
+ */
+static void Reference_Path_Line(Point2D start_pos, Point2D end_pos, bool is_dashed, unsigned color, bool blit, int rate)
+{
+    static bool _pattern[16] = { true, true, true, true, true, false, false, false, true, true, true, true, true, false, false, false };
+
+    unsigned color_black = DSurface::RGB_To_Pixel(0,0,0);
+
+    start_pos.Y += 2;
+    end_pos.Y += 2;
+
+    if (is_dashed) {
+        int time = timeGetTime();
+        int offset = (-time / rate) & (std::size(_pattern)-1);
+
+        LogicSurface->entry_48(start_pos, end_pos, color_black, _pattern, offset, blit);
+        --start_pos.Y;
+        --end_pos.Y;
+        LogicSurface->entry_48(start_pos, end_pos, color, _pattern, offset, blit);
+        --start_pos.Y;
+        --end_pos.Y;
+        LogicSurface->entry_48(start_pos, end_pos, color, _pattern, offset, blit);
+
+    } else {
+        LogicSurface->entry_4C(start_pos, end_pos, color_black);
+        --start_pos.Y;
+        --end_pos.Y;
+        LogicSurface->entry_4C(start_pos, end_pos, color);
+        --start_pos.Y;
+        --end_pos.Y;
+        LogicSurface->entry_4C(start_pos, end_pos, color);
+    }
+}
+
+
+struct ActionLineStruct
+{
+    Point2D Start;
+    Point2D End;
+    OverlayLineStyleStruct Style;
+};
+
+struct UnitStruct
+{
+    Rect Body;
+    unsigned BodyColor;
+    std::vector<ActionLineStruct> Lines;
+};
+
+struct WaypointStruct
+{
+    Rect Text;
+    Point2D Start;
+    Point2D End;
+    OverlayLineStyleStruct Style;
+};
+
+struct FrameStruct
+{
+    std::vector<UnitStruct> Units;
+    std::vector<WaypointStruct> Waypoints;
+};
+
+
+static FrameStruct Random_Frame()
+{
+    FrameStruct frame;
+
+    int units = 1 + Random() % 60;
+    for (int u = 0; u < units; ++u) {
+        UnitStruct unit;
+        Point2D pos = Random_Point();
+        unit.Body = Rect(pos.X - 12, pos.Y - 12, 24, 24);
+        unit.BodyColor = 0x100000 + u;
+
+        /**
+         *  A target line, a movement line and up to three NavCom queue lines.
+         */
+        int lines = 1 + Random() % 5;
+        Point2D start = pos;
+        for (int l = 0; l < lines; ++l) {
+            ActionLineStruct line;
+            line.Start = start;
+            line.End = Random_Point();
+            line.Style.IsDashed = (Random() & 1) != 0;
+            line.Style.IsThick = (Random() & 1) != 0;
+            line.Style.IsDropShadow = (Random() & 1) != 0;
+            line.Style.IsPath = false;
+            line.Style.IsBlit = false;
+            line.Style.Color = DSurface::RGB_To_Pixel(Random() & 0xFF, 255, 0);
+            line.Style.DropColor = DSurface::RGB_To_Pixel(0, 0, Random() & 0x3F);
+            line.Style.Rate = (l == 0) ? 64 : 128;
+            unit.Lines.push_back(line);
+            start = line.End;
+        }
+
+        frame.Units.push_back(unit);
+    }
+
+    int waypoints = Random() % 12;
+    for (int w = 0; w < waypoints; ++w) {
+        WaypointStruct waypoint;
+        waypoint.Start = Random_Point();
+        waypoint.End = Random_Point();
+        waypoint.Text = Rect(waypoint.Start.X - 6, waypoint.Start.Y - 6, 12, 12);
+        waypoint.Style.IsDashed = (Random() % 3) != 0;
+        waypoint.Style.IsThick = true;
+        waypoint.Style.IsDropShadow = true;
+        waypoint.Style.IsPath = true;
+        waypoint.Style.IsBlit = waypoint.Style.IsDashed && (Random() & 1) != 0;
+        waypoint.Style.Color = DSurface::RGB_To_Pixel(0, 255, Random() & 0xFF);
+        waypoint.Style.DropColor = DSurface::RGB_To_Pixel(0, 0, 0);
+        waypoint.Style.Rate = waypoint.Style.IsDashed ? ((Random() & 1) ? 32 : 64) : 1;
+        frame.Waypoints.push_back(waypoint);
+    }
+
+    return frame;
+}
+
+
+static void Draw_Reference(const FrameStruct &frame)
+{
+    for (const UnitStruct &unit : frame.Units) {
+        Rect body = unit.Body;
+        CompositeSurface->Fill_Rect(body, unit.BodyColor);
+        for (const ActionLineStruct &line : unit.Lines) {
+            Reference_Action_Line(line.Start, line.End, line.Style.IsDashed, line.Style.IsThick, line.Style.IsDropShadow, line.Style.Color, line.Style.DropColor, line.Style.Rate);
+        }
+    }
+
+    for (const WaypointStruct &waypoint : frame.Waypoints) {
+        Rect text = waypoint.Text;
+        LogicSurface->Fill_Rect(text, 0xFFFFFF);
+        Reference_Path_Line(waypoint.Start, waypoint.End, waypoint.Style.IsDashed, waypoint.Style.Color, waypoint.Style.IsBlit, waypoint.Style.Rate);
+    }
+}
+
+
+/**
+ *  Draws the frame through the batch, flushed as the hooks flush it, or
+ *  only once at the end of the frame.
+ */
+static void Draw_Batched(const FrameStruct &frame, bool end_of_frame)
+{
+    for (const UnitStruct &unit : frame.Units) {
+        Rect body = unit.Body;
+        CompositeSurface->Fill_Rect(body, unit.BodyColor);
+        for (const ActionLineStruct &line : unit.Lines) {
+            OverlayLineClass::Add(line.Start, line.End, line.Style);
+        }
+        if (!end_of_frame) {
+            OverlayLineClass::Draw_All();
+        }
+    }
+
+    for (const WaypointStruct &waypoint : frame.Waypoints) {
+        Rect text = waypoint.Text;
+        LogicSurface->Fill_Rect(text, 0xFFFFFF);
+        OverlayLineClass::Add(waypoint.Start, waypoint.End, waypoint.Style, LogicSurface);
+        if (!end_of_frame) {
+            OverlayLineClass::Draw_All();
+        }
+    }
+
+    OverlayLineClass::Draw_All();
+}
+
+
+int main(int argc, char **argv)
+{
+    long frames = 2000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i+1 < argc) {
+            frames = std::strtol(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "Usage: OverlayLineTest [-n <frames>]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    DSurface reference_composite(640, 480);
+    DSurface reference_logic(640, 480);
+    DSurface batch_composite(640, 480);
+    DSurface batch_logic(640, 480);
+
+    long reordered = 0;
+
+    for (long f = 0; f < frames; ++f) {
+        FrameStruct frame = Random_Frame();
+        FakeTime = Random();
+
+        reference_composite.Clear();
+        reference_logic.Clear();
+        CompositeSurface = &reference_composite;
+        LogicSurface = &reference_logic;
+        Draw_Reference(frame);
+
+        batch_composite.Clear();
+        batch_logic.Clear();
+        CompositeSurface = &batch_composite;
+        LogicSurface = &batch_logic;
+
+        /**
+         *  Only the lines are drawn under the batch's lock, so count the
+         *  unlocked primitives with the unit bodies and text boxes removed.
+         */
+        int unlocked_before = batch_composite.UnlockedDraws + batch_logic.UnlockedDraws;
+        Draw_Batched(frame, false);
+        int unlocked = batch_composite.UnlockedDraws + batch_logic.UnlockedDraws - unlocked_before;
+
+        LINE_CHECK(unlocked == int(frame.Units.size() + frame.Waypoints.size()));
+        LINE_CHECK(!batch_composite.Is_Locked() && !batch_logic.Is_Locked());
+        LINE_CHECK(OverlayLineClass::Count() == 0);
+        LINE_CHECK(batch_composite.Pixels == reference_composite.Pixels);
+        LINE_CHECK(batch_logic.Pixels == reference_logic.Pixels);
+
+        batch_composite.Clear();
+        batch_logic.Clear();
+        Draw_Batched(frame, true);
+        if (batch_composite.Pixels != reference_composite.Pixels || batch_logic.Pixels != reference_logic.Pixels) {
+            ++reordered;
+        }
+    }
+
+    LINE_CHECK(reordered > 0);
+
+    std::printf("OverlayLineTest: All tests passed (%ld frames, %ld differ when drawn at the end of the frame).\n", frames, reordered);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,470 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          PATCHCHECK.CPP
+ *
+ *  @brief         Patch manifest generator and conflict checker.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: PatchCheck scan <source directory> [<manifest output>]
+ *         PatchCheck diff <old manifest> <new manifest>
+ *
+ *  "scan" collects every patch site (Patch_*, Hook_Function, Hook_Virtual and
+ *  Change_Virtual_Address) with a literal game address from the source tree,
+ *  along with the addresses each DECLARE_PATCH body jumps back to. It reports
+ *  patches that overlap each other and patches that return into the middle
+ *  of another patch (or their own stolen bytes), then optionally writes the
+ *  manifest. The exit code is non-zero if any conflict was found.
+ *
+ *  "diff" compares two manifests and lists the patch sites that were added,
+ *  removed or changed between them.
+ *
+ *  The patch addresses are passed to the patch functions at runtime, so the
+ *  manifest is built from the source rather than read back from the DLL.
+ *  Blocks under "#if 0" are ignored; all other conditional blocks are included.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+struct PatchEntryStruct
+{
+    uint32_t Address;
+    uint32_t Length;
+    std::string Kind;
+    std::string File;
+    int Line;
+    std::string Target;                 // Name of the replacement function, if any.
+    std::vector<uint32_t> Returns;      // Game addresses the replacement jumps back to.
+};
+
+
+/**
+ *  Replaces comments and "#if 0" blocks with spaces, keeping the line breaks
+ *  so line numbers are unchanged.
+ */
+static std::string Strip_Source(const std::string &text)
+{
+    std::string out(text);
+
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (out[i] == '"') {
+            for (++i; i < out.size() && out[i] != '"' && out[i] != '\n'; ++i) {
+                if (out[i] == '\\') ++i;
+            }
+        } else if (out.compare(i, 2, "//") == 0) {
+            for (; i < out.size() && out[i] != '\n'; ++i) out[i] = ' ';
+        } else if (out.compare(i, 2, "/*") == 0) {
+            size_t end = out.find("*/", i + 2);
+            end = (end == std::string::npos) ? out.size() : end + 2;
+            for (; i < end; ++i) {
+                if (out[i] != '\n') out[i] = ' ';
+            }
+            --i;
+        }
+    }
+
+    std::istringstream in(out);
+    std::string result;
+    std::string line;
+    int skip_depth = 0;
+
+    static const std::regex if0_pattern("#\\s*if\\s+0\\s*");
+
+    while (std::getline(in, line)) {
+        size_t first = line.find_first_not_of(" \t");
+        std::string directive = (first != std::string::npos && line[first] == '#') ? line.substr(first) : std::string();
+
+        if (skip_depth > 0) {
+            if (directive.compare(0, 3, "#if") == 0) {
+                ++skip_depth;
+            } else if (directive.compare(0, 6, "#endif") == 0) {
+                --skip_depth;
+            } else if (skip_depth == 1 && (directive.compare(0, 5, "#else") == 0 || directive.compare(0, 5, "#elif") == 0)) {
+                skip_depth = 0;
+            }
+            line.assign(line.size(), ' ');
+        } else if (std::regex_match(directive, if0_pattern)) {
+            skip_depth = 1;
+        }
+
+        result += line;
+        result += '\n';
+    }
+
+    return result;
+}
+
+
+/**
+ *  Returns the line number of the character offset.
+ */
+static int Line_Of(const std::vector<size_t> &line_starts, size_t offset)
+{
+    return (int)(std::upper_bound(line_starts.begin(), line_starts.end(), offset) - line_starts.begin());
+}
+
+
+/**
+ *  Evaluates a "0x1234+5" style address expression.
+ */
+static bool Parse_Address(const std::string &expr, uint32_t &value)
+{
+    std::smatch m;
+    static const std::regex pattern("\\s*(0[xX][0-9A-Fa-f]+)\\s*(?:\\+\\s*(0[xX][0-9A-Fa-f]+|\\d+))?\\s*");
+    if (!std::regex_match(expr, m, pattern)) {
+        return false;
+    }
+    value = (uint32_t)std::strtoul(m[1].str().c_str(), nullptr, 16);
+    if (m[2].matched) {
+        value += (uint32_t)std::strtoul(m[2].str().c_str(), nullptr, 0);
+    }
+    return true;
+}
+
+
+/**
+ *  Splits the argument list of a call at the top level commas.
+ */
+static std::vector<std::string> Split_Arguments(const std::string &args)
+{
+    std::vector<std::string> out;
+    std::string current;
+    int depth = 0;
+
+    for (char c : args) {
+        if (c == '(' || c == '<' || c == '[') ++depth;
+        if (c == ')' || c == '>' || c == ']') --depth;
+        if (c == ',' && depth == 0) {
+            out.push_back(current);
+            current.clear();
+            continue;
+        }
+        current += c;
+    }
+    out.push_back(current);
+
+    return out;
+}
+
+
+/**
+ *  Removes leading and trailing whitespace.
+ */
+static std::string Trim(const std::string &str)
+{
+    size_t start = str.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return std::string();
+    }
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(start, end - start + 1);
+}
+
+
+/**
+ *  Collects the patch sites and DECLARE_PATCH return addresses of one file.
+ */
+static void Scan_File(const std::filesystem::path &path, const std::string &relative, std::vector<PatchEntryStruct> &entries)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+
+    std::string text = Strip_Source(buffer.str());
+
+    std::vector<size_t> line_starts(1, 0);
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\n') line_starts.push_back(i + 1);
+    }
+
+    /**
+     *  Find the addresses each DECLARE_PATCH body jumps back to.
+     */
+    std::map<std::string, std::vector<uint32_t>> returns;
+
+    static const std::regex declare_pattern("DECLARE_PATCH\\s*\\(\\s*(\\w+)\\s*\\)\\s*\\{");
+    static const std::regex jump_pattern("\\bJMP(?:_THIS|_STD)?\\s*\\(\\s*([^)]*)\\)|\\bJMP_REG\\s*\\(\\s*\\w+\\s*,\\s*([^)]*)\\)");
+
+    for (std::sregex_iterator it(text.begin(), text.end(), declare_pattern), end; it != end; ++it) {
+        size_t body_start = it->position(0) + it->length(0);
+        int depth = 1;
+        size_t i = body_start;
+        for (; i < text.size() && depth > 0; ++i) {
+            if (text[i] == '{') ++depth;
+            if (text[i] == '}') --depth;
+        }
+
+        std::string body = text.substr(body_start, i - body_start);
+        std::vector<uint32_t> &targets = returns[(*it)[1].str()];
+
+        for (std::sregex_iterator jt(body.begin(), body.end(), jump_pattern), jend; jt != jend; ++jt) {
+            uint32_t address;
+            std::string expr = (*jt)[1].matched ? (*jt)[1].str() : (*jt)[2].str();
+            if (Parse_Address(expr, address)) {
+                targets.push_back(address);
+            }
+        }
+    }
+
+    /**
+     *  Find the patch sites.
+     */
+    static const std::regex call_pattern("\\b(Patch_Jump|Patch_Call|Patch_Byte_Range|Patch_Byte|Patch_Word|Patch_Dword|Hook_Function|Hook_Virtual|Change_Virtual_Address)\\s*\\(([^;]*)\\)\\s*;");
+
+    for (std::sregex_iterator it(text.begin(), text.end(), call_pattern), end; it != end; ++it) {
+        std::string kind = (*it)[1].str();
+        std::vector<std::string> args = Split_Arguments((*it)[2].str());
+
+        PatchEntryStruct entry;
+        if (args.empty() || !Parse_Address(args[0], entry.Address)) {
+            continue;
+        }
+
+        entry.Kind = kind;
+        entry.File = relative;
+        entry.Line = Line_Of(line_starts, it->position(0));
+
+        if (kind == "Patch_Byte") {
+            entry.Length = 1;
+        } else if (kind == "Patch_Word") {
+            entry.Length = 2;
+        } else if (kind == "Patch_Dword" || kind == "Change_Virtual_Address") {
+            entry.Length = 4;
+        } else if (kind == "Patch_Byte_Range") {
+            entry.Length = (args.size() > 2) ? (uint32_t)std::strtoul(Trim(args[2]).c_str(), nullptr, 0) : 1;
+        } else {
+            entry.Length = 5;
+        }
+
+        /**
+         *  Record what the patch jumps to, and where that jumps back to.
+         */
+        if (args.size() > 1 && kind != "Patch_Byte_Range") {
+            std::string target = Trim(args[1]);
+            uint32_t literal;
+            if (!target.empty() && target[0] == '&') {
+                target = Trim(target.substr(1));
+            }
+            entry.Target = target;
+
+            if ((kind == "Patch_Jump" || kind == "Patch_Call") && Parse_Address(target, literal)) {
+                entry.Returns.push_back(literal);
+            } else if (returns.count(target)) {
+                entry.Returns = returns[target];
+            }
+        }
+
+        entries.push_back(entry);
+    }
+}
+
+
+/**
+ *  Writes the manifest, one patch site per line.
+ */
+static void Write_Manifest(FILE *fp, const std::vector<PatchEntryStruct> &entries)
+{
+    for (const PatchEntryStruct &entry : entries) {
+        std::fprintf(fp, "0x%08X %3u %-22s %s:%d %s\n",
+            entry.Address, entry.Length, entry.Kind.c_str(), entry.File.c_str(), entry.Line,
+            entry.Target.empty() ? "-" : entry.Target.c_str());
+    }
+}
+
+
+static int Do_Scan(const char *directory, const char *manifest_filename)
+{
+    std::filesystem::path root(directory);
+    if (!std::filesystem::is_directory(root)) {
+        std::fprintf(stderr, "\"%s\" is not a directory!\n", directory);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<PatchEntryStruct> entries;
+
+    for (const auto &item : std::filesystem::recursive_directory_iterator(root)) {
+        if (!item.is_regular_file()) {
+            continue;
+        }
+        std::string ext = item.path().extension().string();
+        if (ext != ".cpp" && ext != ".h") {
+            continue;
+        }
+        std::string relative = std::filesystem::relative(item.path(), root).generic_string();
+
+        /**
+         *  The patch functions themselves are not patch sites.
+         */
+        if (relative.compare(0, 7, "hooker/") == 0) {
+            continue;
+        }
+
+        Scan_File(item.path(), relative, entries);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const PatchEntryStruct &a, const PatchEntryStruct &b) {
+        if (a.Address != b.Address) return a.Address < b.Address;
+        if (a.File != b.File) return a.File < b.File;
+        return a.Line < b.Line;
+    });
+
+    int conflicts = 0;
+
+    uint32_t max_length = 0;
+    for (const PatchEntryStruct &entry : entries) {
+        max_length = std::max(max_length, entry.Length);
+    }
+
+    /**
+     *  Check for patches that overlap any patch before them.
+     */
+    for (size_t i = 1; i < entries.size(); ++i) {
+        for (size_t j = i; j-- > 0; ) {
+            if (entries[j].Address + max_length <= entries[i].Address) {
+                break;
+            }
+            if (entries[j].Address + entries[j].Length <= entries[i].Address) {
+                continue;
+            }
+            std::printf("OVERLAP: 0x%08X (%s:%d) overlaps 0x%08X-0x%08X (%s:%d)\n",
+                entries[i].Address, entries[i].File.c_str(), entries[i].Line,
+                entries[j].Address, entries[j].Address + entries[j].Length,
+                entries[j].File.c_str(), entries[j].Line);
+            ++conflicts;
+        }
+    }
+
+    /**
+     *  Check for patches that jump back into the middle of a patched range.
+     */
+    for (const PatchEntryStruct &entry : entries) {
+        for (uint32_t target : entry.Returns) {
+            for (const PatchEntryStruct &other : entries) {
+                if (target > other.Address && target < other.Address + other.Length) {
+                    std::printf("RETURN INTO PATCH: %s (%s:%d) jumps to 0x%08X inside 0x%08X-0x%08X (%s:%d)\n",
+                        entry.Target.c_str(), entry.File.c_str(), entry.Line, target,
+                        other.Address, other.Address + other.Length, other.File.c_str(), other.Line);
+                    ++conflicts;
+                }
+            }
+        }
+    }
+
+    std::printf("%u patch sites, %d conflicts.\n", (unsigned)entries.size(), conflicts);
+
+    if (manifest_filename) {
+        FILE *fp = std::fopen(manifest_filename, "w");
+        if (!fp) {
+            std::fprintf(stderr, "Failed to create manifest \"%s\"!\n", manifest_filename);
+            return EXIT_FAILURE;
+        }
+        Write_Manifest(fp, entries);
+        std::fclose(fp);
+    }
+
+    return conflicts ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+/**
+ *  Reads a manifest, keyed by address, length and kind. The source location is
+ *  kept as the value so moved code is not reported as a change.
+ */
+static bool Read_Manifest(const char *filename, std::multimap<std::string, std::string> &out)
+{
+    std::ifstream in(filename);
+    if (!in) {
+        std::fprintf(stderr, "Failed to open manifest \"%s\"!\n", filename);
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string address, length, kind, location, target;
+        if (!(fields >> address >> length >> kind >> location >> target)) {
+            continue;
+        }
+        out.insert(std::make_pair(address + " " + length + " " + kind + " " + target, location));
+    }
+
+    return true;
+}
+
+
+static int Do_Diff(const char *old_filename, const char *new_filename)
+{
+    std::multimap<std::string, std::string> old_entries;
+    std::multimap<std::string, std::string> new_entries;
+
+    if (!Read_Manifest(old_filename, old_entries) || !Read_Manifest(new_filename, new_entries)) {
+        return EXIT_FAILURE;
+    }
+
+    int changes = 0;
+
+    for (const auto &entry : old_entries) {
+        if (!new_entries.count(entry.first)) {
+            std::printf("- %s (%s)\n", entry.first.c_str(), entry.second.c_str());
+            ++changes;
+        }
+    }
+
+    for (const auto &entry : new_entries) {
+        if (!old_entries.count(entry.first)) {
+            std::printf("+ %s (%s)\n", entry.first.c_str(), entry.second.c_str());
+            ++changes;
+        }
+    }
+
+    std::printf("%d patch sites differ.\n", changes);
+
+    return EXIT_SUCCESS;
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && std::strcmp(argv[1], "scan") == 0) {
+        return Do_Scan(argv[2], argc > 3 ? argv[3] : nullptr);
+    }
+
+    if (argc == 4 && std::strcmp(argv[1], "diff") == 0) {
+        return Do_Diff(argv[2], argv[3]);
+    }
+
+    std::fprintf(stderr, "Usage: %s scan <source directory> [<manifest output>]\n", argv[0]);
+    std::fprintf(stderr, "       %s diff <old manifest> <new manifest>\n", argv[0]);
+    return EXIT_FAILURE;
+}
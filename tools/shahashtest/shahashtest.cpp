@@ -0,0 +1,295 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          SHAHASHTEST.CPP
+ *
+ *  @brief         Known answer tests and benchmark for the SHA-1 hash.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: SHAHashTest [-n <iterations>]
+ *
+ *  Checks SHA against the FIPS 180-1 vectors (and the longer vectors from
+ *  the SHS validation set), then checks random messages of every length
+ *  up to a few blocks, at every alignment and fed in random chunks, against
+ *  a plain reference implementation that selects the round function on each
+ *  round, as SHA::Process_Block did before its rounds were split into four
+ *  loops. Also times both on a large buffer. Any failed check aborts the tool.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "sha.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+#define SHA_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "SHAHashTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+/**
+ *  FIPS 180-1 appendix A and B vectors, the empty message, and the
+ *  896-bit message from the SHS validation set.
+ */
+static const struct {
+    const char *Message;
+    const char *Digest;
+} KnownAnswers[] = {
+    { "", "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+    { "abc", "a9993e364706816aba3e25717850c26c9cd0d89d" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+    { "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", "a49b2446a02c645bf419f995b67091253a04a259" },
+};
+
+
+/**
+ *  A straightforward SHA-1 to check the engine against.
+ */
+static void Reference_Block(const unsigned char *block, uint32_t *h)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+        const unsigned char *p = &block[i * 4];
+        w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+    for (int i = 16; i < 80; ++i) {
+        w[i] = _rotl(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f;
+        uint32_t k;
+        if (i < 20) {
+            f = d ^ (b & (c ^ d));
+            k = 0x5a827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60) {
+            f = (b & c) | (d & (b | c));
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        uint32_t temp = _rotl(a, 5) + f + e + w[i] + k;
+        e = d;
+        d = c;
+        c = _rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+static void Reference_SHA(const unsigned char *data, size_t length, unsigned char *digest)
+{
+    uint32_t h[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+    size_t full = length & ~size_t(63);
+    for (size_t pos = 0; pos < full; pos += 64) {
+        Reference_Block(data + pos, h);
+    }
+
+    /**
+     *  Pad the tail with the 0x80 marker and the length in bits.
+     */
+    unsigned char tail[128] = {};
+    size_t rest = length - full;
+    std::memcpy(tail, data + full, rest);
+    tail[rest] = 0x80;
+    size_t tail_size = (rest < 56) ? 64 : 128;
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 0; i < 8; ++i) {
+        tail[tail_size - 1 - i] = (unsigned char)(bits >> (i * 8));
+    }
+    for (size_t pos = 0; pos < tail_size; pos += 64) {
+        Reference_Block(tail + pos, h);
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        digest[i*4+0] = (unsigned char)(h[i] >> 24);
+        digest[i*4+1] = (unsigned char)(h[i] >> 16);
+        digest[i*4+2] = (unsigned char)(h[i] >> 8);
+        digest[i*4+3] = (unsigned char)h[i];
+    }
+}
+
+
+static unsigned Random_Seed = 1;
+
+static unsigned Random()
+{
+    Random_Seed ^= Random_Seed << 13;
+    Random_Seed ^= Random_Seed >> 17;
+    Random_Seed ^= Random_Seed << 5;
+    return Random_Seed;
+}
+
+
+static void Test_Known_Answers()
+{
+    for (const auto &kat : KnownAnswers) {
+        SHA sha;
+        sha.Hash(kat.Message, (long)std::strlen(kat.Message));
+
+        char hex[41];
+        SHA_CHECK(sha.Print_Result(hex) == SHA::Digest_Size());
+        SHA_CHECK(std::strcmp(hex, kat.Digest) == 0);
+
+        /**
+         *  The result is cached, asking again must give the same digest.
+         */
+        SHA_CHECK(sha.Print_Result(hex) == SHA::Digest_Size());
+        SHA_CHECK(std::strcmp(hex, kat.Digest) == 0);
+    }
+
+    /**
+     *  One million repetitions of 'a', in one call and one byte at a time.
+     */
+    std::vector<char> million(1000000, 'a');
+    const char *expected = "34aa973cd4c4daa4f61eeb2bdbad27316534016f";
+    char hex[41];
+
+    SHA whole;
+    whole.Hash(million.data(), (long)million.size());
+    whole.Print_Result(hex);
+    SHA_CHECK(std::strcmp(hex, expected) == 0);
+
+    SHA bytes;
+    for (size_t i = 0; i < million.size(); ++i) {
+        bytes.Hash(&million[i], 1);
+    }
+    bytes.Print_Result(hex);
+    SHA_CHECK(std::strcmp(hex, expected) == 0);
+}
+
+
+/**
+ *  Every length across the padding boundaries and several blocks, at every
+ *  alignment, in one call and in random chunks.
+ */
+static void Test_Lengths(long iterations)
+{
+    std::vector<unsigned char> buffer(4096 + 8);
+
+    for (long i = 0; i < iterations; ++i) {
+        size_t length = (i < 320) ? size_t(i) : Random() % 4096;
+        size_t offset = Random() % 8;
+
+        unsigned char *data = &buffer[offset];
+        for (size_t b = 0; b < length; ++b) {
+            data[b] = (unsigned char)Random();
+        }
+
+        unsigned char expected[20];
+        Reference_SHA(data, length, expected);
+
+        unsigned char digest[20];
+        SHA whole;
+        whole.Hash(data, (long)length);
+        SHA_CHECK(whole.Result(digest) == 20);
+        SHA_CHECK(std::memcmp(digest, expected, 20) == 0);
+
+        SHA chunked;
+        for (size_t pos = 0; pos < length; ) {
+            size_t chunk = 1 + Random() % 200;
+            if (chunk > length - pos) {
+                chunk = length - pos;
+            }
+            chunked.Hash(data + pos, (long)chunk);
+            pos += chunk;
+        }
+        SHA_CHECK(chunked.Result(digest) == 20);
+        SHA_CHECK(std::memcmp(digest, expected, 20) == 0);
+    }
+}
+
+
+static void Benchmark()
+{
+    const size_t size = 16 * 1024 * 1024;
+    std::vector<unsigned char> data(size + 1);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (unsigned char)Random();
+    }
+
+    unsigned char digest[20];
+
+    auto start = std::chrono::steady_clock::now();
+    Reference_SHA(data.data(), size, digest);
+    double reference = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    SHA aligned;
+    aligned.Hash(data.data(), (long)size);
+    aligned.Result(digest);
+    double engine = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    SHA unaligned;
+    unaligned.Hash(data.data() + 1, (long)size);
+    unaligned.Result(digest);
+    double offset = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double mb = double(size) / (1024 * 1024);
+    std::printf("SHAHashTest: Per round selection %.1f MB/s, SHA %.1f MB/s aligned, %.1f MB/s unaligned.\n",
+        mb / reference, mb / engine, mb / offset);
+}
+
+
+int main(int argc, char **argv)
+{
+    long iterations = 4000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i+1 < argc) {
+            iterations = std::strtol(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "Usage: SHAHashTest [-n <iterations>]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    Test_Known_Answers();
+    Test_Lengths(iterations);
+
+    std::printf("SHAHashTest: All tests passed.\n");
+
+    Benchmark();
+
+    return EXIT_SUCCESS;
+}
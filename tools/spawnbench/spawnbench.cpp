@@ -0,0 +1,297 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          SPAWNBENCH.CPP
+ *
+ *  @brief         Benchmark for the spawn manager status counts.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: SpawnBench [-n <ticks>]
+ *
+ *  Models the status queries SpawnManagerClass makes for carriers with many
+ *  spawns. On every logic tick each carrier changes the status of some of
+ *  its spawns through Set_Status, then asks what the AI and the owner ask:
+ *  the Launching and Cooldown checks, Active_Count, Docked_Count and
+ *  Preparing_Count. This is timed with the counts kept by Set_Status, and
+ *  with each query scanning the controls as the manager did before. Every
+ *  answer from the counts is checked against the scan, and the counts are
+ *  checked against a recount after every tick, as Validate_Status does.
+ *  Any failed check aborts the tool.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+#define SPAWN_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "SpawnBench: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+enum class SpawnControlStatus {
+    Idle = 0,
+    Takeoff = 1,
+    Preparing = 2,
+    Attacking = 3,
+    Returning = 4,
+    Reloading = 6,
+    Dead = 7
+};
+
+#define SPAWN_CONTROL_STATUS_COUNT (static_cast<int>(SpawnControlStatus::Dead) + 1)
+
+
+/**
+ *  Stands in for SpawnManagerClass::SpawnControl, about the same size.
+ */
+struct SpawnControl
+{
+    void *Spawnee;
+    SpawnControlStatus Status;
+    int ReloadTimer[3];
+    bool IsSpawnedMissile;
+};
+
+
+static unsigned Random_Seed = 1;
+
+static unsigned Random()
+{
+    Random_Seed ^= Random_Seed << 13;
+    Random_Seed ^= Random_Seed >> 17;
+    Random_Seed ^= Random_Seed << 5;
+    return Random_Seed;
+}
+
+
+class Carrier
+{
+    public:
+        Carrier(int spawns) : Controls(spawns)
+        {
+            for (auto &control : Controls) {
+                control.Spawnee = nullptr;
+                control.Status = SpawnControlStatus::Idle;
+                control.IsSpawnedMissile = false;
+            }
+            Recount_Status();
+        }
+
+        void Set_Status(SpawnControl *control, SpawnControlStatus status)
+        {
+            --StatusCounts[static_cast<int>(control->Status)];
+            ++StatusCounts[static_cast<int>(status)];
+            control->Status = status;
+        }
+
+        void Recount_Status()
+        {
+            std::memset(StatusCounts, 0, sizeof(StatusCounts));
+            for (const auto &control : Controls) {
+                ++StatusCounts[static_cast<int>(control.Status)];
+            }
+        }
+
+        int Status_Count(SpawnControlStatus status) const { return StatusCounts[static_cast<int>(status)]; }
+
+        /**
+         *  The queries answered from the counts.
+         */
+        bool Launch_Done() const { return Status_Count(SpawnControlStatus::Preparing) + Status_Count(SpawnControlStatus::Dead) == int(Controls.size()); }
+        bool Cooldown_Done() const { return Status_Count(SpawnControlStatus::Attacking) + Status_Count(SpawnControlStatus::Returning) == 0; }
+        int Active_Count() const { return int(Controls.size()) - Status_Count(SpawnControlStatus::Dead); }
+        int Docked_Count() const { return Status_Count(SpawnControlStatus::Reloading) + Status_Count(SpawnControlStatus::Idle); }
+        int Preparing_Count() const { return Status_Count(SpawnControlStatus::Takeoff); }
+
+        /**
+         *  The same queries answered by scanning the controls.
+         */
+        bool Scan_Launch_Done() const
+        {
+            for (const auto &control : Controls) {
+                if (control.Status != SpawnControlStatus::Preparing && control.Status != SpawnControlStatus::Dead) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool Scan_Cooldown_Done() const
+        {
+            for (const auto &control : Controls) {
+                if (control.Status == SpawnControlStatus::Attacking || control.Status == SpawnControlStatus::Returning) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        int Scan_Count(SpawnControlStatus a, SpawnControlStatus b) const
+        {
+            int count = 0;
+            for (const auto &control : Controls) {
+                if (control.Status == a || control.Status == b) {
+                    ++count;
+                }
+            }
+            return count;
+        }
+
+        int Scan_Active_Count() const { return int(Controls.size()) - Scan_Count(SpawnControlStatus::Dead, SpawnControlStatus::Dead); }
+        int Scan_Docked_Count() const { return Scan_Count(SpawnControlStatus::Reloading, SpawnControlStatus::Idle); }
+        int Scan_Preparing_Count() const { return Scan_Count(SpawnControlStatus::Takeoff, SpawnControlStatus::Takeoff); }
+
+        /**
+         *  Moves a few spawns on to another status, as a logic tick does.
+         */
+        void Tick()
+        {
+            static const SpawnControlStatus next[] = {
+                SpawnControlStatus::Idle, SpawnControlStatus::Takeoff, SpawnControlStatus::Preparing,
+                SpawnControlStatus::Attacking, SpawnControlStatus::Returning, SpawnControlStatus::Reloading,
+                SpawnControlStatus::Dead
+            };
+
+            for (auto &control : Controls) {
+                if ((Random() & 7) == 0) {
+                    Set_Status(&control, next[Random() % (sizeof(next) / sizeof(next[0]))]);
+                }
+            }
+        }
+
+        void Validate_Status() const
+        {
+            int counts[SPAWN_CONTROL_STATUS_COUNT] = { 0 };
+            for (const auto &control : Controls) {
+                ++counts[static_cast<int>(control.Status)];
+            }
+            SPAWN_CHECK(std::memcmp(counts, StatusCounts, sizeof(counts)) == 0);
+        }
+
+    public:
+        std::vector<SpawnControl> Controls;
+        int StatusCounts[SPAWN_CONTROL_STATUS_COUNT];
+};
+
+
+/**
+ *  The AI and the owner ask each of these on every logic tick.
+ */
+static int Query_Counts(const Carrier &carrier)
+{
+    return carrier.Launch_Done() + carrier.Cooldown_Done() + carrier.Active_Count() + carrier.Docked_Count() + carrier.Preparing_Count();
+}
+
+static int Query_Scan(const Carrier &carrier)
+{
+    return carrier.Scan_Launch_Done() + carrier.Scan_Cooldown_Done() + carrier.Scan_Active_Count() + carrier.Scan_Docked_Count() + carrier.Scan_Preparing_Count();
+}
+
+
+static void Test_Counts(int spawns, int ticks)
+{
+    Carrier carrier(spawns);
+
+    for (int tick = 0; tick < ticks; ++tick) {
+        carrier.Tick();
+        carrier.Validate_Status();
+
+        SPAWN_CHECK(carrier.Launch_Done() == carrier.Scan_Launch_Done());
+        SPAWN_CHECK(carrier.Cooldown_Done() == carrier.Scan_Cooldown_Done());
+        SPAWN_CHECK(carrier.Active_Count() == carrier.Scan_Active_Count());
+        SPAWN_CHECK(carrier.Docked_Count() == carrier.Scan_Docked_Count());
+        SPAWN_CHECK(carrier.Preparing_Count() == carrier.Scan_Preparing_Count());
+    }
+
+    /**
+     *  A load rebuilds the counts from the controls.
+     */
+    std::memset(carrier.StatusCounts, 0xCD, sizeof(carrier.StatusCounts));
+    carrier.Recount_Status();
+    carrier.Validate_Status();
+}
+
+
+static double Time_Ticks(int carriers, int spawns, int ticks, int (*query)(const Carrier &), long long &total)
+{
+    std::vector<Carrier> fleet(carriers, Carrier(spawns));
+
+    Random_Seed = 1;
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick) {
+        for (auto &carrier : fleet) {
+            carrier.Tick();
+            total += query(carrier);
+        }
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / (double(ticks) * carriers);
+}
+
+
+int main(int argc, char **argv)
+{
+    int ticks = 20000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i+1 < argc) {
+            ticks = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: SpawnBench [-n <ticks>]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (ticks <= 0) {
+        ticks = 1;
+    }
+
+    static const int spawn_counts[] = { 4, 40, 80, 160 };
+
+    for (int spawns : spawn_counts) {
+        Test_Counts(spawns, 2000);
+    }
+
+    std::printf("SpawnBench: All tests passed.\n");
+    std::printf("SpawnBench: Microseconds per carrier per logic tick, 20 carriers.\n");
+    std::printf("%7s %10s %10s\n", "spawns", "scan", "counts");
+
+    long long total_scan = 0;
+    long long total_counts = 0;
+
+    for (int spawns : spawn_counts) {
+        double scan = Time_Ticks(20, spawns, ticks, Query_Scan, total_scan);
+        double counts = Time_Ticks(20, spawns, ticks, Query_Counts, total_counts);
+        std::printf("%7d %10.3f %10.3f\n", spawns, scan, counts);
+    }
+
+    SPAWN_CHECK(total_scan == total_counts);
+
+    return EXIT_SUCCESS;
+}
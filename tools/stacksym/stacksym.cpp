@@ -0,0 +1,251 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          STACKSYM.CPP
+ *
+ *  @brief         Offline symbolizer for raw stack records (STACK_*.BIN).
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: StackSym <STACK_*.BIN> <module.map> [<module.map> ...]
+ *
+ *  Resolves the return addresses in a raw stack record against the linker
+ *  map files of the modules, and prints the result in the same format as the
+ *  STACK_*.LOG files. Each map file is matched to a module by file name, so
+ *  "Vinifera.map" is used for "Vinifera.dll".
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "stackraw.h"
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+struct MapSymbolStruct
+{
+    uint32_t Address;
+    std::string Name;
+};
+
+
+struct MapFileStruct
+{
+    std::string ModuleName;
+    uint32_t PreferredBase;
+    std::vector<MapSymbolStruct> Symbols;
+};
+
+
+/**
+ *  Returns the file name without its path and extension, in upper case.
+ */
+static std::string Get_Base_Name(const std::string &path)
+{
+    size_t start = path.find_last_of("/\\");
+    start = (start == std::string::npos) ? 0 : start + 1;
+
+    size_t end = path.find_last_of('.');
+    if (end == std::string::npos || end < start) {
+        end = path.size();
+    }
+
+    std::string name = path.substr(start, end - start);
+    for (size_t i = 0; i < name.size(); ++i) {
+        name[i] = (char)std::toupper((unsigned char)name[i]);
+    }
+    return name;
+}
+
+
+/**
+ *  Loads the public and static symbols from a MSVC linker map file.
+ *
+ *  The symbol lines are in the form;
+ *    " 0001:00000000       _Symbol       10001000 f   object.obj"
+ */
+static bool Load_Map_File(const char *filename, MapFileStruct &map)
+{
+    FILE *fp = std::fopen(filename, "r");
+    if (!fp) {
+        std::fprintf(stderr, "Failed to open map file \"%s\"!\n", filename);
+        return false;
+    }
+
+    map.ModuleName = Get_Base_Name(filename);
+    map.PreferredBase = 0;
+    map.Symbols.clear();
+
+    char line[4096];
+    while (std::fgets(line, sizeof(line), fp)) {
+
+        const char *base = std::strstr(line, "Preferred load address is");
+        if (base) {
+            map.PreferredBase = (uint32_t)std::strtoul(base + std::strlen("Preferred load address is"), nullptr, 16);
+            continue;
+        }
+
+        unsigned section = 0;
+        unsigned offset = 0;
+        char name[2048];
+        char address[32];
+
+        if (std::sscanf(line, " %x:%x %2047s %31s", &section, &offset, name, address) != 4) {
+            continue;
+        }
+
+        /**
+         *  Make sure this really is a symbol line, and not one of the
+         *  section table lines that share the same leading format.
+         */
+        if (std::strlen(address) != 8 || !std::isxdigit((unsigned char)address[0])) {
+            continue;
+        }
+
+        MapSymbolStruct symbol;
+        symbol.Address = (uint32_t)std::strtoul(address, nullptr, 16);
+        symbol.Name = name;
+
+        if (symbol.Address != 0) {
+            map.Symbols.push_back(symbol);
+        }
+    }
+
+    std::fclose(fp);
+
+    std::sort(map.Symbols.begin(), map.Symbols.end(),
+        [](const MapSymbolStruct &a, const MapSymbolStruct &b) { return a.Address < b.Address; });
+
+    return true;
+}
+
+
+/**
+ *  Finds the symbol that contains the address, or nullptr.
+ */
+static const MapSymbolStruct *Find_Symbol(const MapFileStruct &map, uint32_t address)
+{
+    auto it = std::upper_bound(map.Symbols.begin(), map.Symbols.end(), address,
+        [](uint32_t value, const MapSymbolStruct &symbol) { return value < symbol.Address; });
+
+    if (it == map.Symbols.begin()) {
+        return nullptr;
+    }
+
+    return &*(it - 1);
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <STACK_*.BIN> <module.map> [<module.map> ...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *fp = std::fopen(argv[1], "rb");
+    if (!fp) {
+        std::fprintf(stderr, "Failed to open stack record \"%s\"!\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    StackRawHeaderStruct header;
+    if (std::fread(&header, sizeof(header), 1, fp) != 1
+        || header.Magic != STACK_RAW_MAGIC || header.Version != STACK_RAW_VERSION
+        || header.ModuleCount > STACK_RAW_MODULES_MAX || header.FrameCount > STACK_RAW_FRAMES_MAX) {
+
+        std::fprintf(stderr, "\"%s\" is not a valid stack record!\n", argv[1]);
+        std::fclose(fp);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<StackRawModuleStruct> modules(header.ModuleCount);
+    std::vector<uint32_t> frames(header.FrameCount);
+
+    if ((header.ModuleCount && std::fread(&modules[0], sizeof(StackRawModuleStruct), header.ModuleCount, fp) != header.ModuleCount)
+        || (header.FrameCount && std::fread(&frames[0], sizeof(uint32_t), header.FrameCount, fp) != header.FrameCount)) {
+
+        std::fprintf(stderr, "\"%s\" is truncated!\n", argv[1]);
+        std::fclose(fp);
+        return EXIT_FAILURE;
+    }
+
+    std::fclose(fp);
+
+    std::vector<MapFileStruct> maps;
+    for (int i = 2; i < argc; ++i) {
+        MapFileStruct map;
+        if (Load_Map_File(argv[i], map)) {
+            maps.push_back(map);
+        }
+    }
+
+    std::printf("Call Stack:\r\n");
+
+    for (uint32_t i = 0; i < header.FrameCount; ++i) {
+
+        const uint32_t address = frames[i];
+        std::string funcname = "<Unknown>";
+
+        /**
+         *  Find the module the address belongs to, then the map file for that
+         *  module, and rebase the address to the preferred load address.
+         */
+        for (size_t m = 0; m < modules.size(); ++m) {
+
+            const StackRawModuleStruct &module = modules[m];
+            if (address < module.Base || address - module.Base >= module.Size) {
+                continue;
+            }
+
+            char module_name[STACK_RAW_MODULE_NAME_MAX+1];
+            std::memcpy(module_name, module.Name, STACK_RAW_MODULE_NAME_MAX);
+            module_name[STACK_RAW_MODULE_NAME_MAX] = '\0';
+
+            const std::string base_name = Get_Base_Name(module_name);
+
+            for (size_t j = 0; j < maps.size(); ++j) {
+                if (maps[j].ModuleName != base_name) {
+                    continue;
+                }
+
+                const uint32_t preferred = address - module.Base + maps[j].PreferredBase;
+                const MapSymbolStruct *symbol = Find_Symbol(maps[j], preferred);
+                if (symbol) {
+                    char buffer[64];
+                    std::snprintf(buffer, sizeof(buffer), "+0x%X();", preferred - symbol->Address);
+                    funcname = symbol->Name + buffer;
+                }
+                break;
+            }
+            break;
+        }
+
+        std::printf("  %s(%d) : %s 0x%08" PRIX32 "\r\n", "<Unknown>", -1, funcname.c_str(), address);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,262 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          TEXTWRAP.CPP
+ *
+ *  @brief         Checks the word wrap layout against the original line breaker.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: TextWrap [-n <iterations>] [-s <seed>]
+ *
+ *  Formats random strings with both TextLayoutClass and the original
+ *  Format_Window_String line breaker (using a fake font), and aborts if the
+ *  line count, width, height or the formatted string differ. The cached
+ *  formatter is run twice on each string so the cache hits are checked too.
+ *
+ *  The original breaker never finishes when a word is wider than the line,
+ *  so the random words are always kept narrower than the line.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "textlayout.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+#define WRAP_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "TextWrap: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+/**
+ *  Stands in for WWFontClass, with a different width for each glyph.
+ */
+class FakeFontClass
+{
+    public:
+        FakeFontClass(unsigned seed)
+        {
+            for (int c = 0; c < TEXT_LAYOUT_GLYPH_COUNT; ++c) {
+                seed = seed * 1103515245U + 12345U;
+                Widths[c] = 3 + int((seed >> 16) % 8);
+            }
+            Widths[0] = 0;
+        }
+
+        virtual ~FakeFontClass() {}
+
+        virtual int Char_Pixel_Width(char c) const { return Widths[(unsigned char)c]; }
+        int Get_Font_Height() const { return 12; }
+        int Get_Y_Spacing() const { return 2; }
+
+        int Widths[TEXT_LAYOUT_GLYPH_COUNT];
+};
+
+
+/**
+ *  The original implementation from textprintext_hooks.cpp, which asks the
+ *  font for the width of every character.
+ */
+static int Reference_Format(char *string, FakeFontClass *font, int maxlinelen, int &width, int &height)
+{
+    int    linelen;
+    int    lines = 0;
+    width = 0;
+    height = 0;
+
+    if (!string)
+        return 0;
+
+    if (!font)
+        return 0;
+
+    while (*string) {
+        linelen = 0;
+        height += font->Get_Font_Height() + font->Get_Y_Spacing();
+        lines++;
+
+        if (*string == '@') {
+            *string = '\r';
+        }
+
+        while (linelen < maxlinelen && *string != '\r' && *string != '\0' && *string != '@') {
+            linelen += font->Char_Pixel_Width(*string);
+            string++;
+        }
+
+        if (linelen >= maxlinelen) {
+            while (linelen > maxlinelen || (*string != ' ' && *string != '\r' && *string != '\0' && *string != '@')) {
+                linelen -= font->Char_Pixel_Width(*string);
+                string--;
+            }
+        }
+
+        if (linelen > width) {
+            width = linelen;
+
+            if (width > maxlinelen) {
+                width = linelen;
+            }
+        }
+
+        if (*string) {
+            *string++ = '\r';
+        }
+    }
+
+    return lines;
+}
+
+
+static unsigned Random_Seed = 1;
+
+static unsigned Random()
+{
+    Random_Seed ^= Random_Seed << 13;
+    Random_Seed ^= Random_Seed >> 17;
+    Random_Seed ^= Random_Seed << 5;
+    return Random_Seed;
+}
+
+
+/**
+ *  Builds a random string of words that each fit within the line length.
+ */
+static std::string Random_String(const FakeFontClass &font, int maxlinelen)
+{
+    std::string string;
+
+    int words = Random() % 60;
+    for (int i = 0; i < words; ++i) {
+
+        int len = 0;
+        int count = 1 + Random() % 12;
+        for (int j = 0; j < count; ++j) {
+            char c = (char)(33 + Random() % 94);
+            if (c == '@') {
+                continue;
+            }
+            if (len + font.Widths[(unsigned char)c] + font.Widths[' '] >= maxlinelen) {
+                break;
+            }
+            len += font.Widths[(unsigned char)c];
+            string += c;
+        }
+
+        switch (Random() % 16) {
+            case 0: string += '@'; break;
+            case 1: string += '\r'; break;
+            case 2: string += "  "; break;
+            default: string += ' '; break;
+        }
+    }
+
+    return string;
+}
+
+
+int main(int argc, char **argv)
+{
+    long iterations = 100000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-n") && i+1 < argc) {
+            iterations = std::strtol(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-s") && i+1 < argc) {
+            Random_Seed = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+            if (!Random_Seed) {
+                Random_Seed = 1;
+            }
+        } else {
+            std::fprintf(stderr, "Usage: TextWrap [-n <iterations>] [-s <seed>]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    FakeFontClass fonts[] = { FakeFontClass(1), FakeFontClass(2), FakeFontClass(3) };
+
+    double reference_time = 0.0;
+    double layout_time = 0.0;
+
+    for (long i = 0; i < iterations; ++i) {
+
+        FakeFontClass &font = fonts[Random() % 3];
+        int maxlinelen = 40 + Random() % 300;
+        int lineheight = font.Get_Font_Height() + font.Get_Y_Spacing();
+
+        std::string string = Random_String(font, maxlinelen);
+
+        std::vector<char> expected(string.c_str(), string.c_str() + string.size() + 1);
+        int expected_width = 0;
+        int expected_height = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        int expected_lines = Reference_Format(&expected[0], &font, maxlinelen, expected_width, expected_height);
+        reference_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        /**
+         *  The first call fills the cache, the second should hit it.
+         */
+        for (int pass = 0; pass < 2; ++pass) {
+            std::vector<char> actual(string.c_str(), string.c_str() + string.size() + 1);
+            int width = 0;
+            int height = 0;
+
+            start = std::chrono::steady_clock::now();
+            int lines = TextLayoutClass::Format_Cached(&font, &actual[0], font.Widths, lineheight, maxlinelen, width, height);
+            layout_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            WRAP_CHECK(lines == expected_lines);
+            WRAP_CHECK(width == expected_width);
+            WRAP_CHECK(height == expected_height);
+            WRAP_CHECK(actual == expected);
+        }
+    }
+
+    /**
+     *  A word wider than the line should overflow it rather than hang.
+     */
+    char longword[] = "short averyveryverylongwordthatcannotfit end";
+    int width = 0;
+    int height = 0;
+    int lines = TextLayoutClass::Format(longword, fonts[0].Widths, 14, 40, width, height);
+    WRAP_CHECK(lines == 3);
+    WRAP_CHECK(!std::strcmp(longword, "short\raveryveryverylongwordthatcannotfit\rend"));
+
+    TextLayoutClass::Flush();
+
+    std::printf("TextWrap: %ld strings matched (%d cache hits, %d misses).\n",
+        iterations, TextLayoutClass::Get_Hits(), TextLayoutClass::Get_Misses());
+    std::printf("TextWrap: Original %.1f ns per string, layout %.1f ns per call.\n",
+        reference_time * 1e9 / iterations, layout_time * 1e9 / (iterations * 2));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,220 @@
+/*******************************************************************************
+/*                 O P E N  S O U R C E  --  V I N I F E R A                  **
+/*******************************************************************************
+ *
+ *  @project       Vinifera
+ *
+ *  @file          VOXELVARIANTTEST.CPP
+ *
+ *  @brief         Tests for the unit voxel variant conditions.
+ *
+ *  @license       Vinifera is free software: you can redistribute it and/or
+ *                 modify it under the terms of the GNU General Public License
+ *                 as published by the Free Software Foundation, either version
+ *                 3 of the License, or (at your option) any later version.
+ *
+ *                 Vinifera is distributed in the hope that it will be
+ *                 useful, but WITHOUT ANY WARRANTY; without even the implied
+ *                 warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *                 PURPOSE. See the GNU General Public License for more details.
+ *
+ *                 You should have received a copy of the GNU General Public
+ *                 License along with this program.
+ *                 If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  Usage: VoxelVariantTest
+ *
+ *  Tests the voxel variant condition parser and selector without any of the
+ *  rendering code. The tests check that:
+ *
+ *    - Condition lists parse into the required and excluded masks, ignoring
+ *      case and spaces, and unknown names are reported.
+ *    - For every combination of conditions, the selector returns the first
+ *      variant whose required conditions are all met and whose excluded
+ *      conditions are all absent, for the built-in APC water and NoSpawnAlt
+ *      variants after a list of INI variants.
+ *
+ *  Any failed check aborts the tool.
+ *
+ *  This tool is built for the host and has no dependency on Windows.
+ */
+#include "voxelvariant.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+#define VV_CHECK(x) \
+    do { \
+        if (!(x)) { \
+            std::fprintf(stderr, "VoxelVariantTest: Check failed: %s (line %d)\n", #x, __LINE__); \
+            std::abort(); \
+        } \
+    } while (false)
+
+
+/**
+ *  All the conditions, for walking every combination.
+ */
+#define VOXEL_CONDITION_ALL     ((1U << 6) - 1)
+
+
+struct TestVariantStruct
+{
+    unsigned Required;
+    unsigned Excluded;
+};
+
+
+static bool Parse(const char *string, unsigned &required, unsigned &excluded)
+{
+    char buffer[256];
+    std::strncpy(buffer, string, sizeof(buffer));
+    buffer[sizeof(buffer)-1] = '\0';
+    return Parse_Voxel_Conditions(buffer, required, excluded);
+}
+
+
+static void Test_Parse()
+{
+    unsigned required = ~0U;
+    unsigned excluded = ~0U;
+
+    VV_CHECK(Parse("", required, excluded));
+    VV_CHECK(required == VOXEL_CONDITION_NONE && excluded == VOXEL_CONDITION_NONE);
+
+    VV_CHECK(Parse("OnWater,!OnBridge,!Airborne", required, excluded));
+    VV_CHECK(required == VOXEL_CONDITION_ON_WATER);
+    VV_CHECK(excluded == (VOXEL_CONDITION_ON_BRIDGE|VOXEL_CONDITION_AIRBORNE));
+
+    VV_CHECK(Parse("  damaged , !SPAWNSDOCKED,Deployed  ", required, excluded));
+    VV_CHECK(required == (VOXEL_CONDITION_DAMAGED|VOXEL_CONDITION_DEPLOYED));
+    VV_CHECK(excluded == VOXEL_CONDITION_SPAWNS_DOCKED);
+
+    /**
+     *  Empty entries and a lone '!' are skipped.
+     */
+    VV_CHECK(Parse(",,!, OnBridge,", required, excluded));
+    VV_CHECK(required == VOXEL_CONDITION_ON_BRIDGE && excluded == VOXEL_CONDITION_NONE);
+
+    /**
+     *  Unknown names are reported, the known names are still applied.
+     */
+    VV_CHECK(!Parse("OnWater,Flying,!Damaged", required, excluded));
+    VV_CHECK(required == VOXEL_CONDITION_ON_WATER && excluded == VOXEL_CONDITION_DAMAGED);
+
+    VV_CHECK(!Parse("!OnWaterX", required, excluded));
+    VV_CHECK(required == VOXEL_CONDITION_NONE && excluded == VOXEL_CONDITION_NONE);
+
+    std::printf("VoxelVariantTest: Parse passed.\n");
+}
+
+
+/**
+ *  The selection the draw code made before the variants were data driven,
+ *  for an APC with NoSpawnAlt: the water model first, then the no spawns model.
+ */
+static int Reference_Built_In(unsigned conditions)
+{
+    if ((conditions & VOXEL_CONDITION_ON_WATER)
+        && !(conditions & VOXEL_CONDITION_ON_BRIDGE)
+        && !(conditions & VOXEL_CONDITION_AIRBORNE)) {
+        return 0;
+    }
+    if (!(conditions & VOXEL_CONDITION_SPAWNS_DOCKED)) {
+        return 1;
+    }
+    return -1;
+}
+
+
+static void Test_Select()
+{
+    TestVariantStruct variants[8];
+    unsigned required;
+    unsigned excluded;
+
+    VV_CHECK(Select_Voxel_Variant(variants, 0, VOXEL_CONDITION_ALL) == -1);
+
+    /**
+     *  The built-in variants on their own must match the old draw code.
+     */
+    variants[0].Required = VOXEL_CONDITION_ON_WATER;
+    variants[0].Excluded = VOXEL_CONDITION_ON_BRIDGE|VOXEL_CONDITION_AIRBORNE;
+    variants[1].Required = VOXEL_CONDITION_NONE;
+    variants[1].Excluded = VOXEL_CONDITION_SPAWNS_DOCKED;
+
+    for (unsigned conditions = 0; conditions <= VOXEL_CONDITION_ALL; ++conditions) {
+        VV_CHECK(Select_Voxel_Variant(variants, 2, conditions) == Reference_Built_In(conditions));
+    }
+
+    /**
+     *  INI variants come before the built-in variants, so they take priority.
+     */
+    const char *ini_conditions[] = {
+        "Damaged,Deployed",
+        "Deployed,!OnWater",
+        "Damaged,!Airborne",
+    };
+    const int ini_count = int(sizeof(ini_conditions)/sizeof(ini_conditions[0]));
+
+    for (int i = 0; i < ini_count; ++i) {
+        VV_CHECK(Parse(ini_conditions[i], required, excluded));
+        variants[i].Required = required;
+        variants[i].Excluded = excluded;
+    }
+    variants[ini_count+0].Required = VOXEL_CONDITION_ON_WATER;
+    variants[ini_count+0].Excluded = VOXEL_CONDITION_ON_BRIDGE|VOXEL_CONDITION_AIRBORNE;
+    variants[ini_count+1].Required = VOXEL_CONDITION_NONE;
+    variants[ini_count+1].Excluded = VOXEL_CONDITION_SPAWNS_DOCKED;
+
+    const int count = ini_count + 2;
+
+    for (unsigned conditions = 0; conditions <= VOXEL_CONDITION_ALL; ++conditions) {
+
+        bool damaged = (conditions & VOXEL_CONDITION_DAMAGED) != 0;
+        bool deployed = (conditions & VOXEL_CONDITION_DEPLOYED) != 0;
+        bool on_water = (conditions & VOXEL_CONDITION_ON_WATER) != 0;
+        bool airborne = (conditions & VOXEL_CONDITION_AIRBORNE) != 0;
+
+        int expected;
+        if (damaged && deployed) {
+            expected = 0;
+        } else if (deployed && !on_water) {
+            expected = 1;
+        } else if (damaged && !airborne) {
+            expected = 2;
+        } else {
+            int built_in = Reference_Built_In(conditions);
+            expected = (built_in == -1) ? -1 : ini_count + built_in;
+        }
+
+        VV_CHECK(Select_Voxel_Variant(variants, count, conditions) == expected);
+    }
+
+    /**
+     *  A variant with no conditions always matches, hiding those after it.
+     */
+    variants[0].Required = VOXEL_CONDITION_NONE;
+    variants[0].Excluded = VOXEL_CONDITION_NONE;
+    for (unsigned conditions = 0; conditions <= VOXEL_CONDITION_ALL; ++conditions) {
+        VV_CHECK(Select_Voxel_Variant(variants, count, conditions) == 0);
+    }
+
+    std::printf("VoxelVariantTest: Select passed.\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    Test_Parse();
+    Test_Select();
+
+    std::printf("VoxelVariantTest: All tests passed.\n");
+
+    return EXIT_SUCCESS;
+}